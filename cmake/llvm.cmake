@@ -3,7 +3,15 @@ include_guard()
 nonnull(LUCE_USE_LLVM)
 
 if(LUCE_USE_LLVM)
-  find_package(LLVM REQUIRED CONFIG)
+  find_package(LLVM CONFIG QUIET)
+
+  if(NOT LLVM_FOUND)
+    message(WARNING "LLVM not found; building without the optimizing jit tier.")
+  endif()
+endif()
+
+if(LUCE_USE_LLVM AND LLVM_FOUND)
+  message(STATUS "Found LLVM ${LLVM_PACKAGE_VERSION}: ${LLVM_DIR}")
 
   list(APPEND CMAKE_MODULE_PATH ${LLVM_CMAKE_DIR})
 
@@ -32,6 +40,8 @@ if(LUCE_USE_LLVM)
       X86Disassembler
 
       # Common Components
+      native
+      Core
       IRReader
       MC
       MCParser
@@ -46,9 +56,12 @@ if(LUCE_USE_LLVM)
       BitReader
       AsmParser
     )
-    target_include_directories(${PENDING_TARGET} PUBLIC
+    target_include_directories(${PENDING_TARGET} SYSTEM PUBLIC
       ${LLVM_INCLUDE_DIRS}
     )
+    target_compile_definitions(${PENDING_TARGET} PUBLIC
+      LUCE_HAS_LLVM=1
+    )
     target_link_libraries(${PENDING_TARGET}
       PUBLIC
       ${llvm_libs}
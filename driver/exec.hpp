@@ -53,9 +53,14 @@ class ExecutionContext {
   }
   void initDisasm() {
     this->disassembler = std::make_unique<isa::Disassembler>();
-    disassembler->initializeDefault()
-        .addDecoder(std::make_unique<isa::instruction::multiply::Decoder>())
-        .addDecoder(std::make_unique<isa::instruction::atomic::Decoder>());
+    disassembler->initializeDefault();
+    // whatever the build left out of the decode table is not registered
+    if constexpr (LUCE_EXTENSION_M)
+      disassembler->addDecoder(
+          std::make_unique<isa::instruction::multiply::Decoder>());
+    if constexpr (LUCE_EXTENSION_A)
+      disassembler->addDecoder(
+          std::make_unique<isa::instruction::atomic::Decoder>());
   }
 
 public:
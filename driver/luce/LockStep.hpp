@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <fmt/format.h>
+#include <accat/auxilia/auxilia.hpp>
+
+#include "luce/Support/isa/architecture.hpp"
+
+namespace accat::luce {
+class Monitor;
+// lock-step -- replays every dispatch of the selected engine on a shadow
+// monitor, which steps the same instructions through the reference path
+// (`CentralProcessingUnit::decode_and_execute`) on its own copy of the
+// registers and memory. after each dispatch the two have to agree on the pc,
+// the registers, the task and every page either of them wrote; the first
+// dispatch they do not is reported, disassembled, as an error.
+// resides in the monitor, no need to mark it as a component
+class LockStep {
+public:
+  using vaddr_t = isa::virtual_address_t;
+  enum class Granularity : uint8_t {
+    /// compare after each dispatch, as the engine runs it
+    kBlock = 0,
+    /// dispatch one instruction at a time
+    kInstruction,
+  };
+  struct Statistics {
+    uint64_t dispatches = 0;
+    uint64_t instructions = 0;
+    uint64_t pages = 0;
+  };
+
+public:
+  LockStep(Monitor &, Granularity);
+  LockStep(const LockStep &) = delete;
+  LockStep &operator=(const LockStep &) = delete;
+  ~LockStep();
+
+public:
+  /// @brief start the shadow over from the state of the monitor, as it is.
+  [[clang::reinitializes]] auto reset() -> LockStep &;
+  /// @brief in front of a dispatch: take up what the monitor did to the task
+  /// in between(resume, pause).
+  auto prepare() -> LockStep &;
+  /// @brief replay the @p retired instructions the monitor just dispatched
+  /// and compare.
+  auto check(size_t retired) -> auxilia::Status;
+  constexpr auto granularity() const noexcept {
+    return granularity_;
+  }
+  auto statistics() const noexcept -> const Statistics & {
+    return statistics_;
+  }
+  auto to_string() const -> std::string {
+    return fmt::format("lockstep: {} dispatches, {} instructions, {} pages "
+                       "compared",
+                       statistics_.dispatches,
+                       statistics_.instructions,
+                       statistics_.pages);
+  }
+
+private:
+  /// @return what differs between the monitor and the shadow; empty if
+  /// nothing.
+  auto compare(bool everything) -> std::vector<std::string>;
+  auto disassemble(vaddr_t pc) const -> std::string;
+
+private:
+  Monitor &monitor_;
+  std::unique_ptr<Monitor> shadow_;
+  Granularity granularity_;
+  /// where the shadow stepped through in the last dispatch, the latest
+  /// instructions only
+  std::vector<vaddr_t> trail_;
+  Statistics statistics_;
+};
+} // namespace accat::luce
@@ -72,21 +72,31 @@ public:
   auto addressof(const size_t offset) const {
     return isa::physical_base_address + offset;
   }
-  template <typename... Args>
-  bool is_in_range(isa::physical_address_t addr, Args... addrs) const noexcept
-    requires(std::convertible_to<Args, isa::physical_address_t> && ...)
-  {
-    if constexpr (sizeof...(Args) == 0)
-      return addr >= isa::physical_memory_begin &&
-             addr < isa::physical_memory_end;
-    else // warning `unreachable code` if not using `else`
-      return (is_in_range(addr) && ... && is_in_range(addrs));
+  /// @brief whether @p addr is a byte of the memory, the last one included.
+  /// @note the one definition of "in range": the fast path of the cpu and the
+  /// bounds the jits emit agree with it.
+  bool is_in_range(const isa::physical_address_t addr) const noexcept {
+    return addr >= isa::physical_memory_begin &&
+           addr <= isa::physical_memory_end;
+  }
+  /// @brief whether all of [@p begin, @p end) is memory.
+  bool is_in_range(const isa::physical_address_t begin,
+                   const isa::physical_address_t end) const noexcept {
+    return begin >= isa::physical_memory_begin && begin <= end &&
+           end - isa::physical_memory_begin <= isa::physical_memory_size;
   }
 };
 class Monitor;
 class LUCE_API MainMemory : public Component {
 
   MemoryAccess memory;
+  /// writes so far; see `writes`
+  uint64_t writes_ = 0;
+  /// per page, whether it was written since `take_dirty`; empty unless
+  /// tracking
+  std::vector<bool> dirty_;
+  /// the pages set in `dirty_`
+  std::vector<size_t> dirty_pages_;
 
 private:
   auto monitor() const noexcept -> Monitor *;
@@ -119,6 +129,45 @@ public:
   auto write_n(isa::physical_address_t,
                size_t,
                std::span<const std::byte>) noexcept -> auxilia::Status;
+  /// @brief writes so far through the functions above, plus the ones the jit
+  /// made through `host_base` and counted in.
+  auto writes() const noexcept -> uint64_t {
+    return writes_;
+  }
+  /// @brief count in @p count writes made through `host_base`.
+  auto count_writes(const uint64_t count) noexcept -> MainMemory & {
+    writes_ += count;
+    return *this;
+  }
+  /// @brief host address of `physical_memory_begin`.
+  /// @attention writes through it skip the reservation, dirty page and cache
+  /// bookkeeping of the other write functions; only for the jit, which leaves
+  /// every store to them while a reservation is held or `tracking_dirty`, and
+  /// counts the rest in.
+  auto host_base() noexcept -> std::byte * {
+    return memory.data();
+  }
+  /// @brief write @p value at @p addr, which the caller made sure is in
+  /// range; the bookkeeping of the functions above, without a status.
+  auto write_unchecked(const isa::physical_address_t addr,
+                       const std::span<const std::byte> value) noexcept {
+    _write_unchecked(addr, value);
+  }
+  /// @brief note the pages the functions above write from now on, or stop.
+  auto track_dirty(bool) -> MainMemory &;
+  auto tracking_dirty() const noexcept -> bool {
+    return !dirty_.empty();
+  }
+  /// @return the indices of the pages written since the last call, in no
+  /// particular order; each page once.
+  auto take_dirty() -> std::vector<size_t>;
+  /// @brief bytes of page @p index, the last one maybe short.
+  auto page(size_t index) const noexcept -> std::span<const std::byte>;
+  auto page_count() const noexcept -> size_t {
+    return (memory.size() + isa::page_size - 1) / isa::page_size;
+  }
+  /// @brief make every byte the same as in @p other, bookkeeping aside.
+  auto mirror(const MainMemory &) noexcept -> MainMemory &;
   auto write_word(const isa::physical_address_t addr,
                   const isa::Word value) noexcept {
     return write_typed(addr, value.num());
@@ -1,10 +1,12 @@
 ﻿#pragma once
 
+#include <chrono>
 #include <cstddef>
 #include <functional>
 #include <iostream>
 #include <ranges>
 #include <span>
+#include <string_view>
 #include <type_traits>
 #include <utility>
 #include <spdlog/spdlog.h>
@@ -25,6 +27,7 @@ namespace accat::luce::isa {
 class IDisassembler;
 }
 namespace accat::luce {
+class LockStep;
 namespace message::repl {
 using namespace std::literals;
 using namespace fmt::literals;
@@ -52,7 +55,41 @@ static const inline auto Welcome =
     Type 'exit' to  exit.
 )"_raw);
 } // namespace message::repl
+/// why `Monitor::resume` returned
+enum class ExitReason : uint8_t {
+  kNone = 0,
+  /// the program called `exit`
+  kExited,
+  /// a trap, an `ebreak` or a watchpoint paused the task
+  kPaused,
+  kInstructionLimit,
+  kTimeout,
+  /// the hart spins where nothing may ever wake it, with no limit to run to
+  kIdle,
+  /// the engine reported an error
+  kError,
+};
+constexpr auto to_string(const ExitReason reason) noexcept -> std::string_view {
+  switch (reason) {
+  case ExitReason::kNone:
+    return "none";
+  case ExitReason::kExited:
+    return "exited";
+  case ExitReason::kPaused:
+    return "paused";
+  case ExitReason::kInstructionLimit:
+    return "instruction-limit";
+  case ExitReason::kTimeout:
+    return "timeout";
+  case ExitReason::kIdle:
+    return "idle";
+  case ExitReason::kError:
+    return "error";
+  }
+  return "unknown";
+}
 class Monitor : public Mediator {
+  friend class LockStep;
   using paddr_t = isa::physical_address_t;
   using vaddr_t = isa::virtual_address_t;
 
@@ -64,9 +101,38 @@ class Monitor : public Mediator {
   Timer timer;
   std::shared_ptr<isa::IDisassembler> disassembler_;
   repl::Debugger debugger_;
+  /// 0 for no limit
+  size_t max_instructions_ = 0;
+  /// zero for no limit
+  std::chrono::duration<double> timeout_{};
+  /// replays the dispatches through the reference path, if validating
+  std::unique_ptr<LockStep> lockstep_;
+
+public:
+  /// @brief how the last `resume` went.
+  struct RunReport {
+    ExitReason reason = ExitReason::kNone;
+    uint64_t instructions = 0;
+    std::chrono::duration<double> elapsed{};
+  };
+
+private:
+  RunReport report_;
+  /// what `resume` knows of the hart spinning
+  struct IdleWatch {
+    /// writes to memory plus syscalls, as of the last dispatch
+    uint64_t effects = 0;
+    /// instructions retired since `effects` last changed
+    uint64_t quiet = 0;
+    /// quiet instructions that make the hart worth a probe
+    uint64_t threshold = 0;
+  } idle_;
+  /// dispatches in a row that retired nothing
+  size_t empty_dispatches_ = 0;
 
 public:
   explicit Monitor(std::unique_ptr<isa::IDisassembler> &&);
+  explicit Monitor(std::shared_ptr<isa::IDisassembler>);
   virtual ~Monitor() override;
   auto &debugger(this auto &&self) noexcept {
     return self.debugger_;
@@ -95,6 +161,18 @@ public:
   auxilia::Status REPL();
   auxilia::Status resume();
   auxilia::Status execute_n(size_t);
+  auxilia::Status select_engine(std::string_view);
+  auxilia::Status set_jit_threshold(std::string_view);
+  auxilia::Status set_instruction_limit(std::string_view);
+  auxilia::Status set_timeout(std::string_view);
+  auxilia::Status set_trace(std::string_view);
+  auxilia::Status set_icount(std::string_view);
+  auxilia::Status set_lockstep(std::string_view);
+  auxilia::Status set_hle(std::string_view);
+  auxilia::Status set_cache_dir(std::string_view);
+  auto report() const noexcept -> const RunReport & {
+    return report_;
+  }
   auto register_task(const std::ranges::range auto &, paddr_t, paddr_t)
       -> auxilia::Status;
 
@@ -102,6 +180,12 @@ private:
   auto _do_register_task_unchecked(std::span<const std::byte>, paddr_t, paddr_t)
       -> auxilia::Status;
   auto _do_execute_n_unchecked(size_t) -> auxilia::Status;
+  auto _do_dispatch_unchecked(size_t) -> auxilia::StatusOr<size_t>;
+  /// @brief step the hart for a while, looking for a loop it never leaves.
+  auto _do_probe_idle_unchecked() -> auxilia::StatusOr<bool>;
+  auto _effects() const noexcept -> uint64_t {
+    return memory_.writes() + cpus_.syscalls();
+  }
 };
 auxilia::Status Monitor::register_task(const std::ranges::range auto &program,
                                        const paddr_t start_addr,
@@ -123,7 +207,9 @@ auxilia::Status Monitor::register_task(const std::ranges::range auto &program,
 
   contract_assert(bytes.size() > 0 && bytes.size() <= block_size,
                   "Invalid block size")
-  contract_assert(start_addr + bytes.size() <= isa::physical_memory_end,
+  contract_assert(start_addr >= isa::physical_memory_begin &&
+                      start_addr - isa::physical_memory_begin + bytes.size() <=
+                          isa::physical_memory_size,
                   "Out of memory bounds")
   // add `this` for intellisenese (template intellisense was too poor)
   return this->_do_register_task_unchecked(bytes, start_addr, block_size);
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <type_traits>
+
+// clang-format off
+/// rv32i, as the base decoder knows it, plus `wfi` and `csrrs`, which reads
+/// the counters(`rdcycle`, `rdtime`, `rdinstret`)
+#define LUCE_ISA_BASE_LIST(X)                                                  \
+  X(Add) X(Sub) X(Xor) X(Or) X(And) X(Sll) X(Srl) X(Sra) X(Slt) X(Sltu)        \
+  X(Addi) X(Xori) X(Ori) X(Andi) X(Slli) X(Srli) X(Srai) X(Slti) X(Sltiu)      \
+  X(Lb) X(Lh) X(Lw) X(Lbu) X(Lhu)                                              \
+  X(Sb) X(Sh) X(Sw)                                                            \
+  X(Beq) X(Bne) X(Blt) X(Bge) X(Bltu) X(Bgeu)                                  \
+  X(Jal) X(Jalr) X(Lui) X(Auipc)                                               \
+  X(Ecall) X(Ebreak) X(Wfi) X(Csrrs)
+/// rv32m
+#define LUCE_ISA_MULTIPLY_LIST(X)                                              \
+  X(Mul) X(Mulh) X(Mulsu) X(Mulu) X(Div) X(Divu) X(Rem) X(Remu)
+/// rv32a; prefixed since the instruction classes reuse the base names
+#define LUCE_ISA_ATOMIC_LIST(X)                                                \
+  X(Lr) X(Sc) X(AmoSwap) X(AmoAdd) X(AmoAnd) X(AmoOr) X(AmoXor) X(AmoMax)      \
+  X(AmoMin)
+// clang-format on
+
+namespace accat::luce::isa {
+/// bumped whenever a decoder changes what it puts into the fields of a
+/// descriptor; descriptors kept from an older version mean something else
+inline constexpr uint32_t descriptor_version = 1;
+/// @brief what a decoder makes of an instruction word: trivially copyable, no
+/// heap and no vtable. `IInstruction` remains for display(disassembly, REPL).
+struct Descriptor {
+  enum class Id : uint8_t {
+    /// no decoder knows the word
+    kInvalid = 0,
+#define LUCE_ISA_DESCRIPTOR_ID(_name_) k##_name_,
+    LUCE_ISA_BASE_LIST(LUCE_ISA_DESCRIPTOR_ID)
+    LUCE_ISA_MULTIPLY_LIST(LUCE_ISA_DESCRIPTOR_ID)
+    LUCE_ISA_ATOMIC_LIST(LUCE_ISA_DESCRIPTOR_ID)
+#undef LUCE_ISA_DESCRIPTOR_ID
+  };
+  Id id = Id::kInvalid;
+  /// fields the format of the instruction lacks stay 0
+  uint8_t rd = 0;
+  uint8_t rs1 = 0;
+  uint8_t rs2 = 0;
+  /// sign-extended; already shifted for `lui`/`auipc`, masked for shifts
+  uint32_t imm = 0;
+
+  constexpr explicit operator bool() const noexcept {
+    return id != Id::kInvalid;
+  }
+  constexpr bool operator==(const Descriptor &) const noexcept = default;
+};
+static_assert(std::is_trivially_copyable_v<Descriptor>,
+              "descriptors are meant to be passed around by value");
+static_assert(sizeof(Descriptor) == 8, "descriptors are meant to stay compact");
+} // namespace accat::luce::isa
@@ -1,9 +1,13 @@
 #pragma once
 #include <memory>
 #include "IInstruction.hpp"
+#include "Descriptor.hpp"
 namespace accat::luce::isa {
 struct IDecoder {
   virtual auto decode(uint32_t) -> std::unique_ptr<IInstruction> = 0;
+  /// @brief decode without allocating.
+  /// @return an invalid descriptor if the word is not for this decoder
+  virtual auto describe(uint32_t) const noexcept -> Descriptor = 0;
   virtual ~IDecoder() = default;
 };
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 #include <vector>
 #include <memory>
+#include <span>
 
 #include "IInstruction.hpp"
 #include "IDecoder.hpp"
@@ -13,7 +14,7 @@ protected:
   std::vector<std::unique_ptr<IDecoder>> decoders;
 
 public:
-  auto disassemble(uint32_t num) -> std::unique_ptr<IInstruction> {
+  virtual auto disassemble(uint32_t num) -> std::unique_ptr<IInstruction> {
     contract_assert(initialized_, "Disassembler not initialized");
     for (auto &decoder : decoders)
       if (auto instr = decoder->decode(num))
@@ -21,9 +22,27 @@ public:
 
     return nullptr;
   };
+  /// @brief decode @p num into a descriptor; no heap, for the execution
+  /// engines. disassemble() remains for display.
+  virtual auto describe(uint32_t num) const -> Descriptor {
+    contract_assert(initialized_, "Disassembler not initialized");
+    for (const auto &decoder : decoders)
+      if (const auto descriptor = decoder->describe(num))
+        return descriptor;
+
+    return {};
+  }
+  /// @brief `describe` every word of @p words into @p out, as many; an ISA
+  /// may do a batch faster than one by one.
+  virtual auto describe_n(const std::span<const uint32_t> words,
+                          const std::span<Descriptor> out) const -> void {
+    for (size_t i = 0; i < words.size(); ++i)
+      out[i] = describe(words[i]);
+  }
   auto addDecoder(std::unique_ptr<IDecoder> decoder) -> IDisassembler & {
     dbg(info, "Adding decoder: {}", typeid(*decoder).name());
     decoders.emplace_back(std::move(decoder));
+    registered(*decoders.back());
     return *this;
   }
 
@@ -42,6 +61,10 @@ public:
     return initialized_;
   }
 
+protected:
+  /// @brief lets an ISA index the decoders as they are added.
+  virtual auto registered(IDecoder &) -> void {}
+
 private:
   virtual auto initializeDefaultImpl() -> IDisassembler & = 0;
   bool initialized_ = false;
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <span>
 #include <accat/auxilia/auxilia.hpp>
 #include "luce/Support/utils/Pattern.hpp"
 #include "luce/Support/isa/Word.hpp"
@@ -10,6 +14,9 @@
 namespace accat::luce {
 class Context;
 class Task;
+namespace hle {
+struct Binding;
+}
 } // namespace accat::luce
 namespace accat::luce::isa {
 class Icpu : public Component {
@@ -21,11 +28,53 @@ public:
     kRunning,
     /// finished running the program
   };
+  enum class Engine : uint8_t {
+    /// fetch, decode and execute one instruction per dispatch
+    kStep = 0,
+    /// execute a whole cached basic block per dispatch
+    kBlock,
+    /// run lowered records through direct-threaded dispatch until something
+    /// needs the reference path
+    kThreaded,
+    /// run basic blocks that turned hot as native code, the block engine
+    /// otherwise
+    kJit,
+    /// run the blocks `luce-aot` translated at build time, the block engine
+    /// otherwise
+    kAot,
+  };
+  /// @brief how a cpu runs its tasks; handed over whole, before a task
+  /// starts.
+  struct Options {
+    Engine engine = Engine::kStep;
+    /// executions of a basic block before the jit compiles it
+    size_t jit_threshold = 16;
+    /// guest time per retired instruction, as a power of two of nanoseconds;
+    /// none for the host clock, which no two runs agree on
+    std::optional<uint8_t> icount_shift;
+    /// whether the pc and the instruction register may go stale inside a
+    /// dispatch, written only where someone can look: instructions reading
+    /// the pc, traps and the way out. off while a debugger may stop in
+    /// between.
+    bool lazy_state = false;
+    /// whether the cpu replays another one; nothing it does reaches the host
+    bool shadow = false;
+    /// where what a run learned about its image is kept for the next; empty
+    /// keeps nothing
+    std::filesystem::path cache_dir;
+  };
 
 protected:
   using vaddr_t = isa::virtual_address_t;
   using paddr_t = isa::physical_address_t;
   State state_ = State::kVacant;
+  /// guest memory the cpu reaches without asking: `window_size_` bytes from
+  /// virtual address `window_begin_`, at host address `window_`; empty until
+  /// a task is attached. here rather than in an implementation, since the
+  /// instructions load and store through it and know only the interface.
+  std::byte *window_ = nullptr;
+  vaddr_t window_begin_ = 0;
+  size_t window_size_ = 0;
 
 public:
   Icpu(Mediator *parent = nullptr) : Component(parent) {}
@@ -43,14 +92,69 @@ public:
   virtual auto pc() noexcept [[clang::lifetimebound]] -> isa::Word & = 0;
   virtual auto gpr() noexcept [[clang::lifetimebound]]
   -> isa::GeneralPurposeRegisters & = 0;
-  virtual auto switch_task(Task *) noexcept [[clang::lifetimebound]]
+  virtual auto switch_task(Task *) [[clang::lifetimebound]]
   -> Icpu & = 0;
   virtual auto atomic_address() noexcept [[clang::lifetimebound]]
   -> std::optional<vaddr_t> & = 0;
   virtual auxilia::Status execute_shuttle() = 0;
+  /// @brief run one dispatch unit of the selected engine, retiring at most
+  /// @p budget instructions.
+  /// @return the number of instructions retired
+  virtual auto dispatch(size_t budget) -> auxilia::StatusOr<size_t> = 0;
   virtual auxilia::Status handle_syscall() = 0; 
+  /// drop everything the cpu derived from guest memory in [addr, addr + size)
+  virtual auto invalidate(vaddr_t, size_t) noexcept -> Icpu & = 0;
+  virtual auto statistics() const -> std::string = 0;
+  /// @brief store @p bytes at @p addr, which the caller made sure is in the
+  /// window, minding whatever the cpu derived from it.
+  virtual auto store_unchecked(vaddr_t addr, std::span<const std::byte> bytes)
+      noexcept -> void = 0;
+  /// @brief run the guest routines @p bindings name as host code, from the
+  /// next task on.
+  virtual auto bind_routines(std::span<const hle::Binding> bindings)
+      -> Icpu & = 0;
+  virtual auto routines() const noexcept -> std::span<const hle::Binding> = 0;
+  /// @brief keep what the task taught the cpu in the cache directory of its
+  /// options, for the next run of the same image.
+  virtual auto persist() -> auxilia::Status = 0;
+  /// @brief take up @p options for the tasks from now on.
+  /// @pre no task is running.
+  virtual auto configure(const Options &options) -> Icpu & = 0;
+  virtual auto options() const noexcept -> const Options & = 0;
+  /// environment calls handled so far; each may reach the outside world
+  virtual auto syscalls() const noexcept -> uint64_t = 0;
+  /// instructions retired since the task started
+  virtual auto instret() const noexcept -> uint64_t = 0;
+  /// @brief guest time since the task started, in nanoseconds.
+  virtual auto time() const noexcept -> uint64_t = 0;
+  /// @brief one instruction a cycle under icount, the time otherwise.
+  virtual auto cycles() const noexcept -> uint64_t = 0;
 
 public:
+  /// @brief the fast path of loads: a plain copy out of the window, no status
+  /// to build or check.
+  /// @return false on a fault, which the instruction raises.
+  template <typename T>
+  AC_FORCEINLINE auto load(const vaddr_t addr, T &value) const noexcept
+      -> bool {
+    const auto offset = static_cast<size_t>(addr - window_begin_);
+    if (offset >= window_size_ || window_size_ - offset < sizeof(T))
+        [[unlikely]]
+      return false;
+    std::memcpy(&value, window_ + offset, sizeof(T));
+    return true;
+  }
+  /// @brief the fast path of stores; see `load`.
+  template <typename T>
+  AC_FORCEINLINE auto store(const vaddr_t addr, const T value) noexcept
+      -> bool {
+    const auto offset = static_cast<size_t>(addr - window_begin_);
+    if (offset >= window_size_ || window_size_ - offset < sizeof(T))
+        [[unlikely]]
+      return false;
+    store_unchecked(addr, std::as_bytes(std::span{&value, 1}));
+    return true;
+  }
   constexpr auto is_vacant() const noexcept {
     return state_ == State::kVacant;
   }
@@ -8,4 +8,13 @@
 #  endif
 #else
 #  define LUCE_SUPPORT_ISA_API
-#endif
\ No newline at end of file
+#endif
+
+// set by the build: 0 leaves the extension out of the decode table and out of
+// the dispatch of every engine, for profiles that never run it.
+#ifndef LUCE_EXTENSION_M
+#  define LUCE_EXTENSION_M 1
+#endif
+#ifndef LUCE_EXTENSION_A
+#  define LUCE_EXTENSION_A 1
+#endif
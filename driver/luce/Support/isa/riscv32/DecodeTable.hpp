@@ -0,0 +1,321 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+
+#include "luce/Support/isa/Descriptor.hpp"
+#include "luce/Support/isa/IDecoder.hpp"
+#include "luce/Support/isa/config.hpp"
+#include "luce/Support/isa/riscv32/instruction/details/describe.hpp"
+
+namespace accat::luce::isa::riscv32 {
+enum class Extension : uint8_t {
+  kBase = 0,
+  kMultiply,
+  kAtomic,
+};
+inline constexpr size_t extension_count = 3;
+/// bit `1 << extension` per enabled extension
+using ExtensionSet = uint32_t;
+constexpr auto set_of(const Extension extension) noexcept -> ExtensionSet {
+  return ExtensionSet{1} << static_cast<uint8_t>(extension);
+}
+/// the extensions this build has at all; the table holds no other encodings
+inline constexpr ExtensionSet compiled_extensions =
+    set_of(Extension::kBase) |
+    (LUCE_EXTENSION_M ? set_of(Extension::kMultiply) : 0) |
+    (LUCE_EXTENSION_A ? set_of(Extension::kAtomic) : 0);
+/// how the fields of an encoding are laid out
+enum class Format : uint8_t {
+  kR,
+  kI,
+  /// I-type whose immediate carries a shift amount
+  kIShift,
+  kS,
+  kB,
+  /// U-type, immediate shifted into place
+  kU,
+  kJ,
+  kAR,
+};
+/// one row of the table: the word is `id` iff `(word & mask) == match`.
+struct Encoding {
+  Descriptor::Id id;
+  Extension extension;
+  Format format;
+  uint32_t mask;
+  uint32_t match;
+};
+namespace encoding {
+inline constexpr uint32_t kOpcode = 0x0000'007F;
+inline constexpr uint32_t kFunct3 = 0x0000'707F;
+inline constexpr uint32_t kFunct7 = 0xFE00'707F;
+inline constexpr uint32_t kFunct5 = 0xF800'707F;
+inline constexpr uint32_t kFunct12 = 0xFFF0'707F;
+constexpr auto funct7(const uint32_t f7,
+                      const uint32_t f3,
+                      const uint32_t op) noexcept {
+  return f7 << 25 | f3 << 12 | op;
+}
+constexpr auto funct3(const uint32_t f3, const uint32_t op) noexcept {
+  return f3 << 12 | op;
+}
+constexpr auto funct5(const uint32_t f5, const uint32_t op) noexcept {
+  return f5 << 27 | 0x2u << 12 | op;
+}
+// clang-format off
+#define LUCE_ENCODING(_name_, _ext_, _fmt_, _mask_, _match_)                   \
+  Encoding{Descriptor::Id::k##_name_, Extension::k##_ext_, Format::k##_fmt_,   \
+           _mask_, _match_}
+/// rv32i; what the base decoder used to check, bit for bit
+inline constexpr std::array base{
+  LUCE_ENCODING(Add,   Base, R, kFunct7, funct7(0x00, 0x0, 0x33)),
+  LUCE_ENCODING(Sub,   Base, R, kFunct7, funct7(0x20, 0x0, 0x33)),
+  LUCE_ENCODING(Xor,   Base, R, kFunct7, funct7(0x00, 0x4, 0x33)),
+  LUCE_ENCODING(Or,    Base, R, kFunct7, funct7(0x00, 0x6, 0x33)),
+  LUCE_ENCODING(And,   Base, R, kFunct7, funct7(0x00, 0x7, 0x33)),
+  LUCE_ENCODING(Sll,   Base, R, kFunct7, funct7(0x00, 0x1, 0x33)),
+  LUCE_ENCODING(Srl,   Base, R, kFunct7, funct7(0x00, 0x5, 0x33)),
+  LUCE_ENCODING(Sra,   Base, R, kFunct7, funct7(0x20, 0x5, 0x33)),
+  LUCE_ENCODING(Slt,   Base, R, kFunct7, funct7(0x00, 0x2, 0x33)),
+  LUCE_ENCODING(Sltu,  Base, R, kFunct7, funct7(0x00, 0x3, 0x33)),
+  LUCE_ENCODING(Addi,  Base, I, kFunct3, funct3(0x0, 0x13)),
+  LUCE_ENCODING(Xori,  Base, I, kFunct3, funct3(0x4, 0x13)),
+  LUCE_ENCODING(Ori,   Base, I, kFunct3, funct3(0x6, 0x13)),
+  LUCE_ENCODING(Andi,  Base, I, kFunct3, funct3(0x7, 0x13)),
+  LUCE_ENCODING(Slli,  Base, IShift, kFunct7, funct7(0x00, 0x1, 0x13)),
+  LUCE_ENCODING(Srli,  Base, IShift, kFunct7, funct7(0x00, 0x5, 0x13)),
+  LUCE_ENCODING(Srai,  Base, IShift, kFunct7, funct7(0x20, 0x5, 0x13)),
+  LUCE_ENCODING(Slti,  Base, I, kFunct3, funct3(0x2, 0x13)),
+  LUCE_ENCODING(Sltiu, Base, I, kFunct3, funct3(0x3, 0x13)),
+  LUCE_ENCODING(Lb,    Base, I, kFunct3, funct3(0x0, 0x03)),
+  LUCE_ENCODING(Lh,    Base, I, kFunct3, funct3(0x1, 0x03)),
+  LUCE_ENCODING(Lw,    Base, I, kFunct3, funct3(0x2, 0x03)),
+  LUCE_ENCODING(Lbu,   Base, I, kFunct3, funct3(0x4, 0x03)),
+  LUCE_ENCODING(Lhu,   Base, I, kFunct3, funct3(0x5, 0x03)),
+  LUCE_ENCODING(Sb,    Base, S, kFunct3, funct3(0x0, 0x23)),
+  LUCE_ENCODING(Sh,    Base, S, kFunct3, funct3(0x1, 0x23)),
+  LUCE_ENCODING(Sw,    Base, S, kFunct3, funct3(0x2, 0x23)),
+  LUCE_ENCODING(Beq,   Base, B, kFunct3, funct3(0x0, 0x63)),
+  LUCE_ENCODING(Bne,   Base, B, kFunct3, funct3(0x1, 0x63)),
+  LUCE_ENCODING(Blt,   Base, B, kFunct3, funct3(0x4, 0x63)),
+  LUCE_ENCODING(Bge,   Base, B, kFunct3, funct3(0x5, 0x63)),
+  LUCE_ENCODING(Bltu,  Base, B, kFunct3, funct3(0x6, 0x63)),
+  LUCE_ENCODING(Bgeu,  Base, B, kFunct3, funct3(0x7, 0x63)),
+  LUCE_ENCODING(Jal,   Base, J, kOpcode, 0x6F),
+  LUCE_ENCODING(Jalr,  Base, I, kFunct3, funct3(0x0, 0x67)),
+  LUCE_ENCODING(Lui,   Base, U, kOpcode, 0x37),
+  LUCE_ENCODING(Auipc, Base, U, kOpcode, 0x17),
+  LUCE_ENCODING(Ecall, Base, I, kFunct12, 0x0000'0073),
+  LUCE_ENCODING(Ebreak,Base, I, kFunct12, 0x0010'0073),
+  LUCE_ENCODING(Wfi,   Base, I, kFunct12, 0x1050'0073),
+  LUCE_ENCODING(Csrrs, Base, I, kFunct3, funct3(0x2, 0x73)),
+};
+/// rv32m
+inline constexpr std::array multiply{
+  LUCE_ENCODING(Mul,   Multiply, R, kFunct7, funct7(0x01, 0x0, 0x33)),
+  LUCE_ENCODING(Mulh,  Multiply, R, kFunct7, funct7(0x01, 0x1, 0x33)),
+  LUCE_ENCODING(Mulsu, Multiply, R, kFunct7, funct7(0x01, 0x2, 0x33)),
+  LUCE_ENCODING(Mulu,  Multiply, R, kFunct7, funct7(0x01, 0x3, 0x33)),
+  LUCE_ENCODING(Div,   Multiply, R, kFunct7, funct7(0x01, 0x4, 0x33)),
+  LUCE_ENCODING(Divu,  Multiply, R, kFunct7, funct7(0x01, 0x5, 0x33)),
+  LUCE_ENCODING(Rem,   Multiply, R, kFunct7, funct7(0x01, 0x6, 0x33)),
+  LUCE_ENCODING(Remu,  Multiply, R, kFunct7, funct7(0x01, 0x7, 0x33)),
+};
+/// rv32a; aq and rl are left to the instruction
+inline constexpr std::array atomic{
+  LUCE_ENCODING(Lr,      Atomic, AR, kFunct5, funct5(0x02, 0x2F)),
+  LUCE_ENCODING(Sc,      Atomic, AR, kFunct5, funct5(0x03, 0x2F)),
+  LUCE_ENCODING(AmoSwap, Atomic, AR, kFunct5, funct5(0x01, 0x2F)),
+  LUCE_ENCODING(AmoAdd,  Atomic, AR, kFunct5, funct5(0x00, 0x2F)),
+  LUCE_ENCODING(AmoAnd,  Atomic, AR, kFunct5, funct5(0x0C, 0x2F)),
+  LUCE_ENCODING(AmoOr,   Atomic, AR, kFunct5, funct5(0x0A, 0x2F)),
+  LUCE_ENCODING(AmoXor,  Atomic, AR, kFunct5, funct5(0x04, 0x2F)),
+  LUCE_ENCODING(AmoMax,  Atomic, AR, kFunct5, funct5(0x14, 0x2F)),
+  LUCE_ENCODING(AmoMin,  Atomic, AR, kFunct5, funct5(0x10, 0x2F)),
+};
+#undef LUCE_ENCODING
+/// major opcodes whose funct3 alone does not tell encodings apart, and the
+/// field that does: [shift, shift + width)
+struct Field {
+  uint32_t opcode;
+  uint8_t shift;
+  uint8_t width;
+};
+inline constexpr std::array fields{
+  Field{0x33, 25, 7}, // OP: funct7
+  Field{0x13, 25, 7}, // OP-IMM: imm[11:5] of the shifts
+  Field{0x2F, 27, 5}, // AMO: funct5
+  Field{0x73, 20, 5}, // SYSTEM: imm[4:0]
+};
+// clang-format on
+template <typename Visitor> constexpr auto for_each(Visitor &&visitor) {
+  for (const auto &e : base)
+    visitor(e);
+  if constexpr (LUCE_EXTENSION_M)
+    for (const auto &e : multiply)
+      visitor(e);
+  if constexpr (LUCE_EXTENSION_A)
+    for (const auto &e : atomic)
+      visitor(e);
+}
+constexpr auto row_of(const uint32_t num) noexcept {
+  return (num & kOpcode) >> 2;
+}
+constexpr auto field_of(const uint32_t opcode) noexcept {
+  for (const auto &field : fields)
+    if (field.opcode == opcode)
+      return field;
+  return Field{opcode, 0, 0};
+}
+/// cells the rows take; the first 8 stay invalid for unknown opcodes
+consteval auto cell_count() {
+  std::array<bool, 32> used{};
+  size_t count = 8;
+  for_each([&](const Encoding &e) {
+    const auto opcode = e.match & kOpcode;
+    if (!std::exchange(used[row_of(opcode)], true))
+      count += size_t{8} << field_of(opcode).width;
+  });
+  return count;
+}
+} // namespace encoding
+
+// decode table -- every encoding of every extension, folded at compile time
+// into two levels: the major opcode picks a row, funct3 plus the field of that
+// row pick the cell. a cell holds the only encoding that may match, which a
+// mask check then confirms. adding an extension adds rows or cells, never
+// lookups; overlapping encodings fail to compile.
+class DecodeTable {
+  struct Row {
+    uint16_t offset = 0;
+    uint8_t shift = 0;
+    uint8_t width = 0;
+  };
+  static constexpr size_t id_count =
+      static_cast<size_t>(Descriptor::Id::kAmoMin) + 1;
+
+public:
+  consteval DecodeTable() {
+    size_t next = 8;
+    encoding::for_each([&](const Encoding &e) {
+      const auto opcode = e.match & encoding::kOpcode;
+      auto &row = rows_[encoding::row_of(opcode)];
+      if (row.offset == 0) {
+        const auto field = encoding::field_of(opcode);
+        row = {static_cast<uint16_t>(next), field.shift, field.width};
+        next += size_t{8} << field.width;
+      }
+      // claim every cell whose funct3 and field agree with the encoding
+      const auto covered = (encoding::kFunct3 & ~encoding::kOpcode) |
+                           ((1u << row.width) - 1) << row.shift;
+      for (auto key = 0u; key < (8u << row.width); ++key) {
+        const auto word = (key & 7) << 12 | (key >> 3) << row.shift;
+        if (((word ^ e.match) & e.mask & covered) != 0)
+          continue;
+        auto &cell = cells_[row.offset + key];
+        if (cell != Descriptor::Id::kInvalid)
+          throw "two encodings share a cell; give their opcode a field";
+        cell = e.id;
+      }
+      encodings_[static_cast<size_t>(e.id)] = e;
+    });
+  }
+
+public:
+  /// @return the encoding @p num is, among @p extensions; invalid if none.
+  constexpr auto describe(const uint32_t num,
+                          const ExtensionSet extensions) const noexcept
+      -> Descriptor {
+    return confirm(cells_[cell_of(num)], num, extensions);
+  }
+  /// @brief `describe` every word of @p words into @p out, as many. eight
+  /// words at a time with AVX2, four with NEON, one by one on other hosts and
+  /// for what is left over.
+  auto describe_n(std::span<const uint32_t> words,
+                  std::span<Descriptor> out,
+                  ExtensionSet extensions) const noexcept -> void;
+  /// @brief `describe_n` one word at a time; what it falls back to.
+  constexpr auto describe_n_scalar(const std::span<const uint32_t> words,
+                                   const std::span<Descriptor> out,
+                                   const ExtensionSet extensions) const noexcept
+      -> void {
+    for (size_t i = 0; i < words.size(); ++i)
+      out[i] = describe(words[i], extensions);
+  }
+  constexpr auto extension_of(const Descriptor::Id id) const noexcept {
+    return encodings_[static_cast<size_t>(id)].extension;
+  }
+
+private:
+  /// @brief where the only encoding @p num may be sits.
+  constexpr auto cell_of(const uint32_t num) const noexcept -> uint32_t {
+    const auto &row = rows_[encoding::row_of(num)];
+    const auto key = (num >> 12 & 7) |
+                     (num >> row.shift & ((1u << row.width) - 1)) << 3;
+    return row.offset + key;
+  }
+  /// @brief @p num as encoding @p id, if it matches and is among
+  /// @p extensions.
+  constexpr auto confirm(const Descriptor::Id id,
+                         const uint32_t num,
+                         const ExtensionSet extensions) const noexcept
+      -> Descriptor {
+    const auto &e = encodings_[static_cast<size_t>(id)];
+    if (id == Descriptor::Id::kInvalid || (num & e.mask) != e.match ||
+        !(extensions & set_of(e.extension)))
+      return {};
+    return materialize(e, num);
+  }
+  static constexpr auto materialize(const Encoding &e,
+                                    const uint32_t num) noexcept -> Descriptor {
+    using namespace instruction;
+    switch (e.format) {
+    case Format::kR:
+      return instruction::describe<mixin::RFormat>(e.id, num);
+    case Format::kI:
+      return instruction::describe<mixin::IFormat>(e.id, num);
+    case Format::kIShift: {
+      auto descriptor = instruction::describe<mixin::IFormat>(e.id, num);
+      descriptor.imm &= 0x1F;
+      return descriptor;
+    }
+    case Format::kS:
+      return instruction::describe<mixin::SFormat>(e.id, num);
+    case Format::kB:
+      return instruction::describe<mixin::BFormat>(e.id, num);
+    case Format::kU: {
+      auto descriptor = instruction::describe<mixin::UFormat>(e.id, num);
+      descriptor.imm <<= 12;
+      return descriptor;
+    }
+    case Format::kJ:
+      return instruction::describe<mixin::JFormat>(e.id, num);
+    case Format::kAR:
+      return instruction::describe<mixin::ARFormat>(e.id, num);
+    }
+    return {};
+  }
+
+private:
+  /// the vector kernels; they gather straight out of the arrays below
+  struct Batch;
+  std::array<Row, 32> rows_{};
+  /// three cells more than needed: a gather reads four bytes at a time
+  std::array<Descriptor::Id, encoding::cell_count() + 3> cells_{};
+  std::array<Encoding, id_count> encodings_{};
+};
+inline constexpr DecodeTable decode_table{};
+
+/// a decoder for one extension, backed by the shared table
+class ExtensionDecoder : public IDecoder {
+public:
+  virtual auto extension() const noexcept -> Extension = 0;
+  virtual auto describe(const uint32_t num) const noexcept
+      -> Descriptor override final {
+    return decode_table.describe(num, set_of(extension()));
+  }
+};
+} // namespace accat::luce::isa::riscv32
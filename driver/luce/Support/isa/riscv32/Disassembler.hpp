@@ -1,11 +1,27 @@
 #pragma once
+#include <array>
+
 #include "luce/Support/isa/IDisassembler.hpp"
+#include "luce/Support/isa/riscv32/DecodeTable.hpp"
 namespace accat::luce::isa::riscv32 {
+/// @brief dispatches through the decode table in one lookup, whichever
+/// extensions are registered; falls back to asking every decoder in turn once
+/// a decoder the table does not cover is added.
 class Disassembler : public IDisassembler {
 public:
+  virtual auto disassemble(uint32_t) -> std::unique_ptr<IInstruction> override;
+  virtual auto describe(uint32_t) const -> Descriptor override;
+  virtual auto describe_n(std::span<const uint32_t>,
+                          std::span<Descriptor>) const -> void override;
   virtual ~Disassembler() = default;
 
+protected:
+  virtual auto registered(IDecoder &) -> void override;
+
 private:
   virtual auto initializeDefaultImpl() -> IDisassembler & override;
+  ExtensionSet extensions_ = 0;
+  std::array<ExtensionDecoder *, extension_count> decoders_of_{};
+  bool foreign_ = false;
 };
 } // namespace accat::luce::isa::riscv32
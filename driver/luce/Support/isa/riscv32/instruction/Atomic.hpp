@@ -1,6 +1,6 @@
 #pragma once
 
-#include "luce/Support/isa/IDecoder.hpp"
+#include "luce/Support/isa/riscv32/DecodeTable.hpp"
 #include "details/mixin.hpp"
 
 /// @note currently this has no usage since we only have one cpu.
@@ -18,7 +18,7 @@ INST(Xor, AR);
 INST(Max, AR);
 INST(Min, AR);
 
-INST_DECODER();
+INST_DECODER(Atomic);
 
 #define AC_RESTORE_YOUR_MACRO
 #include "details/debunk_your_macro-inl.hpp"
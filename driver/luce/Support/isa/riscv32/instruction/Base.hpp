@@ -1,7 +1,7 @@
 #pragma once
 
 #include "details/mixin.hpp"
-#include "luce/Support/isa/IDecoder.hpp"
+#include "luce/Support/isa/riscv32/DecodeTable.hpp"
 
 namespace accat::luce::isa::riscv32::instruction::base {
 // don't ask
@@ -47,8 +47,10 @@ INST(Lui, U);
 INST(Auipc, U);
 INST(Ecall, I);
 INST(Ebreak, I);
+INST(Wfi, I);
+INST(Csrrs, I);
 
-INST_DECODER();
+INST_DECODER(Base);
 
 // restore your meow meow meow
 #define AC_RESTORE_YOUR_MACRO
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "luce/Support/isa/IDecoder.hpp"
+#include "luce/Support/isa/riscv32/DecodeTable.hpp"
 #include "details/mixin.hpp"
 
 namespace accat::luce::isa::riscv32::instruction::multiply {
@@ -17,7 +17,7 @@ INST(Divu, R);
 INST(Rem, R);
 INST(Remu, R);
 
-INST_DECODER();
+INST_DECODER(Multiply);
 
 #define AC_RESTORE_YOUR_MACRO
 #include "details/debunk_your_macro-inl.hpp"
@@ -43,10 +43,13 @@
     }
 #  define CONCAT_HELPER(_name_, _fmt_) _name_##_fmt_
 #  define INST(_name_, _fmt_) INST_IMPL(_name_, CONCAT_HELPER(_fmt_, Format))
-#  define INST_DECODER()                                                       \
-    class Decoder : public IDecoder {                                          \
+#  define INST_DECODER(_extension_)                                            \
+    class Decoder : public ExtensionDecoder {                                  \
     public:                                                                    \
       virtual auto decode(uint32_t) -> std::unique_ptr<IInstruction> override; \
+      virtual auto extension() const noexcept -> Extension override {          \
+        return Extension::k##_extension_;                                      \
+      }                                                                        \
       virtual ~Decoder() override = default;                                   \
     }
 #elif defined(AC_RESTORE_YOUR_MACRO)
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+
+#include "luce/Support/isa/Descriptor.hpp"
+#include "luce/Support/isa/Word.hpp"
+#include "mixin.hpp"
+
+namespace accat::luce::isa::riscv32::instruction {
+/// @brief read the fields @p Format defines off @p num, through the very
+/// accessors the instruction classes use.
+template <typename Format>
+constexpr auto describe(const Descriptor::Id id, const uint32_t num) noexcept
+    -> Descriptor {
+  struct Fields : Word, Format {
+    using Word::Word;
+  };
+  const Fields fields{num};
+  Descriptor descriptor{.id = id};
+  if constexpr (requires { fields.rd(); })
+    descriptor.rd = static_cast<uint8_t>(fields.rd());
+  if constexpr (requires { fields.rs1(); })
+    descriptor.rs1 = static_cast<uint8_t>(fields.rs1());
+  if constexpr (requires { fields.rs2(); })
+    descriptor.rs2 = static_cast<uint8_t>(fields.rs2());
+  if constexpr (requires { fields.imm(); })
+    descriptor.imm = fields.imm();
+  return descriptor;
+}
+} // namespace accat::luce::isa::riscv32::instruction
@@ -111,7 +111,7 @@ mixin_decl(SFormat,
            funct3rd12To15Common,
            opcode0To6Common,
            imm2StrCommon) constexpr auto imm(this auto &&self) noexcept {
-  auto real_imm = self.template concatBits<instruction_size_t, 7, 12>(
+  auto real_imm = self.template concatBits<instruction_size_t, 7, 12, 25, 32>(
       self.num()); // [7, 12) and [25, 32)
   // sign-extend 12 bits to 32 bits
   return self.template signExtend<12>(real_imm);
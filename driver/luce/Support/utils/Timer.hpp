@@ -1,15 +1,107 @@
 ﻿#pragma once
 
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <chrono>
+#include <cstdint>
 #include <deque>
+#include <limits>
+#include <string>
+#include <fmt/chrono.h>
+#include <fmt/format.h>
 #include <accat/auxilia/auxilia.hpp>
 
 #include "luce/config.hpp"
 
 namespace accat::luce {
+/// @brief latencies bucketed by powers of two nanoseconds: the memory stays
+/// the same however many are recorded, percentiles are exact to a factor of 2.
+class LatencyHistogram {
+public:
+  using duration_type = std::chrono::duration<double>;
+  /// bucket `i` holds [2^(i-1), 2^i) ns, bucket 0 holds 0 ns
+  static constexpr size_t bucket_count = 64;
+
+public:
+  auto record(const duration_type elapsed) noexcept -> void {
+    const auto ns = static_cast<uint64_t>(
+        (std::max)(std::chrono::duration<double, std::nano>(elapsed).count(),
+                   0.0));
+    ++buckets_[(std::min)(static_cast<size_t>(std::bit_width(ns)),
+                          bucket_count - 1)];
+    ++count_;
+    sum_ += ns;
+    min_ = (std::min)(min_, ns);
+    max_ = (std::max)(max_, ns);
+  }
+  auto count() const noexcept {
+    return count_;
+  }
+  auto min() const noexcept -> duration_type {
+    return count_ ? nanoseconds(min_) : duration_type::zero();
+  }
+  auto max() const noexcept -> duration_type {
+    return nanoseconds(max_);
+  }
+  auto mean() const noexcept -> duration_type {
+    return count_ ? nanoseconds(sum_ / count_) : duration_type::zero();
+  }
+  /// @brief the upper bound of the bucket holding the @p fraction quantile,
+  /// clamped to what was actually recorded.
+  auto percentile(const double fraction) const noexcept -> duration_type {
+    if (!count_)
+      return duration_type::zero();
+    const auto rank = static_cast<uint64_t>(
+        std::clamp(fraction, 0.0, 1.0) * static_cast<double>(count_ - 1));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < bucket_count; ++i)
+      if ((seen += buckets_[i]) > rank) {
+        // the last bucket holds everything above, up to the maximum
+        const auto upper = i == bucket_count - 1 ? max_
+                           : i                   ? (uint64_t{1} << i) - 1
+                                                 : uint64_t{0};
+        return nanoseconds(std::clamp(upper, min_, max_));
+      }
+    return max();
+  }
+  auto to_string() const -> std::string {
+    using microseconds = std::chrono::duration<double, std::micro>;
+    return fmt::format("{} samples, min {:.3}, p50 {:.3}, p90 {:.3}, p99 "
+                       "{:.3}, max {:.3}, mean {:.3}",
+                       count_,
+                       microseconds(min()),
+                       microseconds(percentile(0.5)),
+                       microseconds(percentile(0.9)),
+                       microseconds(percentile(0.99)),
+                       microseconds(max()),
+                       microseconds(mean()));
+  }
+
+private:
+  static constexpr auto nanoseconds(const uint64_t ns) noexcept
+      -> duration_type {
+    return std::chrono::duration<double, std::nano>(static_cast<double>(ns));
+  }
+
+private:
+  std::array<uint64_t, bucket_count> buckets_{};
+  uint64_t count_ = 0;
+  uint64_t sum_ = 0;
+  uint64_t min_ = (std::numeric_limits<uint64_t>::max)();
+  uint64_t max_ = 0;
+};
 class Timer {
 public:
   Timer() : global_start_time_(clock_type::now()) {}
+  /// @brief a timer that keeps statistics instead of every frame, and times
+  /// only one call to `measure` in @p sample_every.
+  static auto Streaming(const size_t sample_every = 1) -> Timer {
+    Timer timer;
+    timer.streaming_ = true;
+    timer.sample_every_ = (std::max)(sample_every, size_t{1});
+    return timer;
+  }
   Timer(const Timer &) = delete;
   Timer &operator=(const Timer &) = delete;
   Timer(Timer &&) noexcept = default;
@@ -29,6 +121,11 @@ public:
   auto measure(Func &&func, Args &&...args) noexcept(noexcept(
       std::invoke(std::forward<Func>(func), std::forward<Args>(args)...)))
       -> std::pair<std::invoke_result_t<Func, Args...>, duration_type> {
+    // not sampled: no clock read at all, and a zero duration
+    if (streaming_ && calls_++ % sample_every_ != 0)
+      return {std::invoke(std::forward<Func>(func),
+                          std::forward<Args>(args)...),
+              duration_type::zero()};
     this->start();
     auto res =
         std::invoke(std::forward<Func>(func), std::forward<Args>(args)...);
@@ -41,6 +138,10 @@ public:
     return std::chrono::duration_cast<duration_type>(clock_type::now() -
                                                      global_start_time_);
   }
+  /// @brief what a streaming timer measured so far.
+  auto histogram() const noexcept -> const LatencyHistogram & {
+    return histogram_;
+  }
 
 private:
   void start() {
@@ -52,10 +153,14 @@ private:
   duration_type stop() {
     precondition(current_frame_ != time_frame_type{}, "Timer is not started.")
 
-    time_stack_.emplace_back(current_frame_);
+    auto [startTime, endTime, elapsedTime] = current_frame_;
     current_frame_ = time_frame_type{};
-
-    auto &[startTime, endTime, elapsedTime] = time_stack_.back();
+    defer {
+      if (streaming_)
+        histogram_.record(elapsedTime);
+      else
+        time_stack_.emplace_back(startTime, endTime, elapsedTime);
+    };
 
     if (time_point_ == time_point{}) {
       endTime = clock_type::now();
@@ -97,5 +202,10 @@ private:
   duration_type real_time_ = duration_type::zero();
   /// @brief time_point when the timer is paused
   time_point time_point_{};
+  /// @brief keep `histogram_` rather than `time_stack_`
+  bool streaming_ = false;
+  size_t sample_every_ = 1;
+  uint64_t calls_ = 0;
+  LatencyHistogram histogram_{};
 };
 } // namespace accat::luce
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <spdlog/spdlog.h>
+#include <accat/auxilia/auxilia.hpp>
+
+// set by the build: 0 compiles every trace point out.
+#ifndef LUCE_TRACE
+#  define LUCE_TRACE 1
+#endif
+
+namespace accat::luce::trace {
+enum class Category : uint8_t {
+  kNone = 0,
+  /// every instruction word fetched by the reference path
+  kFetch = 1 << 0,
+  /// every instruction decoded by the reference path, disassembled
+  kDecode = 1 << 1,
+  /// where each dispatch started and how many instructions it retired
+  kExecute = 1 << 2,
+  /// wall-clock time of each dispatch
+  kTiming = 1 << 3,
+  kAll = kFetch | kDecode | kExecute | kTiming,
+};
+AC_BITMASK_OPS(Category)
+
+/// whether trace points exist in this build at all
+inline constexpr bool compiled = LUCE_TRACE;
+
+namespace details {
+inline Category enabled = Category::kNone;
+} // namespace details
+/// @brief the categories enabled right now. hot paths take a copy once per
+/// dispatch and test that, rather than this, per instruction.
+inline auto enabled() noexcept -> Category {
+  if constexpr (compiled)
+    return details::enabled;
+  else
+    return Category::kNone;
+}
+inline auto enable(const Category categories) noexcept -> void {
+  details::enabled = categories;
+}
+constexpr auto has(const Category set, const Category category) noexcept {
+  return (std::to_underlying(set) & std::to_underlying(category)) != 0;
+}
+/// @brief parse a comma-separated list of categories, e.g. `fetch,decode`.
+inline auto parse(std::string_view names) -> auxilia::StatusOr<Category> {
+  auto categories = Category::kNone;
+  while (!names.empty()) {
+    const auto comma = names.find(',');
+    const auto name = names.substr(0, comma);
+    names = comma == std::string_view::npos ? std::string_view{}
+                                            : names.substr(comma + 1);
+    if (name == "fetch")
+      categories = categories | Category::kFetch;
+    else if (name == "decode")
+      categories = categories | Category::kDecode;
+    else if (name == "execute")
+      categories = categories | Category::kExecute;
+    else if (name == "timing")
+      categories = categories | Category::kTiming;
+    else if (name == "all")
+      categories = categories | Category::kAll;
+    else if (!name.empty())
+      return auxilia::InvalidArgumentError(
+          "Unknown trace category '{}'; expected any of: fetch, decode, "
+          "execute, timing, all",
+          name);
+  }
+  return categories;
+}
+} // namespace accat::luce::trace
+
+/// @brief log through spdlog if @p _category_ is in @p _enabled_, a copy of
+/// `trace::enabled()`. arguments are not evaluated otherwise, and nothing is
+/// left of it without `LUCE_TRACE`.
+#if LUCE_TRACE
+#  define LUCE_TRACE_POINT(_enabled_, _category_, ...)                         \
+    do {                                                                       \
+      if (::accat::luce::trace::has(                                           \
+              (_enabled_), ::accat::luce::trace::Category::_category_))        \
+          [[unlikely]]                                                         \
+        spdlog::info(__VA_ARGS__);                                             \
+    } while (false)
+#else
+#  define LUCE_TRACE_POINT(_enabled_, _category_, ...)                         \
+    static_cast<void>(_enabled_)
+#endif
@@ -141,8 +141,9 @@ public:
     }
     return *this;
   }
-  auto &finish() {
+  auto &finish(const std::optional<int32_t> exit_code = std::nullopt) {
     state_ = State::kTerminated;
+    exit_code_ = exit_code;
     return *this;
   }
   // forcefully terminate the task
@@ -161,6 +162,7 @@ public:
     context_.program_counter.num() =
         address_space_.static_regions.text_segment.start;
     state_ = State::kNew;
+    exit_code_.reset();
     time_slice_ = 0;
     total_cpu_time_ = 0;
     creation_time_ = clock_type::now();
@@ -212,6 +214,13 @@ public:
   auto context() noexcept -> Context & {
     return context_;
   }
+  auto text_segment() const noexcept -> const AddressSpace::MemoryRegion & {
+    return address_space_.static_regions.text_segment;
+  }
+  /// @brief what the task passed to `exit`, if it did.
+  auto exit_code() const noexcept -> std::optional<int32_t> {
+    return exit_code_;
+  }
 
 public:
   auxilia::Property<Task, State, Task &, &Task::get_state, &Task::set_state>
@@ -63,6 +63,15 @@ extern Flag testing;
 extern Flag batch;
 extern Single log;
 extern Single image;
+extern Single engine;
+extern Single jit_threshold;
+extern Single max_instructions;
+extern Single timeout;
+extern Single trace;
+extern Single icount;
+extern Single lockstep;
+extern Single hle;
+extern Single cache_dir;
 extern std::span<Argument *> args();
 } // namespace program
 } // namespace accat::luce::argument
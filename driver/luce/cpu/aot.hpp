@@ -0,0 +1,162 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+#include <fmt/format.h>
+
+#include "luce/Support/isa/architecture.hpp"
+#include "luce/cpu/ir.hpp"
+#include "luce/cpu/threaded.hpp"
+
+namespace accat::luce {
+class CentralProcessingUnit;
+}
+namespace accat::luce::aot {
+using vaddr_t = isa::virtual_address_t;
+/// @brief guest state the code translated ahead of time runs on.
+struct Frame {
+  /// x0 - x31, plus the sink for writes to x0
+  uint32_t x[ThreadedCode::register_count + 1];
+  /// next pc once a block returns
+  uint32_t pc;
+  /// instructions of the block retired; short of its size if it stopped in
+  /// front of something the interpreter has to do
+  uint32_t retired;
+  /// set by a store that dropped translated code, maybe the running block
+  bool stale;
+  CentralProcessingUnit *cpu;
+
+  auto leave(const uint32_t next, const uint32_t count) noexcept -> void {
+    pc = next;
+    retired = count;
+  }
+};
+using block_t = void (*)(Frame &);
+/// one translated block
+struct Entry {
+  uint32_t start;
+  /// guest instructions it retires when run to the end
+  uint32_t size;
+  block_t block;
+};
+/// @brief a text segment translated ahead of time, as `luce-aot` emits it.
+struct Program {
+  vaddr_t base;
+  /// bytes of the text segment
+  uint32_t size;
+  /// of the text segment; a program translated from another image is ignored
+  uint64_t checksum;
+  std::span<const Entry> entries;
+};
+/// longest run of instructions translated into one block, as the block engine
+inline constexpr size_t max_block_size = 64;
+/// @brief FNV-1a of @p bytes, going on from @p hash.
+constexpr auto checksum(const std::span<const std::byte> bytes,
+                        uint64_t hash = 0xcbf29ce484222325) noexcept
+    -> uint64_t {
+  for (const auto byte : bytes)
+    hash = (hash ^ static_cast<uint8_t>(byte)) * 0x100000001b3;
+  return hash;
+}
+/// @brief what the pure @p op computes; the translated code spells out its
+/// operations, and the compiler folds the rest away.
+constexpr auto evaluate(const ir::Op op,
+                        const uint32_t imm,
+                        const uint32_t pc,
+                        const uint32_t lhs,
+                        const uint32_t rhs) noexcept -> uint32_t {
+  return ir::evaluate({.record = {.op = op, .imm = imm}, .pc = pc}, lhs, rhs);
+}
+/// @brief make @p program the one every CPU runs from; a translated unit does
+/// so on startup.
+auto install(const Program &) noexcept -> void;
+auto installed() noexcept -> const Program *;
+/// a translated unit holds one, so linking it in is all it takes
+struct Registration {
+  explicit Registration(const Program &program) noexcept {
+    install(program);
+  }
+};
+/// @brief translate the text segment @p text, loaded at @p base, into a C++
+/// translation unit defining and registering its program.
+auto translate(std::span<const std::byte> text, vaddr_t base) -> std::string;
+} // namespace accat::luce::aot
+namespace accat::luce {
+// aot runtime -- runs the blocks `luce-aot` translated at build time, starting
+// wherever the pc is at the start of one. whatever the translated code cannot
+// do(system, atomic, faults) or does not know(indirect jumps to untranslated
+// code, code stored over) is left to the block engine.
+// resides in the CPU, no need to mark it as a component
+class AotRuntime {
+public:
+  using vaddr_t = isa::virtual_address_t;
+  struct Statistics {
+    uint64_t blocks = 0;
+    uint64_t native_runs = 0;
+    uint64_t side_exits = 0;
+    uint64_t invalidations = 0;
+  };
+
+public:
+  AotRuntime() = default;
+  AotRuntime(const AotRuntime &) = delete;
+  AotRuntime &operator=(const AotRuntime &) = delete;
+  AotRuntime(AotRuntime &&) noexcept = default;
+  AotRuntime &operator=(AotRuntime &&) noexcept = default;
+
+public:
+  /// @brief take up the installed program if it was translated from the text
+  /// segment of the task @p cpu runs now.
+  [[clang::reinitializes]] auto reset(CentralProcessingUnit &) -> AotRuntime &;
+  /// @brief drop every block overlapping [addr, addr + size).
+  auto invalidate(vaddr_t addr, size_t size) noexcept -> AotRuntime &;
+  /// @brief run translated blocks from the current pc until @p budget
+  /// instructions retired or the next block is not translated.
+  /// @return the number of instructions retired; 0 leaves the block to the
+  /// interpreter.
+  auto run(CentralProcessingUnit &, size_t budget) -> size_t;
+  auto loaded() const noexcept -> bool {
+    return program_ != nullptr;
+  }
+  /// @brief what the translated code calls for memory; false on a fault,
+  /// which the interpreter then raises.
+  template <typename T>
+  static auto load(aot::Frame &, uint32_t addr, uint32_t &rd) -> bool;
+  template <typename T>
+  static auto store(aot::Frame &, uint32_t addr, uint32_t value) -> bool;
+  auto statistics() const noexcept -> const Statistics & {
+    return statistics_;
+  }
+  auto to_string() const -> std::string {
+    return fmt::format("aot: {} blocks, {} native runs, {} side exits, {} "
+                       "invalidations",
+                       statistics_.blocks,
+                       statistics_.native_runs,
+                       statistics_.side_exits,
+                       statistics_.invalidations);
+  }
+
+private:
+  auto lookup(const vaddr_t pc) const noexcept -> const aot::Entry * {
+    const auto offset = static_cast<size_t>(pc - program_->base);
+    if (offset % isa::instruction_alignment != 0 ||
+        offset / isa::instruction_alignment >= entries_.size())
+      return nullptr;
+    return entries_[offset / isa::instruction_alignment];
+  }
+
+private:
+  const aot::Program *program_ = nullptr;
+  /// the block starting at each instruction of the text segment, if any
+  std::vector<const aot::Entry *> entries_;
+  /// bytes of the longest block; a store may hit the ones starting that far
+  /// before it
+  size_t reach_ = 0;
+  /// whether an invalidation dropped a block since the last store looked
+  bool dropped_ = false;
+  Statistics statistics_;
+};
+} // namespace accat::luce
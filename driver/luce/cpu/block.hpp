@@ -0,0 +1,391 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <fmt/format.h>
+#include <accat/auxilia/details/macros.hpp>
+
+#include "luce/Support/isa/architecture.hpp"
+#include "luce/Support/isa/IInstruction.hpp"
+#include "luce/cpu/ir.hpp"
+namespace accat::luce {
+/// @brief a straight-line run of decoded instructions, ending with the first
+/// branch, `jal`, `jalr` or system instruction(or when decoding fails).
+/// @note a trace is a BasicBlock too: the blocks of a hot path laid end to
+/// end, with a guard at every control transfer between them.
+struct BasicBlock {
+  using vaddr_t = isa::virtual_address_t;
+  using inst_ptr_t = std::unique_ptr<isa::IInstruction>;
+
+  explicit BasicBlock(const vaddr_t start) noexcept : start(start), end(start) {}
+  BasicBlock(const BasicBlock &) = delete;
+  BasicBlock &operator=(const BasicBlock &) = delete;
+
+  auto size() const noexcept {
+    return instructions.size();
+  }
+  auto empty() const noexcept {
+    return instructions.empty();
+  }
+
+  vaddr_t start;
+  /// one past the last instruction
+  vaddr_t end;
+  std::vector<inst_ptr_t> instructions;
+  /// `instructions` lowered and optimized, for the interpreter and the jit
+  ir::Block ir;
+  uint64_t executions = 0;
+  /// cleared once a write hits the block; the executing cpu must then leave it
+  bool valid = true;
+  /// native code from the jit, or nullptr if it could not compile the block
+  const void *native = nullptr;
+  /// jit generation `native` belongs to; 0 if never compiled
+  uint32_t generation = 0;
+  /// `native` comes from the optimizing tier
+  bool optimized = false;
+  /// @brief a direct jump to the next block, made the first time control
+  /// leaves through that exit. valid while the cache's epoch is unchanged.
+  struct Link {
+    BasicBlock *block = nullptr;
+    uint64_t epoch = 0;
+  };
+  enum Exit : uint8_t {
+    /// falling off the end: a branch not taken, a block cut at its maximum
+    /// size, or the return site of a call
+    kFallthrough,
+    /// a branch taken, or `jal`
+    kTaken,
+  };
+  Link links[2];
+  /// @brief within a trace, the instruction at `index` must continue at
+  /// `next` as it did when recorded; anywhere else is a side exit.
+  struct Guard {
+    size_t index;
+    vaddr_t next;
+    /// to wherever the side exit went last time
+    Link exit{};
+  };
+  /// in order of `index`; empty unless this is a trace
+  std::vector<Guard> guards;
+  /// trace formation was tried from this block already
+  bool traced = false;
+  /// the trace headed by this block, if any
+  Link trace{};
+  /// the block dropped before this one, while both wait to be freed
+  std::unique_ptr<BasicBlock> buried;
+};
+// block cache -- basic blocks keyed by their start address, tracked by page so
+// a store into a page drops every block on it.
+// resides in the CPU, no need to mark it as a component
+class BlockCache {
+public:
+  using vaddr_t = isa::virtual_address_t;
+  using block_ptr_t = std::unique_ptr<BasicBlock>;
+  struct Statistics {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t invalidations = 0;
+    /// exits that went through a link instead of a lookup
+    uint64_t chained = 0;
+    uint64_t traces = 0;
+  };
+
+public:
+  BlockCache() = default;
+  BlockCache(const BlockCache &) = delete;
+  BlockCache &operator=(const BlockCache &) = delete;
+  BlockCache(BlockCache &&) noexcept = default;
+  BlockCache &operator=(BlockCache &&) noexcept = default;
+
+public:
+  [[clang::reinitializes]] auto clear() noexcept -> BlockCache & {
+    blocks_.clear();
+    traces_.clear();
+    pages_.clear();
+    collect();
+    lowest_ = (std::numeric_limits<vaddr_t>::max)();
+    highest_ = 0;
+    statistics_ = {};
+    ++epoch_;
+    return *this;
+  }
+  /// @brief bumped whenever a block is dropped, which expires every link and
+  /// every other pointer to a block tagged with an older epoch.
+  auto epoch() const noexcept {
+    return epoch_;
+  }
+  /// @return the block @p link leads to, if still valid and starting at
+  /// @p pc; nullptr otherwise.
+  auto follow(const BasicBlock::Link &link, const vaddr_t pc) noexcept
+      -> BasicBlock * {
+    if (link.epoch != epoch_ || link.block->start != pc)
+      return nullptr;
+    ++statistics_.chained;
+    return link.block;
+  }
+  auto link(BasicBlock::Link &link, BasicBlock *block) const noexcept
+      -> void {
+    link = {block, epoch_};
+  }
+  auto lookup(const vaddr_t pc) noexcept -> BasicBlock * {
+    if (const auto it = blocks_.find(pc); it != blocks_.end()) {
+      ++statistics_.hits;
+      return it->second.get();
+    }
+    ++statistics_.misses;
+    return nullptr;
+  }
+  auto insert(block_ptr_t block) -> BasicBlock * {
+    precondition(block && !block->empty(), "Cannot cache an empty block")
+    track(*block);
+    const auto start = block->start;
+    return (blocks_[start] = std::move(block)).get();
+  }
+  /// @brief cache @p trace as the one @p head leads into. a write to any of
+  /// its pages drops it along with @p head.
+  auto insert(BasicBlock &head, block_ptr_t trace) -> BasicBlock * {
+    precondition(trace && trace->start == head.start,
+                 "A trace must start at its head")
+    track(*trace);
+    ++statistics_.traces;
+    const auto result = (traces_[head.start] = std::move(trace)).get();
+    link(head.trace, result);
+    return result;
+  }
+  /// @return the trace @p head leads into, or nullptr.
+  auto trace_of(BasicBlock &head) noexcept -> BasicBlock * {
+    if (head.trace.epoch == epoch_)
+      return head.trace.block;
+    if (!head.traced)
+      return nullptr;
+    // the link went stale on some other block's account
+    const auto it = traces_.find(head.start);
+    if (it == traces_.end())
+      return nullptr;
+    link(head.trace, it->second.get());
+    return it->second.get();
+  }
+  /// @brief drop every block sharing a page with [addr, addr + size).
+  /// @note the blocks are not freed until collect(), since the cpu may be
+  /// executing one of them right now.
+  auto invalidate(const vaddr_t addr, const size_t size) noexcept
+      -> BlockCache & {
+    if (size == 0 || blocks_.empty())
+      return *this;
+    const auto last = page_of(static_cast<vaddr_t>(addr + size - 1));
+    for (auto page = page_of(addr); page <= last; ++page) {
+      const auto it = pages_.find(page);
+      if (it == pages_.end())
+        continue;
+      // moved out first: the blocks leave their other pages below
+      const auto starts = std::move(it->second);
+      pages_.erase(it);
+      for (const auto start : starts)
+        for (auto *const map : {&blocks_, &traces_})
+          if (auto node = map->extract(start)) {
+            untrack(*node.mapped());
+            node.mapped()->valid = false;
+            // threaded through the blocks themselves: called on every store
+            // into code, which must not allocate
+            node.mapped()->buried = std::move(graveyard_);
+            graveyard_ = std::move(node.mapped());
+            ++statistics_.invalidations;
+            ++epoch_;
+          }
+    }
+    return *this;
+  }
+  /// @brief free the blocks dropped by invalidate(), handing each to
+  /// @p release first.
+  /// @pre the cpu is not executing any block.
+  template <typename Release>
+  auto collect(Release &&release) noexcept -> BlockCache & {
+    // one at a time; freeing the head alone would recurse down the list
+    while (graveyard_) {
+      release(std::as_const(*graveyard_));
+      graveyard_ = std::move(graveyard_->buried);
+    }
+    return *this;
+  }
+  auto collect() noexcept -> BlockCache & {
+    return collect([](const BasicBlock &) noexcept {});
+  }
+  /// @brief call @p visitor with every cached block, traces aside.
+  template <typename Visitor>
+  auto for_each(Visitor &&visitor) const -> void {
+    for (const auto &[start, block] : blocks_)
+      visitor(std::as_const(*block));
+  }
+  /// @return [lowest, highest) address ever translated since clear(); empty
+  /// if nothing was.
+  auto extent() const noexcept -> std::pair<vaddr_t, vaddr_t> {
+    return {lowest_, highest_};
+  }
+  auto statistics() const noexcept -> const Statistics & {
+    return statistics_;
+  }
+  auto to_string() const -> std::string {
+    const auto total = statistics_.hits + statistics_.misses;
+    return fmt::format("block cache: {} blocks, {} hits, {} misses ({:.2f}% "
+                       "hit rate), {} invalidations, {} chained, {} traces",
+                       blocks_.size(),
+                       statistics_.hits,
+                       statistics_.misses,
+                       total ? 100.0 * statistics_.hits / total : 0.0,
+                       statistics_.invalidations,
+                       statistics_.chained,
+                       statistics_.traces);
+  }
+
+private:
+  static constexpr auto page_of(const vaddr_t addr) noexcept -> vaddr_t {
+    return addr / isa::page_size;
+  }
+  /// @brief call @p visitor with [begin, end) of every straight-line run of
+  /// @p block.
+  template <typename Visitor>
+  static auto for_each_run(const BasicBlock &block, Visitor &&visitor) -> void {
+    auto begin = block.start;
+    size_t first = 0;
+    for (const auto &guard : block.guards) {
+      visitor(begin,
+              static_cast<vaddr_t>(begin + (guard.index + 1 - first) *
+                                               isa::instruction_size_bytes));
+      begin = guard.next;
+      first = guard.index + 1;
+    }
+    visitor(begin, block.end);
+  }
+  /// @brief note the pages of every straight-line run of @p block, once each;
+  /// a block retranslated at the same start is there already.
+  auto track(const BasicBlock &block) -> void {
+    for_each_run(block, [&](const vaddr_t begin, const vaddr_t end) {
+      lowest_ = (std::min)(lowest_, begin);
+      highest_ = (std::max)(highest_, end);
+      for (auto page = page_of(begin); page <= page_of(end - 1); ++page)
+        if (auto &starts = pages_[page];
+            std::ranges::find(starts, block.start) == starts.end())
+          starts.push_back(block.start);
+    });
+  }
+  /// @brief forget the dropped @p block on every page it was noted on.
+  auto untrack(const BasicBlock &block) noexcept -> void {
+    for_each_run(block, [&](const vaddr_t begin, const vaddr_t end) {
+      for (auto page = page_of(begin); page <= page_of(end - 1); ++page)
+        if (const auto it = pages_.find(page); it != pages_.end()) {
+          std::erase(it->second, block.start);
+          if (it->second.empty())
+            pages_.erase(it);
+        }
+    });
+  }
+
+private:
+  std::unordered_map<vaddr_t, block_ptr_t> blocks_;
+  /// head start address -> trace
+  std::unordered_map<vaddr_t, block_ptr_t> traces_;
+  /// page number -> start address of the blocks overlapping the page
+  std::unordered_map<vaddr_t, std::vector<vaddr_t>> pages_;
+  /// the last block dropped, the rest through `BasicBlock::buried`
+  block_ptr_t graveyard_;
+  vaddr_t lowest_ = (std::numeric_limits<vaddr_t>::max)();
+  vaddr_t highest_ = 0;
+  /// starts at 1 so that a default Link is never valid
+  uint64_t epoch_ = 1;
+  Statistics statistics_;
+};
+// indirect branch cache -- where `jalr` goes: a return address stack predicts
+// returns, a small direct-mapped table of targets covers the rest. entries
+// carry the epoch of the block cache and miss once it moves on.
+// resides in the CPU, no need to mark it as a component
+class IndirectBranchCache {
+public:
+  using vaddr_t = isa::virtual_address_t;
+  struct Statistics {
+    uint64_t returns = 0;
+    uint64_t return_misses = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+  };
+  static constexpr size_t stack_depth = 16;
+  static constexpr size_t table_size = 256;
+
+public:
+  [[clang::reinitializes]] auto clear() noexcept -> IndirectBranchCache & {
+    stack_ = {};
+    top_ = 0;
+    depth_ = 0;
+    table_ = {};
+    statistics_ = {};
+    return *this;
+  }
+  /// @brief @p caller ended with a call; the matching return lands on its
+  /// fallthrough.
+  auto call(BasicBlock *caller, const uint64_t epoch) noexcept -> void {
+    top_ = (top_ + 1) % stack_depth;
+    stack_[top_] = {caller, epoch};
+    depth_ = (std::min)(depth_ + 1, stack_depth);
+  }
+  /// @return the block whose call returned to @p pc, or nullptr if the
+  /// prediction was wrong(or the stack overflowed, longjmp, ...).
+  auto ret(const vaddr_t pc, const uint64_t epoch) noexcept -> BasicBlock * {
+    if (!depth_) {
+      ++statistics_.return_misses;
+      return nullptr;
+    }
+    const auto [caller, when] = stack_[top_];
+    top_ = (top_ + stack_depth - 1) % stack_depth;
+    --depth_;
+    if (when != epoch || caller->end != pc) {
+      ++statistics_.return_misses;
+      return nullptr;
+    }
+    ++statistics_.returns;
+    return caller;
+  }
+  auto lookup(const vaddr_t pc, const uint64_t epoch) noexcept
+      -> BasicBlock * {
+    if (const auto &[block, when] = table_[slot_of(pc)];
+        when == epoch && block->start == pc) {
+      ++statistics_.hits;
+      return block;
+    }
+    ++statistics_.misses;
+    return nullptr;
+  }
+  auto insert(BasicBlock *block, const uint64_t epoch) noexcept -> void {
+    table_[slot_of(block->start)] = {block, epoch};
+  }
+  auto statistics() const noexcept -> const Statistics & {
+    return statistics_;
+  }
+  auto to_string() const -> std::string {
+    return fmt::format("indirect branches: {} returns predicted, {} "
+                       "mispredicted; {} target hits, {} misses",
+                       statistics_.returns,
+                       statistics_.return_misses,
+                       statistics_.hits,
+                       statistics_.misses);
+  }
+
+private:
+  static constexpr auto slot_of(const vaddr_t pc) noexcept -> size_t {
+    return (pc / isa::instruction_size_bytes) % table_size;
+  }
+
+private:
+  using entry_type = BasicBlock::Link;
+  std::array<entry_type, stack_depth> stack_{};
+  size_t top_ = 0;
+  size_t depth_ = 0;
+  std::array<entry_type, table_size> table_{};
+  Statistics statistics_;
+};
+} // namespace accat::luce
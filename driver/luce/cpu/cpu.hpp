@@ -5,21 +5,35 @@
 #include <spdlog/spdlog.h>
 #include "luce/Support/utils/Pattern.hpp"
 #include "luce/Support/utils/Timer.hpp"
+#include "luce/Support/utils/Trace.hpp"
 #include "accat/auxilia/details/Status.hpp"
 #include "luce/config.hpp"
 #include "luce/Task.hpp"
 #include "luce/Support/isa/architecture.hpp"
 #include "luce/Support/isa/Icpu.hpp"
 #include "luce/cpu/mmu.hpp"
+#include "luce/cpu/icache.hpp"
+#include "luce/cpu/block.hpp"
+#include "luce/cpu/ir.hpp"
+#include "luce/cpu/threaded.hpp"
+#include "luce/cpu/jit.hpp"
+#include "luce/cpu/aot.hpp"
+#include "luce/cpu/predecode.hpp"
+#include "luce/cpu/hle.hpp"
+#include "luce/cpu/persist.hpp"
 #include <accat/auxilia/auxilia.hpp>
 #include <accat/auxilia/details/macros.hpp>
 #include <algorithm>
 #include <array>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <limits>
 #include <memory>
 #include <optional>
+#include <span>
+#include <utility>
+#include <vector>
 namespace accat::luce {
 namespace isa {
 class IDisassembler;
@@ -31,25 +45,67 @@ class IInstruction;
 }
 namespace accat::luce {
 class CentralProcessingUnit : public isa::Icpu {
+  friend class ThreadedCode;
+  friend class JitCompiler;
+  friend class AotRuntime;
+  friend class HighLevelEmulation;
   Task *task_;
   MemoryManagementUnit mmu_;
-  Timer cpu_timer_;
+  InstructionCache icache_;
+  BlockCache bcache_;
+  IndirectBranchCache branches_;
+  ir::Optimizer ir_optimizer_;
+  ThreadedCode threaded_;
+  JitCompiler jit_;
+  AotRuntime aot_;
+  Predecoder predecoder_;
+  HighLevelEmulation hle_;
+  PersistentCache cache_;
+  /// times whole dispatches, 1 in `kTimerSampling`, into a histogram of
+  /// fixed size; a per-instruction record would grow without bound.
+  static constexpr size_t kTimerSampling = 64;
+  Timer cpu_timer_ = Timer::Streaming(kTimerSampling);
   std::optional<vaddr_t> atomic_address_;
+  /// trace categories, as of the start of the current dispatch
+  trace::Category trace_ = trace::Category::kNone;
+  Options options_;
+  uint64_t syscalls_ = 0;
+  /// instructions retired by the dispatches so far, counted once a dispatch
+  uint64_t instret_ = 0;
+  /// instructions the running dispatch retired before the one at hand; set in
+  /// front of the instructions that may read the counters
+  uint64_t progress_ = 0;
+  /// host time the task started at
+  std::chrono::steady_clock::time_point epoch_ =
+      std::chrono::steady_clock::now();
 
 public:
   CentralProcessingUnit(Mediator * = nullptr);
   virtual ~CentralProcessingUnit() override;
 
 public:
-  virtual auto switch_task(Task *task) noexcept -> Icpu & override {
+  virtual auto switch_task(Task *task) -> Icpu & override {
     precondition(state_ == State::kVacant, "CPU is already running a program")
     atomic_address_.reset();
     task_ = task;
+    icache_.reset(task->text_segment().start, task->text_segment().end);
+    bcache_.clear();
+    branches_.clear();
+    ir_optimizer_.reset();
+    threaded_.reset(task->text_segment().start, task->text_segment().end);
+    jit_.reset();
+    aot_.reset(*this);
+    restart_clock();
+    map_window();
+    cache_.load(options_.cache_dir, text());
+    predecode();
+    hle_.reset(text(), task->text_segment().start);
     return *this;
   }
 
 public:
   virtual auto execute_shuttle() -> auxilia::Status override;
+  virtual auto dispatch(size_t) -> auxilia::StatusOr<size_t> override;
   virtual auto fetch(vaddr_t) const
       -> auxilia::StatusOr<std::span<const std::byte>> override;
   virtual auto write(vaddr_t, const std::span<const std::byte>)
@@ -64,13 +120,110 @@ public:
     return atomic_address_;
   }
   virtual auto handle_syscall() -> auxilia::Status override;
+  virtual auto invalidate(vaddr_t addr, size_t size) noexcept
+      -> Icpu & override {
+    icache_.invalidate(addr, size);
+    bcache_.invalidate(addr, size);
+    threaded_.invalidate(addr, size);
+    aot_.invalidate(addr, size);
+    predecoder_.invalidate(addr, size);
+    return *this;
+  }
+  virtual auto store_unchecked(vaddr_t, std::span<const std::byte>) noexcept
+      -> void override;
+  virtual auto bind_routines(std::span<const hle::Binding> bindings)
+      -> Icpu & override {
+    hle_.bind(bindings);
+    return *this;
+  }
+  virtual auto routines() const noexcept
+      -> std::span<const hle::Binding> override {
+    return hle_.bindings();
+  }
+  virtual auto persist() -> auxilia::Status override;
+  virtual auto configure(const Options &options) -> Icpu & override {
+    precondition(state_ == State::kVacant, "CPU is already running a program")
+    options_ = options;
+    return *this;
+  }
+  virtual auto options() const noexcept -> const Options & override {
+    return options_;
+  }
+  virtual auto syscalls() const noexcept -> uint64_t override {
+    return syscalls_;
+  }
+  virtual auto instret() const noexcept -> uint64_t override {
+    return instret_ + progress_;
+  }
+  virtual auto time() const noexcept -> uint64_t override {
+    if (options_.icount_shift)
+      return instret() << *options_.icount_shift;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - epoch_)
+        .count();
+  }
+  virtual auto cycles() const noexcept -> uint64_t override {
+    return options_.icount_shift ? instret() : time();
+  }
+  virtual auto statistics() const -> std::string override {
+    return fmt::format("{}\n{}\n{}\n{}\n{}\n{}\n{}\n{}\n{}\n{}\n"
+                       "dispatch latency: {}",
+                       icache_.to_string(),
+                       bcache_.to_string(),
+                       branches_.to_string(),
+                       ir_optimizer_.to_string(),
+                       threaded_.to_string(),
+                       jit_.to_string(),
+                       aot_.to_string(),
+                       predecoder_.to_string(),
+                       hle_.to_string(),
+                       cache_.to_string(),
+                       cpu_timer_.histogram().to_string());
+  }
 
 private:
+  /// @brief start the counters and the clock over, for a new task.
+  auto restart_clock() noexcept -> void {
+    instret_ = 0;
+    progress_ = 0;
+    epoch_ = std::chrono::steady_clock::now();
+  }
   auto detach_task() noexcept -> CentralProcessingUnit &;
   auto shuttle() -> auxilia::Status;
   auto decode_and_execute() -> auxilia::Status;
   auto execute(isa::IInstruction *) -> auxilia::Status;
+  auto commit(isa::IInstruction::ExecutionStatus) -> auxilia::Status;
+  auto execute_block(size_t) -> auxilia::StatusOr<size_t>;
+  /// @brief run the ir of @p block, all of which must fit in the budget.
+  /// @return the instructions completed, and the guard failed if a side exit
+  /// was taken; otherwise the instructions from there on are left to the
+  /// caller, with the pc pointing to the first.
+  auto execute_ir(BasicBlock &block)
+      -> std::pair<size_t, BasicBlock::Guard *>;
+  auto translate(vaddr_t) -> BasicBlock *;
+  /// @brief the cached block @p from continues into at @p pc, through its
+  /// links or the indirect branch cache where possible.
+  /// @return nullptr if the block at @p pc is not translated yet.
+  auto successor(BasicBlock &from, vaddr_t pc) -> BasicBlock *;
+  auto follow(BasicBlock::Link &, vaddr_t) -> BasicBlock *;
+  /// @brief extend the trace being recorded along @p path with the jump from
+  /// @p from to @p to, start one, or turn a finished one into a trace.
+  auto record(std::vector<BasicBlock *> &path,
+              const BasicBlock &from,
+              BasicBlock &to) -> void;
+  auto form_trace(std::span<BasicBlock *const>) -> BasicBlock *;
+  auto execute_threaded(size_t) -> auxilia::StatusOr<size_t>;
+  auto execute_jit(size_t) -> auxilia::StatusOr<size_t>;
+  auto execute_aot(size_t) -> auxilia::StatusOr<size_t>;
   auto monitor() const noexcept -> Monitor *;
+  /// @brief let loads and stores reach the memory of the monitor directly.
+  auto map_window() noexcept -> void;
+  /// @return the text segment of the task as it is in memory, as far as the
+  /// window reaches.
+  auto text() const noexcept -> std::span<const std::byte>;
+  /// @brief hand the text segment of the task to the predecoder, or what the
+  /// persistent cache kept of it.
+  auto predecode() -> void;
   /// used to handle generic exceptions,subject to change
   auto trap() -> auxilia::Status;
 };
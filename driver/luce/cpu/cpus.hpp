@@ -8,6 +8,8 @@ namespace accat::luce {
 class CPUs : public Component {
   // for debug and easy to understand, we use 1 cpus
   std::array<std::unique_ptr<isa::Icpu>, 1> cpus{};
+  /// what every cpu takes up at `attach_task`
+  isa::Icpu::Options options_;
   using vaddr_t = isa::virtual_address_t;
 
 public:
@@ -39,8 +41,64 @@ public:
             "execution"));
     return {};
   }
-  auto attach_task(Task *task) noexcept -> CPUs & {
-    cpus[0]->switch_task(task);
+  /// @return the number of instructions retired
+  auxilia::StatusOr<size_t> dispatch(const size_t budget) {
+    if (cpus[0]->is_vacant())
+      return cpus[0]->dispatch(budget);
+
+    spdlog::warn(
+        "No CPU available. \n{}",
+        fmt::format(
+            fmt::fg(fmt::color::cyan),
+            "Note: currently not implemented for multi-core and parallel "
+            "execution"));
+    return size_t{0};
+  }
+  auto select_engine(const isa::Icpu::Engine engine) noexcept -> CPUs & {
+    options_.engine = engine;
+    return *this;
+  }
+  auto jit_threshold(const size_t threshold) noexcept -> CPUs & {
+    options_.jit_threshold = threshold;
+    return *this;
+  }
+  auto icount_shift(const std::optional<uint8_t> shift) noexcept -> CPUs & {
+    options_.icount_shift = shift;
+    return *this;
+  }
+  auto icount_shift() const noexcept {
+    return options_.icount_shift;
+  }
+  auto shadow(const bool shadow) noexcept -> CPUs & {
+    options_.shadow = shadow;
+    return *this;
+  }
+  auto lazy_state(const bool lazy) noexcept -> CPUs & {
+    options_.lazy_state = lazy;
+    return *this;
+  }
+  auto bind_routines(const std::span<const hle::Binding> bindings)
+      -> CPUs & {
+    std::ranges::for_each(
+        cpus, [bindings](auto &cpu) { cpu->bind_routines(bindings); });
+    return *this;
+  }
+  auto routines(size_t index = 0) const noexcept {
+    return cpus[index]->routines();
+  }
+  auto cache_dir(std::filesystem::path directory) noexcept -> CPUs & {
+    options_.cache_dir = std::move(directory);
+    return *this;
+  }
+  auxilia::Status persist() {
+    for (auto &cpu : cpus)
+      if (auto res = cpu->persist(); !res)
+        return res;
+    return {};
+  }
+  /// @brief start @p task, with the options set so far.
+  auto attach_task(Task *task) -> CPUs & {
+    cpus[0]->configure(options_).switch_task(task);
     return *this;
   }
   auto check_atomic(const vaddr_t addr, const size_t size) noexcept -> CPUs & {
@@ -53,6 +111,24 @@ public:
     });
     return *this;
   }
+  /// drop every cached translation overlapping [addr, addr + size)
+  auto invalidate(const vaddr_t addr, const size_t size) noexcept -> CPUs & {
+    std::ranges::for_each(
+        cpus, [addr, size](auto &cpu) { cpu->invalidate(addr, size); });
+    return *this;
+  }
+  auto syscalls() const noexcept -> uint64_t {
+    uint64_t syscalls = 0;
+    for (const auto &cpu : cpus)
+      syscalls += cpu->syscalls();
+    return syscalls;
+  }
+  auto statistics(size_t index = 0) const -> std::string {
+    return cpus[index]->statistics();
+  }
+  auto fetch(const vaddr_t addr, size_t index = 0) const {
+    return cpus[index]->fetch(addr);
+  }
   auto pc(size_t index = 0) noexcept -> isa::Word & {
     return cpus[index]->pc();
   }
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <fmt/format.h>
+#include <accat/auxilia/auxilia.hpp>
+
+#include "luce/Support/isa/architecture.hpp"
+
+namespace accat::luce {
+class CentralProcessingUnit;
+namespace hle {
+using vaddr_t = isa::virtual_address_t;
+/// the guest routines the host knows to run itself
+enum class Routine : uint8_t {
+  kMemcpy = 0,
+  kMemset,
+  kStrlen,
+  kMemcmp,
+};
+constexpr auto to_string(const Routine routine) noexcept -> std::string_view {
+  switch (routine) {
+  case Routine::kMemcpy:
+    return "memcpy";
+  case Routine::kMemset:
+    return "memset";
+  case Routine::kStrlen:
+    return "strlen";
+  case Routine::kMemcmp:
+    return "memcmp";
+  }
+  return "unknown";
+}
+/// a guest routine to run natively: the one at `address`, or the one whose
+/// body starts with `fingerprint`, a byte each or any byte where empty
+struct Binding {
+  Routine routine = Routine::kMemcpy;
+  std::optional<vaddr_t> address;
+  std::vector<std::optional<std::byte>> fingerprint;
+};
+/// @brief parse a comma-separated list of bindings, each either
+/// `routine@address`, e.g. `memcpy@0x80000120` as `nm` lists the symbol, or
+/// `routine=fingerprint`, e.g. `strlen=93050500??00`, in hex with `??` for
+/// any byte.
+auto parse(std::string_view) -> auxilia::StatusOr<std::vector<Binding>>;
+} // namespace hle
+// high-level emulation -- runs the bound guest routines as host code
+// whenever control reaches their entry, straight on the guest memory, then
+// returns to the caller as their `ret` would. no block is translated at an
+// entry, so every engine ends up in the reference path in front of one, which
+// asks here first; the call retires as a single instruction.
+// resides in the CPU, no need to mark it as a component
+class HighLevelEmulation {
+public:
+  using vaddr_t = isa::virtual_address_t;
+  struct Statistics {
+    uint64_t calls = 0;
+    uint64_t bytes = 0;
+    /// calls reaching past the memory, left to the guest code
+    uint64_t declined = 0;
+  };
+
+public:
+  auto bind(std::span<const hle::Binding>) -> HighLevelEmulation &;
+  auto bindings() const noexcept -> std::span<const hle::Binding> {
+    return bindings_;
+  }
+  /// @brief find the entries of the bindings in the text segment @p text,
+  /// loaded at @p base.
+  [[clang::reinitializes]] auto reset(std::span<const std::byte> text,
+                                     vaddr_t base) -> HighLevelEmulation &;
+  auto covers(const vaddr_t pc) const noexcept -> bool {
+    return !entries_.empty() && entries_.contains(pc);
+  }
+  /// @brief run the routine at the pc of @p cpu.
+  /// @return false if there is none or it reaches past the memory; the
+  /// guest code runs then.
+  auto run(CentralProcessingUnit &cpu) -> bool;
+  auto statistics() const noexcept -> const Statistics & {
+    return statistics_;
+  }
+  auto to_string() const -> std::string {
+    return fmt::format("hle: {} entries, {} calls, {} bytes, {} declined",
+                       entries_.size(),
+                       statistics_.calls,
+                       statistics_.bytes,
+                       statistics_.declined);
+  }
+
+private:
+  std::vector<hle::Binding> bindings_;
+  std::unordered_map<vaddr_t, hle::Routine> entries_;
+  Statistics statistics_;
+};
+} // namespace accat::luce
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <fmt/format.h>
+#include <accat/auxilia/details/macros.hpp>
+
+#include "luce/Support/isa/architecture.hpp"
+#include "luce/Support/isa/IInstruction.hpp"
+namespace accat::luce {
+// instruction cache -- predecoded instructions of the text segment, indexed by
+// the guest pc. an entry stays valid until a write touches its bytes.
+// resides in the CPU, no need to mark it as a component
+class InstructionCache {
+public:
+  using vaddr_t = isa::virtual_address_t;
+  using inst_t = isa::IInstruction;
+  using inst_ptr_t = std::unique_ptr<inst_t>;
+  struct Statistics {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t invalidations = 0;
+  };
+
+public:
+  InstructionCache() = default;
+  InstructionCache(const InstructionCache &) = delete;
+  InstructionCache &operator=(const InstructionCache &) = delete;
+  InstructionCache(InstructionCache &&) noexcept = default;
+  InstructionCache &operator=(InstructionCache &&) noexcept = default;
+
+public:
+  /// @brief drop every entry and cover [begin, end) from now on.
+  [[clang::reinitializes]] auto reset(const vaddr_t begin, const vaddr_t end)
+      -> InstructionCache & {
+    base_ = begin;
+    entries_.clear();
+    if (end > begin)
+      entries_.resize((end - begin) / isa::instruction_alignment);
+    statistics_ = {};
+    return *this;
+  }
+  auto covers(const vaddr_t pc) const noexcept -> bool {
+    // unsigned wrap-around takes care of `pc < base_`
+    const auto offset = static_cast<size_t>(pc - base_);
+    return offset % isa::instruction_alignment == 0 &&
+           offset / isa::instruction_alignment < entries_.size();
+  }
+  /// @return the cached instruction at @p pc, or nullptr on a miss.
+  auto lookup(const vaddr_t pc) noexcept -> inst_t * {
+    if (covers(pc))
+      if (const auto &entry = entries_[index_of(pc)]) {
+        ++statistics_.hits;
+        return entry.get();
+      }
+    ++statistics_.misses;
+    return nullptr;
+  }
+  /// @pre covers(pc)
+  auto insert(const vaddr_t pc, inst_ptr_t inst) noexcept -> inst_t * {
+    precondition(covers(pc), "pc is not covered by the instruction cache")
+    return (entries_[index_of(pc)] = std::move(inst)).get();
+  }
+  /// @brief drop every entry overlapping [addr, addr + size).
+  auto invalidate(const vaddr_t addr, const size_t size) noexcept
+      -> InstructionCache & {
+    const auto begin = static_cast<size_t>(base_);
+    const auto end = begin + entries_.size() * isa::instruction_alignment;
+    const auto first = static_cast<size_t>(addr);
+    const auto last = first + size;
+    if (size == 0 || last <= begin || first >= end)
+      return *this;
+
+    // an instruction starting up to 3 bytes before `addr` overlaps it as well
+    const auto from = ((std::max)(first, begin) - begin) /
+                      isa::instruction_alignment;
+    const auto to = ((std::min)(last, end) - begin +
+                     isa::instruction_alignment - 1) /
+                    isa::instruction_alignment;
+    for (auto i = from; i < to; ++i)
+      if (entries_[i]) {
+        entries_[i].reset();
+        ++statistics_.invalidations;
+      }
+    return *this;
+  }
+  auto statistics() const noexcept -> const Statistics & {
+    return statistics_;
+  }
+  auto to_string() const -> std::string {
+    const auto total = statistics_.hits + statistics_.misses;
+    return fmt::format("icache: {} hits, {} misses ({:.2f}% hit rate), {} "
+                       "invalidations",
+                       statistics_.hits,
+                       statistics_.misses,
+                       total ? 100.0 * statistics_.hits / total : 0.0,
+                       statistics_.invalidations);
+  }
+
+private:
+  auto index_of(const vaddr_t pc) const noexcept -> size_t {
+    return (pc - base_) / isa::instruction_alignment;
+  }
+
+private:
+  vaddr_t base_ = 0;
+  std::vector<inst_ptr_t> entries_;
+  Statistics statistics_;
+};
+} // namespace accat::luce
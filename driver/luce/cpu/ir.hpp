@@ -0,0 +1,195 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <fmt/format.h>
+
+#include "luce/cpu/threaded.hpp"
+
+namespace accat::luce::isa {
+class IDisassembler;
+}
+namespace accat::luce {
+struct BasicBlock;
+}
+namespace accat::luce::ir {
+using Op = ThreadedCode::Op;
+using Record = ThreadedCode::Record;
+/// the registers an operation reads and writes
+struct Operands {
+  bool rs1 = false;
+  bool rs2 = false;
+  bool rd = false;
+};
+constexpr auto operands_of(const Op op) noexcept -> Operands {
+  // clang-format off
+  switch (op) {
+  case Op::kTranslate:
+  case Op::kFallback:
+#define LUCE_FUSED_CASE(_name_) case Op::k##_name_:
+  // only the threaded engine fuses; these are never lowered
+  LUCE_THREADED_FUSED_OP_LIST(LUCE_FUSED_CASE)
+#undef LUCE_FUSED_CASE
+    return {};
+  case Op::kAddi: case Op::kXori: case Op::kOri: case Op::kAndi:
+  case Op::kSlli: case Op::kSrli: case Op::kSrai: case Op::kSlti:
+  case Op::kSltiu: case Op::kLb: case Op::kLh: case Op::kLw: case Op::kLbu:
+  case Op::kLhu: case Op::kJalr:
+    return {.rs1 = true, .rd = true};
+  case Op::kSb: case Op::kSh: case Op::kSw: case Op::kBeq: case Op::kBne:
+  case Op::kBlt: case Op::kBge: case Op::kBltu: case Op::kBgeu:
+    return {.rs1 = true, .rs2 = true};
+  case Op::kJal: case Op::kLui: case Op::kAuipc:
+    return {.rd = true};
+  default: // register-register arithmetic
+    return {.rs1 = true, .rs2 = true, .rd = true};
+  }
+  // clang-format on
+}
+/// @brief whether @p op only computes its `rd`: it can neither fault, jump
+/// nor leave the block, so it may be folded or dropped.
+constexpr auto is_pure(const Op op) noexcept {
+  switch (op) {
+  case Op::kTranslate:
+  case Op::kFallback:
+  case Op::kLb:
+  case Op::kLh:
+  case Op::kLw:
+  case Op::kLbu:
+  case Op::kLhu:
+  case Op::kSb:
+  case Op::kSh:
+  case Op::kSw:
+  case Op::kBeq:
+  case Op::kBne:
+  case Op::kBlt:
+  case Op::kBge:
+  case Op::kBltu:
+  case Op::kBgeu:
+  case Op::kJal:
+  case Op::kJalr:
+    return false;
+  default:
+    return operands_of(op).rd;
+  }
+}
+/// @brief one guest instruction of a block, as the passes see it.
+struct Operation {
+  Record record;
+  /// pc of the guest instruction
+  uint32_t pc = 0;
+  /// position of the guest instruction in the block
+  uint32_t index = 0;
+  /// for a control transfer inside a trace: where the trace goes on
+  uint32_t next = 0;
+};
+/// @brief what the pure @p operation computes from @p lhs and @p rhs, the
+/// values of its `rs1` and `rs2`; mirrors the handlers of the threaded engine.
+constexpr auto evaluate(const Operation &operation,
+                        const uint32_t lhs,
+                        const uint32_t rhs) noexcept -> uint32_t {
+  const auto imm = operation.record.imm;
+  const auto slhs = static_cast<int32_t>(lhs);
+  const auto srhs = static_cast<int32_t>(rhs);
+  // clang-format off
+  switch (operation.record.op) {
+  case Op::kAdd:   return lhs + rhs;
+  case Op::kSub:   return lhs - rhs;
+  case Op::kXor:   return lhs ^ rhs;
+  case Op::kOr:    return lhs | rhs;
+  case Op::kAnd:   return lhs & rhs;
+  case Op::kSll:   return lhs << (rhs & 0x1F);
+  case Op::kSrl:   return lhs >> (rhs & 0x1F);
+  case Op::kSra:   return static_cast<uint32_t>(slhs >> (rhs & 0x1F));
+  case Op::kSlt:   return slhs < srhs;
+  case Op::kSltu:  return lhs < rhs;
+  case Op::kAddi:  return lhs + imm;
+  case Op::kXori:  return lhs ^ imm;
+  case Op::kOri:   return lhs | imm;
+  case Op::kAndi:  return lhs & imm;
+  case Op::kSlli:  return lhs << imm;
+  case Op::kSrli:  return lhs >> imm;
+  case Op::kSrai:  return static_cast<uint32_t>(slhs >> imm);
+  case Op::kSlti:  return slhs < static_cast<int32_t>(imm);
+  case Op::kSltiu: return lhs < imm;
+  case Op::kLui:   return imm;
+  case Op::kAuipc: return operation.pc + imm;
+#if LUCE_EXTENSION_M
+  case Op::kMul:   return lhs * rhs;
+  case Op::kMulh:
+    return static_cast<uint32_t>((int64_t{slhs} * srhs) >> 32);
+  case Op::kMulsu:
+    return static_cast<uint32_t>((int64_t{slhs} * int64_t{rhs}) >> 32);
+  case Op::kMulu:
+    return static_cast<uint32_t>((uint64_t{lhs} * rhs) >> 32);
+  case Op::kDiv:
+    if (rhs == 0)
+      return ~0u;
+    if (slhs == INT32_MIN && srhs == -1)
+      return lhs;
+    return static_cast<uint32_t>(slhs / srhs);
+  case Op::kDivu:  return rhs ? lhs / rhs : ~0u;
+  case Op::kRem:
+    if (rhs == 0)
+      return lhs;
+    if (slhs == INT32_MIN && srhs == -1)
+      return 0;
+    return static_cast<uint32_t>(slhs % srhs);
+  case Op::kRemu:  return rhs ? lhs % rhs : lhs;
+#endif
+  default: // not pure
+    return 0;
+  }
+  // clang-format on
+}
+// block ir -- a translated block as records of the threaded engine, each
+// tagged with the guest instruction it came from. the passes fold, drop and
+// merge operations, yet any operation that may leave the block(fault, jump,
+// anything left to the interpreter) still sees the exact guest state.
+struct Block {
+  std::vector<Operation> operations;
+  /// pc past the last guest instruction
+  uint32_t end = 0;
+  /// guest instructions, counting the ones optimized away
+  uint32_t size = 0;
+};
+/// @brief lower @p block, guards of a trace included; not optimized yet.
+auto lower(const BasicBlock &, const isa::IDisassembler &) -> Block;
+// optimizer -- cheap passes over a block: constants folded into `lui`, writes
+// to x0 dropped, and writes overwritten before the block may be left
+// eliminated.
+// resides in the CPU, no need to mark it as a component
+class Optimizer {
+public:
+  struct Statistics {
+    uint64_t operations = 0;
+    uint64_t folded = 0;
+    uint64_t dropped = 0;
+  };
+
+public:
+  auto run(Block &) -> Block &;
+  [[clang::reinitializes]] auto reset() noexcept -> Optimizer & {
+    statistics_ = {};
+    return *this;
+  }
+  auto statistics() const noexcept -> const Statistics & {
+    return statistics_;
+  }
+  auto to_string() const -> std::string {
+    return fmt::format("block ir: {} operations, {} folded, {} dropped",
+                       statistics_.operations,
+                       statistics_.folded,
+                       statistics_.dropped);
+  }
+
+private:
+  auto fold(Block &) -> void;
+  auto eliminate(Block &) -> void;
+
+private:
+  Statistics statistics_;
+};
+} // namespace accat::luce::ir
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <fmt/format.h>
+
+#include "luce/Support/isa/architecture.hpp"
+#include "luce/cpu/orc.hpp"
+#include "luce/cpu/threaded.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#  define LUCE_HAS_JIT 1
+#else
+#  define LUCE_HAS_JIT 0
+#endif
+
+namespace accat::luce {
+class CentralProcessingUnit;
+struct BasicBlock;
+/// @brief guest state shared with the native code, whose offsets are baked
+/// into it.
+struct JitContext {
+  uint32_t x[isa::general_purpose_register_count];
+  /// next pc once the native code returns
+  uint32_t pc;
+  /// instructions of the block retired; short of the block size on a side exit
+  uint32_t retired;
+  /// stores to physical offsets in [guard_begin, guard_begin + guard_size)
+  /// may hit translated code, so they leave the block; all of them do while
+  /// MainMemory has more to note than the count below
+  uint32_t guard_begin;
+  uint32_t guard_size;
+  /// host address of `physical_memory_begin`
+  std::byte *memory;
+  /// stores the native code made itself, passed on to MainMemory afterwards
+  uint32_t writes;
+};
+// jit compiler -- translates hot basic blocks into native x86-64 code. guest
+// registers stay in host registers within a block; whatever it cannot do
+// natively(system, atomic, faults, stores near translated code, or any store
+// while a reservation is held or lock-step tracks dirty pages) ends the block
+// early, and the interpreter takes over from that instruction.
+// blocks that stay hot are compiled once more by the optimizing tier, when
+// built with LLVM.
+// resides in the CPU, no need to mark it as a component
+class JitCompiler {
+public:
+  using vaddr_t = isa::virtual_address_t;
+  using native_t = void (*)(JitContext *);
+  struct Statistics {
+    uint64_t compilations = 0;
+    uint64_t failures = 0;
+    uint64_t native_runs = 0;
+    uint64_t side_exits = 0;
+    uint64_t flushes = 0;
+  };
+  static constexpr bool available = LUCE_HAS_JIT || OrcCompiler::available;
+  /// blocks executed this many times the threshold move to the optimizing
+  /// tier
+  static constexpr size_t optimizer_factor = 64;
+  /// executable memory reserved up front; filling it up drops every block
+  static constexpr size_t code_capacity = 16 * 1024 * 1024;
+
+public:
+  JitCompiler();
+  JitCompiler(const JitCompiler &) = delete;
+  JitCompiler &operator=(const JitCompiler &) = delete;
+  JitCompiler(JitCompiler &&) = delete;
+  JitCompiler &operator=(JitCompiler &&) = delete;
+  ~JitCompiler();
+
+public:
+  /// @brief forget every compiled block.
+  [[clang::reinitializes]] auto reset() noexcept -> JitCompiler &;
+  /// @brief run compiled blocks from the current pc, compiling the ones that
+  /// executed at least @p threshold times, until @p budget instructions
+  /// retired or the next block is not(or cannot be) compiled.
+  /// @return the number of instructions retired; 0 leaves the block to the
+  /// interpreter.
+  auto run(CentralProcessingUnit &, size_t budget, size_t threshold) -> size_t;
+  /// @brief free the code the optimizer made for @p block, which is dropped.
+  auto release(const BasicBlock &) noexcept -> JitCompiler &;
+  auto statistics() const noexcept -> const Statistics & {
+    return statistics_;
+  }
+  auto to_string() const -> std::string {
+    auto result =
+        fmt::format("jit: {} compilations, {} failures, {} native runs, {} "
+                    "side exits, {} flushes, {} KiB of code",
+                    statistics_.compilations,
+                    statistics_.failures,
+                    statistics_.native_runs,
+                    statistics_.side_exits,
+                    statistics_.flushes,
+                    used_ / 1024);
+    if constexpr (OrcCompiler::available)
+      result += "\n" + optimizer_.to_string();
+    return result;
+  }
+
+private:
+  auto compile(const BasicBlock &) -> const void *;
+  auto optimize(BasicBlock &) -> void;
+  auto install(std::span<const uint8_t>) -> const void *;
+
+private:
+  std::byte *code_ = nullptr;
+  size_t used_ = 0;
+  /// bumped whenever compiled code is dropped; blocks compiled in an older
+  /// generation must be compiled again
+  uint32_t generation_ = 1;
+  Statistics statistics_;
+  OrcCompiler optimizer_;
+};
+} // namespace accat::luce
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <fmt/format.h>
+
+#include "luce/Support/isa/architecture.hpp"
+#include "luce/cpu/ir.hpp"
+
+// defined by the build once LLVM is found at configure time
+#ifndef LUCE_HAS_LLVM
+#  define LUCE_HAS_LLVM 0
+#endif
+
+namespace accat::luce {
+// orc compiler -- lifts the ir of a basic block or a trace into LLVM IR, runs
+// the optimizer over it and compiles it through ORC. the code honors the
+// `JitContext` contract of the template jit, side exits and trace guards
+// included, so either tier may run a block. each block gets a module of its
+// own, freed once the block is dropped.
+// resides in the JitCompiler, no need to mark it as a component
+class OrcCompiler {
+public:
+  using vaddr_t = isa::virtual_address_t;
+  struct Statistics {
+    uint64_t compilations = 0;
+    uint64_t failures = 0;
+    /// blocks whose code was freed as they were dropped
+    uint64_t released = 0;
+  };
+  static constexpr bool available = LUCE_HAS_LLVM;
+
+public:
+  OrcCompiler();
+  OrcCompiler(const OrcCompiler &) = delete;
+  OrcCompiler &operator=(const OrcCompiler &) = delete;
+  OrcCompiler(OrcCompiler &&) = delete;
+  OrcCompiler &operator=(OrcCompiler &&) = delete;
+  ~OrcCompiler();
+
+public:
+  /// @brief release every compiled block.
+  /// @attention pointers handed out by compile() dangle afterwards.
+  [[clang::reinitializes]] auto reset() noexcept -> OrcCompiler &;
+  /// @brief compile @p block, the ir of the block or trace at @p start.
+  /// @return the entry of the native code, or nullptr if the block could not
+  /// be compiled.
+  auto compile(const ir::Block &block, vaddr_t start) -> const void *;
+  /// @brief free the code compile() returned @p entry for; anything else is
+  /// left alone.
+  /// @pre nothing is running that code, nor will.
+  auto release(const void *entry) noexcept -> OrcCompiler &;
+  auto statistics() const noexcept -> const Statistics & {
+    return statistics_;
+  }
+  auto to_string() const -> std::string {
+    return fmt::format("orc: {} compilations, {} failures, {} released",
+                       statistics_.compilations,
+                       statistics_.failures,
+                       statistics_.released);
+  }
+
+private:
+  /// the LLJIT instance; created on first use so that hosts not running hot
+  /// code never pay for it
+  struct Session;
+  std::unique_ptr<Session> session_;
+  Statistics statistics_;
+};
+} // namespace accat::luce
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <fmt/format.h>
+#include <accat/auxilia/auxilia.hpp>
+
+#include "luce/Support/isa/Descriptor.hpp"
+#include "luce/Support/isa/architecture.hpp"
+
+namespace accat::luce {
+// persistent cache -- what a run learned about the text segment of its image,
+// kept on disk for the next run of the very same image: the descriptors of
+// every instruction, so the predecoder has nothing left to do, and how often
+// each basic block ran, so the jit compiles the hot ones on their first visit.
+// a file is keyed by a hash of the text and of the build; anything else is
+// ignored, as is a file that does not read back whole.
+// resides in the CPU, no need to mark it as a component
+class PersistentCache {
+public:
+  using vaddr_t = isa::virtual_address_t;
+  /// a basic block, as the block cache knew it at the end of a run
+  struct Profile {
+    vaddr_t start;
+    vaddr_t end;
+    uint64_t executions;
+  };
+  struct Statistics {
+    /// loads that found a file for the text
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    /// files found but thrown away: another build, truncated, corrupt
+    uint64_t rejected = 0;
+    uint64_t saves = 0;
+  };
+
+public:
+  /// @brief forget the last text and look up the file of @p text in
+  /// @p directory; nothing is looked up if it is empty.
+  [[clang::reinitializes]] auto load(const std::filesystem::path &directory,
+                                     std::span<const std::byte> text)
+      -> PersistentCache &;
+  /// @return the descriptors of the text loaded; empty if there were none.
+  auto descriptors() const noexcept -> std::span<const isa::Descriptor> {
+    return descriptors_;
+  }
+  /// @return how often the block at @p start ran in the last run; 0 if
+  /// unknown.
+  auto executions(const vaddr_t start) const noexcept -> uint64_t {
+    if (executions_.empty())
+      return 0;
+    const auto it = executions_.find(start);
+    return it == executions_.end() ? 0 : it->second;
+  }
+  /// @brief write @p descriptors and @p profiles for the text as it was at
+  /// `load`, which the task may have stored over since.
+  auto save(std::span<const isa::Descriptor> descriptors,
+            std::span<const Profile> profiles) -> auxilia::Status;
+  auto statistics() const noexcept -> const Statistics & {
+    return statistics_;
+  }
+  auto to_string() const -> std::string {
+    return fmt::format("persistent cache: {} descriptors, {} profiles, {} "
+                       "hits, {} misses, {} rejected, {} saves",
+                       descriptors_.size(),
+                       executions_.size(),
+                       statistics_.hits,
+                       statistics_.misses,
+                       statistics_.rejected,
+                       statistics_.saves);
+  }
+
+private:
+  auto file() const -> std::filesystem::path;
+
+private:
+  std::filesystem::path directory_;
+  /// of the text at `load`; 0 while there is none
+  uint64_t key_ = 0;
+  size_t text_size_ = 0;
+  std::vector<isa::Descriptor> descriptors_;
+  std::unordered_map<vaddr_t, uint64_t> executions_;
+  Statistics statistics_;
+};
+} // namespace accat::luce
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <thread>
+#include <fmt/format.h>
+
+#include "luce/Support/isa/Descriptor.hpp"
+#include "luce/Support/isa/architecture.hpp"
+
+namespace accat::luce::isa {
+class IDisassembler;
+}
+namespace accat::luce {
+// predecoder -- describes the whole text segment of a task on a background
+// thread, a chunk at a time and a chunk per call into the disassembler, while
+// the task already runs. whoever lowers an instruction asks here first, and
+// decodes on demand where the chunk is not done yet or was stored over since.
+// resides in the CPU, no need to mark it as a component
+class Predecoder {
+public:
+  using vaddr_t = isa::virtual_address_t;
+  /// instructions a chunk holds; the unit of readiness and of invalidation
+  static constexpr size_t chunk_size = 1024;
+  struct Statistics {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t drops = 0;
+  };
+
+public:
+  Predecoder();
+  Predecoder(const Predecoder &) = delete;
+  Predecoder &operator=(const Predecoder &) = delete;
+  Predecoder(Predecoder &&) noexcept;
+  Predecoder &operator=(Predecoder &&) noexcept;
+  ~Predecoder();
+
+public:
+  /// @brief forget what was predecoded, and start on the text segment
+  /// @p text, loaded at @p base; the bytes are copied, so the task may run
+  /// and store meanwhile.
+  [[clang::reinitializes]] auto
+  reset(std::span<const std::byte> text,
+        vaddr_t base,
+        std::shared_ptr<const isa::IDisassembler>) -> Predecoder &;
+  /// @brief start out with @p descriptors, an earlier run's of the very same
+  /// @p text, loaded at @p base; nothing is left to decode.
+  [[clang::reinitializes]] auto
+  restore(std::span<const std::byte> text,
+          vaddr_t base,
+          std::span<const isa::Descriptor> descriptors) -> Predecoder &;
+  /// @return the descriptors of the text as it was at `reset`, once all are
+  /// decoded, stores since or not; empty until then.
+  auto snapshot() const noexcept -> std::span<const isa::Descriptor>;
+  /// @brief drop the chunks overlapping [addr, addr + size).
+  auto invalidate(vaddr_t addr, size_t size) noexcept -> Predecoder &;
+  /// @return the descriptor of the instruction at @p pc, an invalid one if
+  /// nothing decodes there; nullptr if not predecoded(yet).
+  auto lookup(vaddr_t pc) noexcept -> const isa::Descriptor *;
+  /// @return the chunks done, of all of them.
+  auto progress() const noexcept -> std::pair<size_t, size_t>;
+  auto statistics() const noexcept -> const Statistics & {
+    return statistics_;
+  }
+  auto to_string() const -> std::string {
+    const auto [ready, chunks] = progress();
+    return fmt::format("predecode: {} of {} chunks ready, {} hits, {} "
+                       "misses, {} drops",
+                       ready,
+                       chunks,
+                       statistics_.hits,
+                       statistics_.misses,
+                       statistics_.drops);
+  }
+
+private:
+  /// what the worker shares with the cpu; stays put when the cpu moves
+  struct Work;
+  std::unique_ptr<Work> work_;
+  /// declared after `work_`, so it is joined before the work goes
+  std::jthread worker_;
+  Statistics statistics_;
+};
+} // namespace accat::luce
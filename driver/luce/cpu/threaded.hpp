@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <fmt/format.h>
+
+#include "luce/Support/isa/architecture.hpp"
+
+// clang-format off
+/// every operation the threaded engine knows; order defines the dispatch table
+#define LUCE_THREADED_OP_LIST(X)                                               \
+  X(Translate) X(Fallback) LUCE_THREADED_GUEST_OP_LIST(X)                      \
+  LUCE_THREADED_FUSED_OP_LIST(X)
+/// operations executing the guest instruction of the same name
+#define LUCE_THREADED_GUEST_OP_LIST(X)                                         \
+  X(Add) X(Sub) X(Xor) X(Or) X(And) X(Sll) X(Srl) X(Sra) X(Slt) X(Sltu)        \
+  X(Addi) X(Xori) X(Ori) X(Andi) X(Slli) X(Srli) X(Srai) X(Slti) X(Sltiu)      \
+  X(Lb) X(Lh) X(Lw) X(Lbu) X(Lhu)                                              \
+  X(Sb) X(Sh) X(Sw)                                                            \
+  X(Beq) X(Bne) X(Blt) X(Bge) X(Bltu) X(Bgeu)                                  \
+  X(Jal) X(Jalr) X(Lui) X(Auipc)                                               \
+  LUCE_THREADED_MULTIPLY_OP_LIST(X)
+/// rv32m, unless the build leaves it out
+#if LUCE_EXTENSION_M
+#  define LUCE_THREADED_MULTIPLY_OP_LIST(X)                                    \
+    X(Mul) X(Mulh) X(Mulsu) X(Mulu) X(Div) X(Divu) X(Rem) X(Remu)
+#else
+#  define LUCE_THREADED_MULTIPLY_OP_LIST(X)
+#endif
+/// pairs executed by one dispatch: `li`, `la`, far calls and a compare feeding
+/// `beqz`/`bnez`
+#define LUCE_THREADED_FUSED_OP_LIST(X)                                         \
+  X(LuiAddi) X(AuipcAddi) X(AuipcJalr)                                         \
+  X(AddiBeq) X(AddiBne) X(SltBeq) X(SltBne) X(SltuBeq) X(SltuBne)
+// clang-format on
+
+namespace accat::luce::isa {
+struct Descriptor;
+}
+namespace accat::luce {
+class CentralProcessingUnit;
+// threaded code -- the text segment lowered into compact records, executed by
+// direct-threaded dispatch instead of a virtual call per instruction.
+// resides in the CPU, no need to mark it as a component
+class ThreadedCode {
+public:
+  using vaddr_t = isa::virtual_address_t;
+  enum class Op : uint8_t {
+#define LUCE_THREADED_OP_ENUM(_name_) k##_name_,
+    LUCE_THREADED_OP_LIST(LUCE_THREADED_OP_ENUM)
+#undef LUCE_THREADED_OP_ENUM
+  };
+  /// @note `rd` of x0 is redirected to a sink register, so handlers never
+  /// need to special-case it.
+  /// @note a fused operation replaces only the op of the first record of its
+  /// pair; the second record keeps its own, so jumping into the middle of a
+  /// pair still works.
+  struct Record {
+    Op op = Op::kTranslate;
+    uint8_t rd = 0;
+    uint8_t rs1 = 0;
+    uint8_t rs2 = 0;
+    /// sign-extended; already shifted for `lui`/`auipc`, masked for shifts
+    uint32_t imm = 0;
+  };
+  static_assert(sizeof(Record) == 8, "records are meant to stay compact");
+  /// x0 - x31, plus the sink for writes to x0
+  static constexpr size_t register_count = isa::general_purpose_register_count;
+  static constexpr uint8_t sink_register = register_count;
+  struct Statistics {
+    uint64_t translations = 0;
+    uint64_t fallbacks = 0;
+    uint64_t invalidations = 0;
+    uint64_t fusions = 0;
+  };
+
+public:
+  ThreadedCode() = default;
+  ThreadedCode(const ThreadedCode &) = delete;
+  ThreadedCode &operator=(const ThreadedCode &) = delete;
+  ThreadedCode(ThreadedCode &&) noexcept = default;
+  ThreadedCode &operator=(ThreadedCode &&) noexcept = default;
+
+public:
+  /// @brief drop every record and cover [begin, end) from now on.
+  [[clang::reinitializes]] auto reset(vaddr_t begin, vaddr_t end)
+      -> ThreadedCode &;
+  /// @brief lower again every record overlapping [addr, addr + size) on its
+  /// next visit.
+  auto invalidate(vaddr_t addr, size_t size) noexcept -> ThreadedCode &;
+  /// @brief run from the current pc until @p budget instructions retired, or
+  /// until an instruction it leaves to the reference path(system, atomic,
+  /// undecodable, faulting or outside the text segment).
+  /// @return the number of instructions retired; the pc points to the first
+  /// instruction not executed.
+  auto run(CentralProcessingUnit &, size_t budget) -> size_t;
+  /// @brief the record for a decoded instruction; `kFallback` if the
+  /// threaded engine does not execute it itself.
+  static auto lower(const isa::Descriptor &) noexcept -> Record;
+  auto statistics() const noexcept -> const Statistics & {
+    return statistics_;
+  }
+  auto to_string() const -> std::string {
+    return fmt::format("threaded code: {} translations, {} fallbacks, {} "
+                       "invalidations, {} fusions",
+                       statistics_.translations,
+                       statistics_.fallbacks,
+                       statistics_.invalidations,
+                       statistics_.fusions);
+  }
+
+private:
+  auto covers(const vaddr_t pc) const noexcept -> bool {
+    const auto offset = static_cast<size_t>(pc - base_);
+    return offset % isa::instruction_alignment == 0 &&
+           offset / isa::instruction_alignment < size_;
+  }
+  auto record_at(const vaddr_t pc) noexcept -> Record * {
+    return records_.data() + (pc - base_) / isa::instruction_alignment;
+  }
+  auto translate(CentralProcessingUnit &, vaddr_t) -> Record;
+  /// @brief fuse the freshly translated @p rec at @p pc with the instruction
+  /// after it, translating that one too if needed.
+  auto fuse(CentralProcessingUnit &, vaddr_t pc, Record *rec) -> void;
+
+private:
+  vaddr_t base_ = 0;
+  /// number of records covering the text segment
+  size_t size_ = 0;
+  /// one more than `size_`: a sentinel stops straight-line code falling off
+  /// the end of the text segment
+  std::vector<Record> records_;
+  Statistics statistics_;
+};
+} // namespace accat::luce
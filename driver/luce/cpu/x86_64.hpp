@@ -0,0 +1,324 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace accat::luce::x86_64 {
+// a minimal x86-64 assembler -- just enough encodings for the jit to emit
+// straight-line 32-bit integer code, memory accesses and side exits.
+// all jumps are relative, so the emitted code can be copied anywhere.
+enum class Reg : uint8_t {
+  rax = 0, rcx, rdx, rbx, rsp, rbp, rsi, rdi,
+  r8, r9, r10, r11, r12, r13, r14, r15,
+};
+enum class Cond : uint8_t {
+  kO = 0x0, kNO = 0x1, kB = 0x2, kAE = 0x3, kE = 0x4, kNE = 0x5, kBE = 0x6,
+  kA = 0x7, kS = 0x8, kNS = 0x9, kL = 0xC, kGE = 0xD, kLE = 0xE, kG = 0xF,
+};
+/// `/digit` of the 0x01-0x39 and 0x81 families
+enum class Alu : uint8_t {
+  kAdd = 0, kOr = 1, kAnd = 4, kSub = 5, kXor = 6, kCmp = 7,
+};
+/// `/digit` of the 0xC1 and 0xD3 families
+enum class Shift : uint8_t { kShl = 4, kShr = 5, kSar = 7 };
+enum class Width : uint8_t { kByte = 1, kHalf = 2, kWord = 4 };
+/// [base + index] or [base + disp32]
+struct Mem {
+  Reg base;
+  int32_t disp = 0;
+  bool indexed = false;
+  Reg index = Reg::rax;
+};
+inline constexpr auto at(const Reg base, const int32_t disp = 0) noexcept {
+  return Mem{.base = base, .disp = disp};
+}
+inline constexpr auto at(const Reg base, const Reg index) noexcept {
+  return Mem{.base = base, .indexed = true, .index = index};
+}
+class Assembler {
+public:
+  /// a position in the code; bound once, referenced any number of times
+  struct Label {
+    size_t id;
+  };
+
+public:
+  Assembler() = default;
+  Assembler(const Assembler &) = delete;
+  Assembler &operator=(const Assembler &) = delete;
+  Assembler(Assembler &&) noexcept = default;
+  Assembler &operator=(Assembler &&) noexcept = default;
+
+public:
+  auto code() const noexcept -> const std::vector<uint8_t> & {
+    return code_;
+  }
+  auto size() const noexcept {
+    return code_.size();
+  }
+  auto label() -> Label {
+    labels_.push_back(kUnbound);
+    return {labels_.size() - 1};
+  }
+  auto bind(const Label label) noexcept -> Assembler & {
+    labels_[label.id] = code_.size();
+    return *this;
+  }
+  /// @brief patch every reference to its label.
+  /// @return false if a referenced label was never bound
+  auto finalize() noexcept -> bool {
+    for (const auto &[offset, id] : fixups_) {
+      if (labels_[id] == kUnbound)
+        return false;
+      const auto rel = static_cast<int32_t>(labels_[id] - (offset + 4));
+      patch32(offset, static_cast<uint32_t>(rel));
+    }
+    fixups_.clear();
+    return true;
+  }
+
+public:
+  // 32-bit register/immediate forms
+  auto mov(const Reg dst, const Reg src) -> Assembler & {
+    return dst == src ? *this : rr(0x89, src, dst);
+  }
+  /// @note leaves the flags alone, unlike zero()
+  auto mov(const Reg dst, const uint32_t imm) -> Assembler & {
+    rex(false, Reg::rax, dst);
+    emit(0xB8 + low(dst));
+    return emit32(imm);
+  }
+  auto zero(const Reg dst) -> Assembler & {
+    return alu(Alu::kXor, dst, dst);
+  }
+  auto mov(const Reg dst, const Mem src) -> Assembler & {
+    return rm(0x8B, dst, src);
+  }
+  auto mov(const Mem dst, const Reg src) -> Assembler & {
+    return rm(0x89, src, dst);
+  }
+  auto mov(const Mem dst, const uint32_t imm) -> Assembler & {
+    rm(0xC7, Reg::rax, dst);
+    return emit32(imm);
+  }
+  /// 64-bit load, for pointers
+  auto mov64(const Reg dst, const Mem src) -> Assembler & {
+    return rm(0x8B, dst, src, true);
+  }
+  auto mov64(const Reg dst, const Reg src) -> Assembler & {
+    return rr(0x89, src, dst, true);
+  }
+  auto alu(const Alu op, const Reg dst, const Reg src) -> Assembler & {
+    return rr(static_cast<uint8_t>(static_cast<uint8_t>(op) << 3 | 0x01),
+              src,
+              dst);
+  }
+  auto alu(const Alu op, const Reg dst, const uint32_t imm) -> Assembler & {
+    rr(0x81, static_cast<Reg>(op), dst);
+    return emit32(imm);
+  }
+  /// `op dst, dword [mem]`
+  auto alu(const Alu op, const Reg dst, const Mem src) -> Assembler & {
+    return rm(static_cast<uint8_t>(static_cast<uint8_t>(op) << 3 | 0x03),
+              dst,
+              src);
+  }
+  auto test(const Reg lhs, const Reg rhs) -> Assembler & {
+    return rr(0x85, rhs, lhs);
+  }
+  auto shift(const Shift op, const Reg dst, const uint8_t imm) -> Assembler & {
+    rr(0xC1, static_cast<Reg>(op), dst);
+    return emit(imm);
+  }
+  /// shift by `cl`
+  auto shift(const Shift op, const Reg dst) -> Assembler & {
+    return rr(0xD3, static_cast<Reg>(op), dst);
+  }
+  auto shift64(const Shift op, const Reg dst, const uint8_t imm)
+      -> Assembler & {
+    rr(0xC1, static_cast<Reg>(op), dst, true);
+    return emit(imm);
+  }
+  auto imul(const Reg dst, const Reg src) -> Assembler & {
+    return rr2(0xAF, dst, src);
+  }
+  auto imul64(const Reg dst, const Reg src) -> Assembler & {
+    return rr2(0xAF, dst, src, true);
+  }
+  /// sign-extend 32 -> 64
+  auto movsxd(const Reg dst, const Reg src) -> Assembler & {
+    return rr(0x63, dst, src, true);
+  }
+  auto cdq() -> Assembler & {
+    return emit(0x99);
+  }
+  /// `edx:eax / src`, signed
+  auto idiv(const Reg src) -> Assembler & {
+    return rr(0xF7, static_cast<Reg>(7), src);
+  }
+  /// `edx:eax / src`, unsigned
+  auto div(const Reg src) -> Assembler & {
+    return rr(0xF7, static_cast<Reg>(6), src);
+  }
+  /// `dst = cond ? 1 : 0`; clobbers nothing but dst
+  auto set(const Cond cond, const Reg dst) -> Assembler & {
+    // REX so that sil/dil/... are addressable instead of ah/ch/...
+    rex(false, Reg::rax, dst, Reg::rax, static_cast<uint8_t>(dst) >= 4);
+    emit(0x0F).emit(0x90 | static_cast<uint8_t>(cond));
+    emit(modrm(3, 0, low(dst)));
+    return rr2(0xB6, dst, dst, false, static_cast<uint8_t>(dst) >= 4);
+  }
+  auto cmov(const Cond cond, const Reg dst, const Reg src) -> Assembler & {
+    return rr2(0x40 | static_cast<uint8_t>(cond), dst, src);
+  }
+  /// zero- or sign-extending load
+  auto load(const Width width,
+            const bool sign,
+            const Reg dst,
+            const Mem src) -> Assembler & {
+    switch (width) {
+    case Width::kByte:
+      return rm2(sign ? 0xBE : 0xB6, dst, src);
+    case Width::kHalf:
+      return rm2(sign ? 0xBF : 0xB7, dst, src);
+    case Width::kWord:
+      return mov(dst, src);
+    }
+    return *this;
+  }
+  auto store(const Width width, const Mem dst, const Reg src) -> Assembler & {
+    switch (width) {
+    case Width::kByte:
+      return rm(0x88, src, dst, false, static_cast<uint8_t>(src) >= 4);
+    case Width::kHalf:
+      emit(0x66);
+      return rm(0x89, src, dst);
+    case Width::kWord:
+      return mov(dst, src);
+    }
+    return *this;
+  }
+  auto jmp(const Label target) -> Assembler & {
+    emit(0xE9);
+    return reference(target);
+  }
+  auto j(const Cond cond, const Label target) -> Assembler & {
+    emit(0x0F).emit(0x80 | static_cast<uint8_t>(cond));
+    return reference(target);
+  }
+  auto push(const Reg reg) -> Assembler & {
+    if (ext(reg))
+      emit(0x41);
+    return emit(0x50 + low(reg));
+  }
+  auto pop(const Reg reg) -> Assembler & {
+    if (ext(reg))
+      emit(0x41);
+    return emit(0x58 + low(reg));
+  }
+  auto ret() -> Assembler & {
+    return emit(0xC3);
+  }
+
+private:
+  static constexpr auto kUnbound = static_cast<size_t>(-1);
+  static constexpr auto low(const Reg reg) noexcept -> uint8_t {
+    return static_cast<uint8_t>(reg) & 0x7;
+  }
+  static constexpr auto ext(const Reg reg) noexcept -> bool {
+    return static_cast<uint8_t>(reg) & 0x8;
+  }
+  static constexpr auto modrm(const uint8_t mod,
+                              const uint8_t reg,
+                              const uint8_t rm) noexcept -> uint8_t {
+    return static_cast<uint8_t>(mod << 6 | (reg & 0x7) << 3 | (rm & 0x7));
+  }
+  auto emit(const uint8_t byte) -> Assembler & {
+    code_.push_back(byte);
+    return *this;
+  }
+  auto emit32(const uint32_t value) -> Assembler & {
+    for (auto i = 0; i < 4; ++i)
+      emit(static_cast<uint8_t>(value >> (8 * i)));
+    return *this;
+  }
+  auto patch32(const size_t at, const uint32_t value) noexcept -> void {
+    for (auto i = 0; i < 4; ++i)
+      code_[at + i] = static_cast<uint8_t>(value >> (8 * i));
+  }
+  auto reference(const Label target) -> Assembler & {
+    fixups_.emplace_back(code_.size(), target.id);
+    return emit32(0);
+  }
+  /// @param force emit a REX even if it carries no bits, which selects
+  /// spl/bpl/sil/dil rather than ah/ch/dh/bh for byte operands
+  auto rex(const bool wide,
+           const Reg reg,
+           const Reg rm,
+           const Reg index = Reg::rax,
+           const bool force = false) -> Assembler & {
+    const uint8_t bits = (wide ? 0x08 : 0) | (ext(reg) ? 0x04 : 0) |
+                         (ext(index) ? 0x02 : 0) | (ext(rm) ? 0x01 : 0);
+    if (bits || force)
+      emit(0x40 | bits);
+    return *this;
+  }
+  /// `opcode /r` with a register operand in r/m
+  auto rr(const uint8_t opcode,
+          const Reg reg,
+          const Reg rm,
+          const bool wide = false) -> Assembler & {
+    rex(wide, reg, rm);
+    emit(opcode);
+    return emit(modrm(3, low(reg), low(rm)));
+  }
+  /// `0F opcode /r` with a register operand in r/m
+  auto rr2(const uint8_t opcode,
+           const Reg reg,
+           const Reg rm,
+           const bool wide = false,
+           const bool byte_rm = false) -> Assembler & {
+    rex(wide, reg, rm, Reg::rax, byte_rm);
+    emit(0x0F).emit(opcode);
+    return emit(modrm(3, low(reg), low(rm)));
+  }
+  auto memory_operand(const Reg reg, const Mem mem) -> Assembler & {
+    if (mem.indexed) {
+      // [base + index], disp8 of 0 when the base is rbp/r13
+      const auto needs_disp = low(mem.base) == 5;
+      emit(modrm(needs_disp ? 1 : 0, low(reg), 4));
+      emit(static_cast<uint8_t>(low(mem.index) << 3 | low(mem.base)));
+      return needs_disp ? emit(0) : *this;
+    }
+    emit(modrm(2, low(reg), low(mem.base)));
+    if (low(mem.base) == 4) // rsp/r12 need a SIB
+      emit(0x24);
+    return emit32(static_cast<uint32_t>(mem.disp));
+  }
+  /// `opcode /r` with a memory operand
+  auto rm(const uint8_t opcode,
+          const Reg reg,
+          const Mem mem,
+          const bool wide = false,
+          const bool byte_reg = false) -> Assembler & {
+    rex(wide, reg, mem.base, mem.indexed ? mem.index : Reg::rax, byte_reg);
+    emit(opcode);
+    return memory_operand(reg, mem);
+  }
+  /// `0F opcode /r` with a memory operand
+  auto rm2(const uint8_t opcode, const Reg reg, const Mem mem) -> Assembler & {
+    rex(false, reg, mem.base, mem.indexed ? mem.index : Reg::rax);
+    emit(0x0F).emit(opcode);
+    return memory_operand(reg, mem);
+  }
+
+private:
+  std::vector<uint8_t> code_;
+  /// label id -> bound offset
+  std::vector<size_t> labels_;
+  /// (offset of the rel32, label id)
+  std::vector<std::pair<size_t, size_t>> fixups_;
+};
+} // namespace accat::luce::x86_64
@@ -69,6 +69,9 @@ public:
     return std::erase_if(watchpoints_,
                          [id](const auto &wp) { return wp.id() == id; });
   }
+  auto empty() const noexcept -> bool {
+    return watchpoints_.empty();
+  }
   string_type to_string(
       const auxilia::FormatPolicy policy = auxilia::FormatPolicy::kBrief) const;
 
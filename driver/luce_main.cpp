@@ -1,6 +1,7 @@
 #include <filesystem>
 #include <functional>
 #include <memory>
+#include <string_view>
 #include <utility>
 #include "luce/Support/isa/riscv32/instruction/Atomic.hpp"
 #include "luce/config.hpp"
@@ -55,6 +56,26 @@ LUCE_API int accat::luce::main(const std::span<const std::string_view> args) {
     return callback;
   }
   spdlog::info("Image loaded from {}", std::filesystem::absolute(imagePath));
+  // each option as the monitor takes it; the first it rejects ends the run
+  using setter_t = auxilia::Status (Monitor::*)(std::string_view);
+  const std::pair<setter_t, std::string_view> options[] = {
+      {&Monitor::select_engine, argument::program::engine.value},
+      {&Monitor::set_jit_threshold, argument::program::jit_threshold.value},
+      {&Monitor::set_instruction_limit,
+       argument::program::max_instructions.value},
+      {&Monitor::set_timeout, argument::program::timeout.value},
+      {&Monitor::set_trace, argument::program::trace.value},
+      {&Monitor::set_icount, argument::program::icount.value},
+      {&Monitor::set_lockstep, argument::program::lockstep.value},
+      {&Monitor::set_hle, argument::program::hle.value},
+      {&Monitor::set_cache_dir, argument::program::cache_dir.value},
+  };
+  for (const auto &[set, value] : options)
+    if (auto res = (monitor.*set)(value); !res) {
+      spdlog::error("{}", res.message());
+      callback = EXIT_FAILURE;
+      return callback;
+    }
   if (argument::program::batch.value == true)
     callback = monitor.run().raw_code();
   else
@@ -0,0 +1,162 @@
+#include "deps.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+#include "luce/LockStep.hpp"
+#include "luce/Monitor.hpp"
+#include "luce/Support/isa/IDisassembler.hpp"
+#include "luce/Support/isa/IInstruction.hpp"
+
+namespace accat::luce {
+using auxilia::Status;
+namespace {
+/// instructions of the diverging dispatch the report shows, the last ones
+inline constexpr size_t kTrailSize = 16;
+/// dispatches between two comparisons of the whole memory; a backstop for
+/// anything writing guest memory behind MainMemory's back, which no engine
+/// does while pages are tracked
+inline constexpr size_t kFullCompareInterval = 256;
+} // namespace
+LockStep::LockStep(Monitor &monitor, const Granularity granularity)
+    : monitor_(monitor),
+      shadow_(std::make_unique<Monitor>(monitor.disassembler_)),
+      granularity_(granularity) {
+  shadow_->cpus_.shadow(true);
+}
+LockStep::~LockStep() = default;
+auto LockStep::reset() -> LockStep & {
+  auto &shadow = *shadow_;
+  shadow.process = Task(&shadow);
+  const AddressSpace &space = monitor_.process.address_space;
+  shadow.process.address_space = space;
+  shadow.process.start();
+
+  auto &from = monitor_.process.context();
+  auto &to = shadow.process.context();
+  to.program_counter.num() = from.program_counter.num();
+  to.stack_pointer.num() = from.stack_pointer.num();
+  for (auto i = 1ull; i < isa::general_purpose_register_count; ++i)
+    to.general_purpose_registers()->write_at(i) =
+        (*from.general_purpose_registers())[i];
+  // uninitialized memory is random; the shadow has to read the same. the
+  // attach below looks into the text for what it predecodes and for the
+  // routines bound by fingerprint, so it comes first.
+  shadow.memory_.mirror(monitor_.memory_);
+  shadow.cpus_.icount_shift(monitor_.cpus_.icount_shift());
+  // a native call retires as one instruction on both sides
+  shadow.cpus_.bind_routines(monitor_.cpus_.routines());
+  shadow.cpus_.attach_task(&shadow.process);
+  monitor_.memory_.track_dirty(true);
+  shadow.memory_.track_dirty(true);
+  trail_.clear();
+  return *this;
+}
+auto LockStep::prepare() -> LockStep & {
+  const Task::State state = monitor_.process.state;
+  shadow_->process.state = state;
+  return *this;
+}
+auto LockStep::check(const size_t retired) -> Status {
+  auto &shadow = *shadow_;
+  const auto start = shadow.cpus_.pc().num();
+  trail_.clear();
+  for (size_t i = 0; i < retired; ++i) {
+    // a trap or an exit stops the reference; the comparison tells if the
+    // engine went on
+    if (shadow.process.state != Task::State::kRunning)
+      break;
+    if (trail_.size() == kTrailSize)
+      trail_.erase(trail_.begin());
+    trail_.push_back(shadow.cpus_.pc().num());
+    if (auto res = shadow.cpus_.execute_shuttle(); !res)
+      return res;
+  }
+  ++statistics_.dispatches;
+  statistics_.instructions += retired;
+
+  const auto differences =
+      compare(statistics_.dispatches % kFullCompareInterval == 0);
+  if (differences.empty())
+    return {};
+
+  std::vector<std::string> trail;
+  for (const auto pc : trail_)
+    trail.push_back(disassemble(pc));
+  spdlog::error("The engine diverged from the reference path in the dispatch "
+                "from {:#010x}({} instructions). The reference stepped "
+                "through:\n  {}\nand ended up with:\n  {}",
+                start,
+                retired,
+                fmt::join(trail, "\n  "),
+                fmt::join(differences, "\n  "));
+  return auxilia::InternalError(
+      "The engine diverged from the reference path at {:#010x}", start);
+}
+auto LockStep::compare(const bool everything) -> std::vector<std::string> {
+  auto &shadow = *shadow_;
+  std::vector<std::string> differences;
+  if (const auto ours = monitor_.cpus_.pc().num(),
+      theirs = shadow.cpus_.pc().num();
+      ours != theirs)
+    differences.push_back(
+        fmt::format("pc: {:#010x}, reference {:#010x}", ours, theirs));
+  for (auto i = 1ull; i < isa::general_purpose_register_count; ++i)
+    if (const auto ours = monitor_.registers()[i],
+        theirs = shadow.registers()[i];
+        ours != theirs)
+      differences.push_back(
+          fmt::format("x{}: {:#010x}, reference {:#010x}", i, ours, theirs));
+  if (const Task::State ours = monitor_.process.state,
+      theirs = shadow.process.state;
+      ours != theirs)
+    differences.push_back(fmt::format("task state: {}, reference {}",
+                                      std::to_underlying(ours),
+                                      std::to_underlying(theirs)));
+  if (const auto ours = monitor_.process.exit_code(),
+      theirs = shadow.process.exit_code();
+      ours != theirs)
+    differences.push_back(fmt::format("exit code: {}, reference {}",
+                                      ours ? fmt::to_string(*ours) : "none",
+                                      theirs ? fmt::to_string(*theirs)
+                                             : "none"));
+
+  // the pages either side wrote, or all of them
+  auto pages = monitor_.memory_.take_dirty();
+  std::ranges::copy(shadow.memory_.take_dirty(), std::back_inserter(pages));
+  if (everything) {
+    pages.resize(monitor_.memory_.page_count());
+    std::iota(pages.begin(), pages.end(), size_t{0});
+  } else {
+    std::ranges::sort(pages);
+    pages.erase(std::ranges::unique(pages).begin(), pages.end());
+  }
+  for (const auto page : pages) {
+    ++statistics_.pages;
+    const auto ours = monitor_.memory_.page(page);
+    const auto theirs = shadow.memory_.page(page);
+    const auto [at, _] = std::ranges::mismatch(ours, theirs);
+    if (at == ours.end())
+      continue;
+    const auto offset = static_cast<size_t>(at - ours.begin());
+    differences.push_back(fmt::format(
+        "memory at {:#010x}: {:#04x}, reference {:#04x}",
+        isa::physical_memory_begin + page * isa::page_size + offset,
+        static_cast<uint8_t>(ours[offset]),
+        static_cast<uint8_t>(theirs[offset])));
+  }
+  return differences;
+}
+auto LockStep::disassemble(const vaddr_t pc) const -> std::string {
+  const auto bytes = shadow_->cpus_.fetch(pc);
+  if (!bytes)
+    return fmt::format("{:#010x}: <unreadable>", pc);
+  uint32_t num = 0;
+  std::memcpy(&num, bytes->data(), sizeof(num));
+  const auto inst = shadow_->disassembler_->disassemble(num);
+  if (!inst)
+    return fmt::format("{:#010x}: {:08x} <invalid>", pc, num);
+  return fmt::format("{:#010x}: {:08x} {}", pc, num, *inst);
+}
+} // namespace accat::luce
@@ -35,7 +35,22 @@ auto MainMemory::read_n(isa::physical_address_t addr,
 void MainMemory::_write_unchecked(isa::physical_address_t addr,
                                   std::span<const std::byte> value) noexcept {
   // TODO: implement lock(or similar) for MainMemory for atomic instructions
-  this->monitor()->cpus().check_atomic(addr, value.size());
+  // nothing to mark dirty, and no last byte to find a page for
+  if (value.empty())
+    return;
+  ++writes_;
+  if (!dirty_.empty()) [[unlikely]] {
+    const auto offset = addr - isa::physical_memory_begin;
+    for (auto page = offset / isa::page_size;
+         page <= (offset + value.size() - 1) / isa::page_size;
+         ++page)
+      if (!dirty_[page]) {
+        dirty_[page] = true;
+        dirty_pages_.push_back(page);
+      }
+  }
+  this->monitor()->cpus().check_atomic(addr, value.size()).invalidate(
+      addr, value.size());
   std::ranges::copy(value, memory.iter_at_address(addr));
 }
 auto MainMemory::write(isa::physical_address_t addr,
@@ -56,6 +71,27 @@ auto MainMemory::write_n(isa::physical_address_t addr,
   _write_unchecked(addr, value);
   return {};
 }
+auto MainMemory::track_dirty(const bool enable) -> MainMemory & {
+  dirty_pages_.clear();
+  dirty_.assign(enable ? page_count() : 0, false);
+  return *this;
+}
+auto MainMemory::take_dirty() -> std::vector<size_t> {
+  for (const auto page : dirty_pages_)
+    dirty_[page] = false;
+  return std::exchange(dirty_pages_, {});
+}
+auto MainMemory::page(const size_t index) const noexcept
+    -> std::span<const std::byte> {
+  const auto offset = index * isa::page_size;
+  return std::span{memory.data() + offset,
+                   (std::min)(isa::page_size, memory.size() - offset)};
+}
+auto MainMemory::mirror(const MainMemory &other) noexcept -> MainMemory & {
+  std::ranges::copy(other.memory,
+                    memory.iter_at_address(isa::physical_memory_begin));
+  return *this;
+}
 void MainMemory::fill(const isa::physical_address_t start,
                       const size_t size,
                       const isa::minimal_addressable_unit_t value) {
@@ -1,12 +1,19 @@
 ﻿#include "deps.hh"
 
 #include <accat/auxilia/auxilia.hpp>
+#include <array>
+#include <charconv>
+#include <filesystem>
+#include <system_error>
+#include <unordered_map>
 
 #include "luce/Monitor.hpp"
+#include "luce/LockStep.hpp"
 #include "luce/Support/isa/riscv32/Disassembler.hpp"
 #include "luce/repl/evaluation.hpp"
 #include "luce/Task.hpp"
 #include "luce/Support/utils/Pattern.hpp"
+#include "luce/Support/utils/Trace.hpp"
 #include "luce/argument/Argument.hpp"
 
 namespace accat::luce::repl {
@@ -23,6 +30,20 @@ using auxilia::Status;
 using auxilia::StatusOr;
 using fmt::fg;
 namespace {
+/// largest budget a single dispatch of `resume` gets
+inline constexpr size_t kChunkSize = size_t{1} << 16;
+/// dispatches between two looks at the wall clock
+inline constexpr size_t kClockInterval = 256;
+/// instructions retired without a write to memory or a syscall before the
+/// hart is probed for spinning; doubled after each probe that found nothing,
+/// up to `kMaxQuietFactor` times
+inline constexpr size_t kQuietInstructions = kChunkSize;
+inline constexpr size_t kMaxQuietFactor = 64;
+/// instructions a probe steps at most; longer loops go unnoticed
+inline constexpr size_t kProbeSteps = 4096;
+/// dispatches in a row retiring nothing while the task runs before the run is
+/// taken for stuck; an engine may hand back once for a block dropped under it
+inline constexpr size_t kMaxEmptyDispatches = 16;
 [[gnu::cold]] auto Die() {
   spdlog::error("REPL exited unexpectedly. The program may be unresponsive.");
   // flush the output(use osyncstream to avoid interleaving since the program
@@ -37,6 +58,11 @@ Monitor::Monitor(std::unique_ptr<isa::IDisassembler>&& disassembler)
   contract_assert(disassembler, "Disassembler cannot be null");
   disassembler_ = std::move(disassembler);
 }
+Monitor::Monitor(std::shared_ptr<isa::IDisassembler> disassembler)
+    : memory_(this), cpus_(this), debugger_(this) {
+  contract_assert(disassembler, "Disassembler cannot be null");
+  disassembler_ = std::move(disassembler);
+}
 Monitor::~Monitor() = default;
 auto Monitor::notify(Component *,
                      Event event,
@@ -52,6 +78,8 @@ auto Monitor::notify(Component *,
     } else {
       process.restart();
       cpus_.attach_task(&process);
+      if (lockstep_)
+        lockstep_->reset();
     }
     break;
   }
@@ -68,46 +96,112 @@ auto Monitor::notify(Component *,
 Status Monitor::run() {
 
   process.start();
-  cpus_.attach_task(&process);
+  // nobody looks into a batch run but between dispatches
+  cpus_.lazy_state(true).attach_task(&process);
+  if (lockstep_)
+    lockstep_->reset();
+  defer {
+    if (auto res = cpus_.persist(); !res)
+      spdlog::warn("{}", res.message());
+    spdlog::info("{}", cpus_.statistics());
+    if (lockstep_)
+      spdlog::info("{}", lockstep_->to_string());
+  };
 
-  return resume();
+  auto res = resume();
+  // one line for scripts to parse, whatever happened
+  const auto exit_code = process.exit_code();
+  fmt::println("luce: reason={} instructions={} seconds={:.6f} exit-code={}",
+               to_string(report_.reason),
+               report_.instructions,
+               report_.elapsed.count(),
+               exit_code ? fmt::to_string(*exit_code) : "none"s);
+  return res;
 }
 auto Monitor::resume() -> Status {
-  // prevent infinite loop for debugging
-  int epoch = 0;
-  while (process.state != Task::State::kTerminated or
-         process.state != Task::State::kPaused) {
-    if (epoch++ >= 100) {
-      spdlog::critical("To prevent infinite loop, program paused.");
-      this->notify(nullptr, Event::kPauseTask);
-
-      if (!argument::program::batch.value)
-        // not batch mode, back to REPL
-        return {};
-      else {
-        fmt::println(stdout,
-                     "Press `r` to resume the program, or any other key to "
-                     "exit the program.");
-
-        if (auto c = ::getchar(); c == 'r') {
-          this->notify(nullptr, Event::kRestartOrResumeTask);
-          epoch = 0;
-          continue;
-        }
-        spdlog::info("Exiting program.");
-        return {};
-      }
+  using clock_type = std::chrono::steady_clock;
+  if (process.state == Task::State::kReady)
+    process.state = Task::State::kRunning;
+
+  const auto start = clock_type::now();
+  const auto deadline =
+      timeout_ > timeout_.zero()
+          ? start + std::chrono::duration_cast<clock_type::duration>(timeout_)
+          : clock_type::time_point::max();
+  report_ = {};
+  idle_ = {.effects = _effects(), .threshold = kQuietInstructions};
+  defer {
+    report_.elapsed = clock_type::now() - start;
+    spdlog::info("Stopped after {} instructions: {}",
+                 report_.instructions,
+                 to_string(report_.reason));
+  };
+  for (size_t dispatches = 0;; ++dispatches) {
+    if (process.state == Task::State::kTerminated) {
+      report_.reason = ExitReason::kExited;
+      return {};
+    }
+    if (process.state == Task::State::kPaused) {
+      report_.reason = ExitReason::kPaused;
+      return {};
+    }
+    if (max_instructions_ && report_.instructions >= max_instructions_) {
+      report_.reason = ExitReason::kInstructionLimit;
+      return {};
+    }
+    if (dispatches % kClockInterval == 0 && clock_type::now() >= deadline) {
+      report_.reason = ExitReason::kTimeout;
+      return {};
     }
+    auto budget = kChunkSize;
+    if (max_instructions_)
+      budget = (std::min)(budget, max_instructions_ - report_.instructions);
 
-    if (auto res = cpus_.execute_shuttle(); !res) {
-      return res;
+    auto res = _do_dispatch_unchecked(budget);
+    if (!res) {
+      report_.reason = ExitReason::kError;
+      return res.as_status();
     }
+    report_.instructions += *res;
+
+    if (const auto effects = _effects(); effects != idle_.effects) {
+      idle_ = {.effects = effects, .threshold = kQuietInstructions};
+      continue;
+    }
+    // watchpoints may see what a probe would skip, and the reference path
+    // would never see it
+    if ((idle_.quiet += *res) < idle_.threshold ||
+        !debugger_.watchpoints().empty() || lockstep_)
+      continue;
+    auto idle = _do_probe_idle_unchecked();
+    if (!idle) {
+      report_.reason = ExitReason::kError;
+      return idle.as_status();
+    }
+    if (*idle) {
+      spdlog::info("Idle at {:#010x}: the hart spins with nothing left to "
+                   "wake it",
+                   cpus_.pc().num());
+      // no timer or interrupt is ever pending, so the next event is the end
+      // of the run; spinning up to the limit would change nothing
+      if (max_instructions_) {
+        report_.instructions = max_instructions_;
+        report_.reason = ExitReason::kInstructionLimit;
+      } else {
+        report_.reason = ExitReason::kIdle;
+      }
+      return {};
+    }
+    idle_ = {.effects = _effects(),
+             .threshold = (std::min)(idle_.threshold * 2,
+                                     kQuietInstructions * kMaxQuietFactor)};
   }
-  return {};
 }
 Status Monitor::REPL() {
   process.start();
-  cpus_.attach_task(&process);
+  cpus_.lazy_state(false).attach_task(&process);
+  if (lockstep_)
+    lockstep_->reset();
 
   for (auto res : repl::repl(this) | std::views::common) {
     if (res)
@@ -121,8 +215,36 @@ Status Monitor::REPL() {
   [[unlikely]] return Die();
 }
 
+auto Monitor::_do_probe_idle_unchecked() -> StatusOr<bool> {
+  // nothing outside the hart changes its state: no timer, no interrupt, no
+  // other hart. a state it comes back to, with no write to memory and no
+  // syscall on the way, is a loop it never leaves.
+  using registers_t = std::array<uint32_t, isa::general_purpose_register_count>;
+  const auto effects = _effects();
+  std::unordered_map<vaddr_t, registers_t> seen;
+  for (size_t step = 0; step < kProbeSteps; ++step) {
+    if (process.state != Task::State::kRunning ||
+        (max_instructions_ && report_.instructions >= max_instructions_))
+      return false;
+    registers_t now;
+    for (size_t i = 0; i < now.size(); ++i)
+      now[i] = registers()[i];
+    if (auto [it, fresh] = seen.try_emplace(cpus_.pc().num(), now); !fresh) {
+      if (it->second == now)
+        return true;
+      it->second = now;
+    }
+    // through the reference path, which counts every store
+    if (auto res = cpus_.execute_shuttle(); !res)
+      return {std::move(res)};
+    ++report_.instructions;
+    if (_effects() != effects)
+      return false;
+  }
+  return false;
+}
 Status Monitor::_do_execute_n_unchecked(const size_t steps) {
-  for ([[maybe_unused]] auto _ : std::views::iota(0ull, steps)) {
+  for (size_t retired = 0; retired < steps;) {
     if (process.state == Task::State::kTerminated) {
       spdlog::info("Program has terminated.");
       return {};
@@ -131,15 +253,42 @@ Status Monitor::_do_execute_n_unchecked(const size_t steps) {
       spdlog::info("Program is paused. Press `r` to resume.");
       return {};
     }
-    if (auto res = cpus_.execute_shuttle(); !res)
-      return res;
-    this->debugger_.update_watchpoints(
-        argument::program::batch.value ? false // don't notify(keep running)
-                                       : true  // notify and pause if wp changed
-    );
+    auto res = _do_dispatch_unchecked(steps - retired);
+    if (!res)
+      return res.as_status();
+    retired += *res;
   }
   return {};
 }
+auto Monitor::_do_dispatch_unchecked(const size_t budget) -> StatusOr<size_t> {
+  // watchpoints are checked between dispatches; keep them precise
+  const auto precise =
+      !debugger_.watchpoints().empty() ||
+      (lockstep_ &&
+       lockstep_->granularity() == LockStep::Granularity::kInstruction);
+  if (lockstep_)
+    lockstep_->prepare();
+  const auto res = cpus_.dispatch(precise ? size_t{1} : budget);
+  if (!res)
+    return res;
+  if (lockstep_)
+    if (auto checked = lockstep_->check(*res); !checked)
+      return {std::move(checked)};
+  this->debugger_.update_watchpoints(
+      argument::program::batch.value ? false // don't notify(keep running)
+                                     : true  // notify and pause if wp changed
+  );
+  // the callers loop until the task stops or enough retired; a dispatch that
+  // does neither, again and again, would keep them there forever
+  if (*res != 0 || process.state != Task::State::kRunning)
+    empty_dispatches_ = 0;
+  else if (++empty_dispatches_ > kMaxEmptyDispatches)
+    return auxilia::InternalError(
+        "No instruction retired in {} dispatches at {:#010x}",
+        empty_dispatches_,
+        cpus_.pc().num());
+  return *res;
+}
 Status Monitor::execute_n(const size_t steps) {
   if (process.state == Task::State::kReady) {
     process.state = Task::State::kRunning;
@@ -149,6 +298,143 @@ Status Monitor::execute_n(const size_t steps) {
   }
   return _do_execute_n_unchecked(steps);
 }
+Status Monitor::select_engine(const std::string_view name) {
+  using enum isa::Icpu::Engine;
+  if (name == "step")
+    cpus_.select_engine(kStep);
+  else if (name == "block")
+    cpus_.select_engine(kBlock);
+  else if (name == "threaded")
+    cpus_.select_engine(kThreaded);
+  else if (name == "jit")
+    cpus_.select_engine(kJit);
+  else if (name == "aot")
+    cpus_.select_engine(kAot);
+  else
+    return auxilia::InvalidArgumentError("Unknown execution engine '{}'; "
+                                         "expected one of: step, block, "
+                                         "threaded, jit, aot",
+                                         name);
+
+  if (name == "jit" && !JitCompiler::available)
+    spdlog::warn("No jit for this host; hot blocks stay interpreted.");
+  if (name == "aot" && !aot::installed())
+    spdlog::warn("Nothing translated ahead of time is linked in; build the "
+                 "image with luce-aot. Every block stays interpreted.");
+  spdlog::info("Execution engine: {}", name);
+  return {};
+}
+Status Monitor::set_jit_threshold(const std::string_view count) {
+  size_t threshold = 0;
+  const auto [ptr, ec] =
+      std::from_chars(count.data(), count.data() + count.size(), threshold);
+  if (ec != std::errc{} || ptr != count.data() + count.size())
+    return auxilia::InvalidArgumentError(
+        "Invalid jit threshold '{}'; expected a number of executions", count);
+
+  cpus_.jit_threshold(threshold);
+  return {};
+}
+Status Monitor::set_instruction_limit(const std::string_view count) {
+  size_t limit = 0;
+  const auto [ptr, ec] =
+      std::from_chars(count.data(), count.data() + count.size(), limit);
+  if (ec != std::errc{} || ptr != count.data() + count.size())
+    return auxilia::InvalidArgumentError(
+        "Invalid instruction limit '{}'; expected a number of instructions",
+        count);
+
+  max_instructions_ = limit;
+  return {};
+}
+Status Monitor::set_timeout(const std::string_view seconds) {
+  double limit = 0;
+  const auto [ptr, ec] =
+      std::from_chars(seconds.data(), seconds.data() + seconds.size(), limit);
+  if (ec != std::errc{} || ptr != seconds.data() + seconds.size() ||
+      !(limit >= 0))
+    return auxilia::InvalidArgumentError(
+        "Invalid timeout '{}'; expected a number of seconds", seconds);
+
+  timeout_ = std::chrono::duration<double>{limit};
+  return {};
+}
+Status Monitor::set_trace(const std::string_view categories) {
+  auto enabled = trace::parse(categories);
+  if (!enabled)
+    return enabled.as_status();
+
+  if (!trace::compiled && *enabled != trace::Category::kNone)
+    spdlog::warn("Tracing is compiled out of this build; nothing will be "
+                 "traced.");
+  trace::enable(*enabled);
+  return {};
+}
+Status Monitor::set_icount(const std::string_view shift) {
+  // the host clock
+  if (shift.empty()) {
+    cpus_.icount_shift(std::nullopt);
+    return {};
+  }
+  // 2^32 ns a cycle is over four seconds; nobody wants a slower clock
+  constexpr uint8_t kMaxShift = 32;
+  uint8_t value = 0;
+  const auto [ptr, ec] =
+      std::from_chars(shift.data(), shift.data() + shift.size(), value);
+  if (ec != std::errc{} || ptr != shift.data() + shift.size() ||
+      value > kMaxShift)
+    return auxilia::InvalidArgumentError(
+        "Invalid icount shift '{}'; expected 0 to {}", shift, kMaxShift);
+
+  cpus_.icount_shift(value);
+  spdlog::info("Guest time: {} ns per instruction", uint64_t{1} << value);
+  return {};
+}
+Status Monitor::set_lockstep(const std::string_view granularity) {
+  using enum LockStep::Granularity;
+  if (granularity.empty())
+    lockstep_.reset();
+  else if (granularity == "block")
+    lockstep_ = std::make_unique<LockStep>(*this, kBlock);
+  else if (granularity == "instruction")
+    lockstep_ = std::make_unique<LockStep>(*this, kInstruction);
+  else
+    return auxilia::InvalidArgumentError("Unknown lock-step granularity '{}'; "
+                                         "expected block or instruction",
+                                         granularity);
+
+  if (lockstep_ && !cpus_.icount_shift())
+    spdlog::warn("Guest time follows the host clock; reads of it may diverge "
+                 "without --icount.");
+  if (lockstep_)
+    spdlog::info("Lock-step against the reference path, per {}", granularity);
+  return {};
+}
+Status Monitor::set_hle(const std::string_view specs) {
+  auto bindings = hle::parse(specs);
+  if (!bindings)
+    return bindings.as_status();
+
+  cpus_.bind_routines(*bindings);
+  return {};
+}
+Status Monitor::set_cache_dir(const std::string_view directory) {
+  if (directory.empty()) {
+    cpus_.cache_dir({});
+    return {};
+  }
+  const auto path = std::filesystem::path{directory};
+  std::error_code ec;
+  std::filesystem::create_directories(path, ec);
+  if (ec)
+    return auxilia::InvalidArgumentError(
+        "Cannot use '{}' as the cache directory: {}", directory, ec.message());
+
+  cpus_.cache_dir(path);
+  spdlog::info("Keeping decoded text and block profiles in {}",
+               path.string());
+  return {};
+}
 auto Monitor::_do_register_task_unchecked(
     const std::span<const std::byte> bytes,
     const paddr_t start_addr,
@@ -0,0 +1,408 @@
+#include "deps.hh"
+
+#include "luce/cpu/aot.hpp"
+#include <algorithm>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <fmt/format.h>
+#include "luce/cpu/cpu.hpp"
+#include "luce/Monitor.hpp"
+#include "luce/Support/isa/riscv32/DecodeTable.hpp"
+
+namespace accat::luce {
+namespace aot {
+namespace {
+using Op = ir::Op;
+/// zero-initialized, so registrations running before this unit initializes
+/// still find it
+const Program *installed_program = nullptr;
+constexpr std::string_view kOpNames[] = {
+#define LUCE_AOT_OP_NAME(_name_) "k" #_name_,
+    LUCE_THREADED_OP_LIST(LUCE_AOT_OP_NAME)
+#undef LUCE_AOT_OP_NAME
+};
+constexpr auto NameOf(const Op op) noexcept {
+  return kOpNames[static_cast<size_t>(op)];
+}
+/// the extensions the default disassembler registers
+constexpr auto kExtensions = isa::riscv32::compiled_extensions;
+constexpr auto IsBranch(const Op op) noexcept {
+  switch (op) {
+  case Op::kBeq:
+  case Op::kBne:
+  case Op::kBlt:
+  case Op::kBge:
+  case Op::kBltu:
+  case Op::kBgeu:
+    return true;
+  default:
+    return false;
+  }
+}
+constexpr auto IsTerminator(const Op op) noexcept {
+  return IsBranch(op) || op == Op::kJal || op == Op::kJalr;
+}
+/// the condition a branch takes its target on, over `x`
+auto ConditionOf(const ir::Record &record) -> std::string {
+  const auto lhs = fmt::format("x[{}]", record.rs1);
+  const auto rhs = fmt::format("x[{}]", record.rs2);
+  const auto slhs = fmt::format("static_cast<int32_t>({})", lhs);
+  const auto srhs = fmt::format("static_cast<int32_t>({})", rhs);
+  // clang-format off
+  switch (record.op) {
+  case Op::kBeq:  return fmt::format("{} == {}", lhs, rhs);
+  case Op::kBne:  return fmt::format("{} != {}", lhs, rhs);
+  case Op::kBlt:  return fmt::format("{} < {}", slhs, srhs);
+  case Op::kBge:  return fmt::format("{} >= {}", slhs, srhs);
+  case Op::kBltu: return fmt::format("{} < {}", lhs, rhs);
+  case Op::kBgeu: return fmt::format("{} >= {}", lhs, rhs);
+  default:        return "false";
+  }
+  // clang-format on
+}
+/// the type a load or store moves, as the threaded engine reads it
+constexpr auto AccessOf(const Op op) noexcept -> std::string_view {
+  // clang-format off
+  switch (op) {
+  case Op::kLb:  return "int8_t";
+  case Op::kLh:  return "int16_t";
+  case Op::kLbu: case Op::kSb: return "uint8_t";
+  case Op::kLhu: case Op::kSh: return "uint16_t";
+  default:       return "uint32_t";
+  }
+  // clang-format on
+}
+/// @brief the body of a block, one statement per operation left.
+auto Emit(const ir::Block &block) -> std::string {
+  std::string body;
+  auto out = std::back_inserter(body);
+  for (const auto &[record, pc, index, next] : block.operations) {
+    const auto fallthrough = pc + isa::instruction_size_bytes;
+    const auto address =
+        fmt::format("x[{}] + {:#x}u", record.rs1, record.imm);
+    fmt::format_to(
+        out, "  // {:#010x}: {}\n", pc, NameOf(record.op).substr(1));
+    if (ir::is_pure(record.op)) {
+      fmt::format_to(out,
+                     "  x[{}] = aot::evaluate(Op::{}, {:#x}u, {:#010x}u, "
+                     "x[{}], x[{}]);\n",
+                     record.rd,
+                     NameOf(record.op),
+                     record.imm,
+                     pc,
+                     record.rs1,
+                     record.rs2);
+      continue;
+    }
+    switch (record.op) {
+    case Op::kLb:
+    case Op::kLh:
+    case Op::kLw:
+    case Op::kLbu:
+    case Op::kLhu:
+      fmt::format_to(out,
+                     "  if (!AotRuntime::load<{}>(f, {}, x[{}]))\n"
+                     "    return f.leave({:#010x}u, {});\n",
+                     AccessOf(record.op),
+                     address,
+                     record.rd,
+                     pc,
+                     index);
+      break;
+    case Op::kSb:
+    case Op::kSh:
+    case Op::kSw:
+      fmt::format_to(out,
+                     "  if (!AotRuntime::store<{}>(f, {}, x[{}]))\n"
+                     "    return f.leave({:#010x}u, {});\n"
+                     "  if (f.stale)\n"
+                     "    return f.leave({:#010x}u, {});\n",
+                     AccessOf(record.op),
+                     address,
+                     record.rs2,
+                     pc,
+                     index,
+                     fallthrough,
+                     index + 1);
+      break;
+    case Op::kJal:
+      fmt::format_to(out,
+                     "  x[{}] = {:#010x}u;\n"
+                     "  return f.leave({:#010x}u, {});\n",
+                     record.rd,
+                     fallthrough,
+                     pc + record.imm,
+                     block.size);
+      break;
+    case Op::kJalr:
+      // the target first: `rd` may be `rs1`
+      fmt::format_to(out,
+                     "  const auto target = ({}) & ~1u;\n"
+                     "  x[{}] = {:#010x}u;\n"
+                     "  return f.leave(target, {});\n",
+                     address,
+                     record.rd,
+                     fallthrough,
+                     block.size);
+      break;
+    default: // branches
+      fmt::format_to(out,
+                     "  return f.leave({} ? {:#010x}u : {:#010x}u, {});\n",
+                     ConditionOf(record),
+                     pc + record.imm,
+                     fallthrough,
+                     block.size);
+      break;
+    }
+  }
+  if (block.operations.empty() ||
+      !IsTerminator(block.operations.back().record.op))
+    fmt::format_to(
+        out, "  return f.leave({:#010x}u, {});\n", block.end, block.size);
+  return body;
+}
+} // namespace
+
+auto install(const Program &program) noexcept -> void {
+  installed_program = &program;
+}
+auto installed() noexcept -> const Program * {
+  return installed_program;
+}
+auto translate(const std::span<const std::byte> text, const vaddr_t base)
+    -> std::string {
+  const auto count = text.size() / isa::instruction_size_bytes;
+  std::vector<ir::Record> records(count);
+  for (size_t i = 0; i < count; ++i) {
+    // guest words are little-endian, whatever the host
+    uint32_t num = 0;
+    for (size_t byte = isa::instruction_size_bytes; byte-- > 0;)
+      num = num << 8 |
+            static_cast<uint8_t>(text[i * isa::instruction_size_bytes + byte]);
+    records[i] = ThreadedCode::lower(
+        isa::riscv32::decode_table.describe(num, kExtensions));
+  }
+  auto pc_of = [&](const size_t i) {
+    return static_cast<uint32_t>(base + i * isa::instruction_size_bytes);
+  };
+  // blocks start wherever control may arrive from elsewhere: jump targets and
+  // whatever follows a jump, e.g. the return address of a call
+  std::vector<bool> leaders(count);
+  if (count)
+    leaders[0] = true;
+  for (size_t i = 0; i < count; ++i) {
+    const auto &record = records[i];
+    if (IsBranch(record.op) || record.op == Op::kJal) {
+      const auto target = static_cast<size_t>(pc_of(i) + record.imm - base);
+      if (target % isa::instruction_size_bytes == 0 &&
+          target / isa::instruction_size_bytes < count)
+        leaders[target / isa::instruction_size_bytes] = true;
+    }
+    if ((IsTerminator(record.op) || record.op == Op::kFallback) &&
+        i + 1 < count)
+      leaders[i + 1] = true;
+  }
+
+  ir::Optimizer optimizer;
+  std::string blocks;
+  std::string entries;
+  for (size_t leader = 0; leader < count; ++leader) {
+    if (!leaders[leader] || records[leader].op == Op::kFallback)
+      continue;
+    // straight on past other leaders, as the block engine does
+    ir::Block block;
+    for (auto i = leader; i < count && block.size < max_block_size; ++i) {
+      if (records[i].op == Op::kFallback)
+        break;
+      block.operations.push_back({.record = records[i],
+                                  .pc = pc_of(i),
+                                  .index = block.size++});
+      if (IsTerminator(records[i].op))
+        break;
+    }
+    block.end = pc_of(leader + block.size);
+    optimizer.run(block);
+
+    const auto start = pc_of(leader);
+    fmt::format_to(std::back_inserter(blocks),
+                   "// [{:#010x}, {:#010x})\n"
+                   "void block_{:08x}(Frame &f) {{\n"
+                   "  [[maybe_unused]] auto *const x = f.x;\n"
+                   "{}}}\n",
+                   start,
+                   block.end,
+                   start,
+                   Emit(block));
+    fmt::format_to(std::back_inserter(entries),
+                   "    {{{:#010x}u, {}, &block_{:08x}}},\n",
+                   start,
+                   block.size,
+                   start);
+  }
+  return fmt::format(
+      "// translated by luce-aot from the {size}-byte text segment at "
+      "{base:#010x}; do not edit.\n"
+      "// {stats}\n"
+      "#include <cstdint>\n"
+      "#include \"luce/cpu/aot.hpp\"\n"
+      "\n"
+      "namespace {{\n"
+      "using namespace accat::luce;\n"
+      "using aot::Frame;\n"
+      "using Op = ThreadedCode::Op;\n"
+      "{blocks}"
+      "constexpr aot::Entry kEntries[] = {{\n"
+      "{entries}"
+      "}};\n"
+      "constexpr aot::Program kProgram{{\n"
+      "    .base = {base:#010x}u,\n"
+      "    .size = {size}u,\n"
+      "    .checksum = {checksum:#018x}u,\n"
+      "    .entries = kEntries,\n"
+      "}};\n"
+      "const aot::Registration registration{{kProgram}};\n"
+      "}} // namespace\n",
+      fmt::arg("size", text.size()),
+      fmt::arg("base", base),
+      fmt::arg("stats", optimizer.to_string()),
+      fmt::arg("blocks", blocks),
+      fmt::arg("entries", entries),
+      fmt::arg("checksum", checksum(text)));
+}
+} // namespace aot
+
+auto AotRuntime::reset(CentralProcessingUnit &cpu) -> AotRuntime & {
+  program_ = nullptr;
+  entries_.clear();
+  reach_ = 0;
+  dropped_ = false;
+  statistics_ = {};
+
+  const auto program = aot::installed();
+  if (!program)
+    return *this;
+  const auto &text = cpu.task_->text_segment();
+  const auto bytes = cpu.monitor()->memory().read_n(
+      cpu.mmu_.virtual_to_physical(text.start), text.end - text.start);
+  if (program->base != text.start || program->size != text.end - text.start ||
+      !bytes || program->checksum != aot::checksum(*bytes)) {
+    spdlog::warn("The program translated ahead of time is not the one "
+                 "loaded; running it without.");
+    return *this;
+  }
+  program_ = program;
+  entries_.assign(program->size / isa::instruction_alignment, nullptr);
+  for (const auto &entry : program->entries) {
+    entries_[(entry.start - program->base) / isa::instruction_alignment] =
+        &entry;
+    reach_ = (std::max)(reach_,
+                        size_t{entry.size} * isa::instruction_size_bytes);
+  }
+  statistics_.blocks = program->entries.size();
+  return *this;
+}
+auto AotRuntime::invalidate(const vaddr_t addr, const size_t size) noexcept
+    -> AotRuntime & {
+  if (!program_ || size == 0)
+    return *this;
+  const auto begin = static_cast<size_t>(program_->base);
+  const auto end = begin + entries_.size() * isa::instruction_alignment;
+  const auto first = static_cast<size_t>(addr);
+  const auto last = first + size;
+  if (last <= begin || first >= end)
+    return *this;
+
+  // blocks starting up to `reach_` before the store may run into it
+  const auto from =
+      ((std::max)(first, begin + reach_) - reach_ - begin) /
+      isa::instruction_alignment;
+  const auto to =
+      ((std::min)(last, end) - begin + isa::instruction_alignment - 1) /
+      isa::instruction_alignment;
+  for (auto i = from; i < to; ++i) {
+    const auto entry = entries_[i];
+    if (!entry ||
+        entry->start + entry->size * isa::instruction_size_bytes <= first)
+      continue;
+    entries_[i] = nullptr;
+    dropped_ = true;
+    ++statistics_.invalidations;
+  }
+  return *this;
+}
+auto AotRuntime::run(CentralProcessingUnit &cpu, const size_t budget)
+    -> size_t {
+  if (!program_)
+    return 0;
+  auto &ctx = cpu.task_->context();
+  // the routines run natively are left to the reference path
+  const auto next = [&](const vaddr_t pc) {
+    return cpu.hle_.covers(pc) ? nullptr : lookup(pc);
+  };
+  auto entry = next(ctx.program_counter.num());
+  if (!entry)
+    return 0;
+
+  auto &gpr = *ctx.general_purpose_registers();
+  aot::Frame frame{.cpu = &cpu};
+  for (auto i = 1ull; i < ThreadedCode::register_count; ++i)
+    frame.x[i] = gpr[i];
+  frame.pc = ctx.program_counter.num();
+
+  size_t retired = 0;
+  // a block cut short by the budget is left to the interpreter
+  while (entry && entry->size <= budget - retired) {
+    frame.retired = 0;
+    frame.stale = false;
+    entry->block(frame);
+    ++statistics_.native_runs;
+    retired += frame.retired;
+    if (frame.retired != entry->size) {
+      ++statistics_.side_exits;
+      break;
+    }
+    entry = next(frame.pc);
+  }
+  for (auto i = 1ull; i < ThreadedCode::register_count; ++i)
+    gpr.write_at(i) = frame.x[i];
+  ctx.program_counter.num() = frame.pc;
+  return retired;
+}
+template <typename T>
+auto AotRuntime::load(aot::Frame &frame, const uint32_t addr, uint32_t &rd)
+    -> bool {
+  T value;
+  if (!frame.cpu->load(addr, value)) [[unlikely]]
+    return false;
+  rd = static_cast<uint32_t>(value);
+  return true;
+}
+template <typename T>
+auto AotRuntime::store(aot::Frame &frame,
+                       const uint32_t addr,
+                       const uint32_t value) -> bool {
+  auto &cpu = *frame.cpu;
+  if (!cpu.store(addr, static_cast<T>(value))) [[unlikely]]
+    return false;
+  // the write went through `invalidate`, which may have dropped blocks
+  frame.stale = std::exchange(cpu.aot_.dropped_, false);
+  return true;
+}
+template auto AotRuntime::load<int8_t>(aot::Frame &, uint32_t, uint32_t &)
+    -> bool;
+template auto AotRuntime::load<int16_t>(aot::Frame &, uint32_t, uint32_t &)
+    -> bool;
+template auto AotRuntime::load<uint8_t>(aot::Frame &, uint32_t, uint32_t &)
+    -> bool;
+template auto AotRuntime::load<uint16_t>(aot::Frame &, uint32_t, uint32_t &)
+    -> bool;
+template auto AotRuntime::load<uint32_t>(aot::Frame &, uint32_t, uint32_t &)
+    -> bool;
+template auto AotRuntime::store<uint8_t>(aot::Frame &, uint32_t, uint32_t)
+    -> bool;
+template auto AotRuntime::store<uint16_t>(aot::Frame &, uint32_t, uint32_t)
+    -> bool;
+template auto AotRuntime::store<uint32_t>(aot::Frame &, uint32_t, uint32_t)
+    -> bool;
+} // namespace accat::luce
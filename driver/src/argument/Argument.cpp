@@ -14,8 +14,57 @@ Flag testing = {{"--testing", "-t"},
                 "Enable testing mode(nothing but exit immediately)"};
 Single log = {{"--log", "-l"}, "Enable logging"};
 Single image = {{"--image", "-i"}, "Path to the image file"};
+Single engine = {{"--engine", "-e"},
+                 "Execution engine: step(one instruction per dispatch), "
+                 "block(one basic block per dispatch), threaded(lowered "
+                 "records, direct-threaded dispatch), jit(hot basic blocks "
+                 "as native code) or aot(blocks translated by luce-aot)",
+                 "step"};
+Single jit_threshold = {{"--jit-threshold", "-j"},
+                        "Executions of a basic block before the jit engine "
+                        "compiles it",
+                        "16"};
+Single max_instructions = {{"--max-instructions", "-n"},
+                           "Instructions to run before stopping, 0 for no "
+                           "limit",
+                           "0"};
+Single timeout = {{"--timeout", "-T"},
+                  "Wall-clock seconds to run before stopping, 0 for no limit",
+                  "0"};
+Single trace = {{"--trace", "-x"},
+                "Comma-separated trace categories: fetch, decode, execute, "
+                "timing or all"};
+Single icount = {{"--icount", "-c"},
+                 "Guest time from retired instructions instead of the host "
+                 "clock, each taking 2^N nanoseconds; runs then repeat bit "
+                 "for bit"};
+Single lockstep = {{"--lockstep", "-d"},
+                   "Replay every dispatch through the reference interpreter "
+                   "and stop at the first divergence: block(compare after "
+                   "each dispatch) or instruction(one instruction a "
+                   "dispatch)"};
+Single hle = {{"--hle", "-H"},
+              "Comma-separated guest routines to run natively: memcpy, "
+              "memset, strlen or memcmp, each @address(of its symbol) or "
+              "=fingerprint(its first bytes in hex, ?? for any)"};
+Single cache_dir = {{"--cache-dir", "-C"},
+                    "Directory to keep the decoded text and the block "
+                    "profiles of each image in, for its next run to start "
+                    "warm"};
 std::span<Argument *> args() {
-  static Argument *args_array[] = {&batch, &testing, &log, &image};
+  static Argument *args_array[] = {&batch,
+                                   &testing,
+                                   &log,
+                                   &image,
+                                   &engine,
+                                   &jit_threshold,
+                                   &max_instructions,
+                                   &timeout,
+                                   &trace,
+                                   &icount,
+                                   &lockstep,
+                                   &hle,
+                                   &cache_dir};
   return {args_array};
 }
 } // namespace program
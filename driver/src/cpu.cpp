@@ -2,6 +2,7 @@
 
 #include "luce/cpu/cpu.hpp"
 #include <algorithm>
+#include <tuple>
 #include "luce/Support/isa/IInstruction.hpp"
 #include "luce/Support/isa/IDisassembler.hpp"
 #include "luce/Monitor.hpp"
@@ -12,6 +13,47 @@ using auxilia::Status;
 using auxilia::StatusOr;
 using CPU = CentralProcessingUnit;
 using enum CPU::State;
+using Op = ThreadedCode::Op;
+namespace {
+/// longest run of instructions translated into one block
+inline constexpr size_t kMaxBlockSize = 64;
+/// executions after which the target of a backward jump starts a trace;
+/// below the default jit threshold, so loops are traced before compiled
+inline constexpr size_t kTraceThreshold = 8;
+/// longest trace, in blocks and in instructions
+inline constexpr size_t kMaxTraceBlocks = 16;
+inline constexpr size_t kMaxTraceSize = 256;
+inline constexpr uint64_t kNanosecondsPerSecond = 1'000'000'000;
+/// whether the instruction transfers control (or traps), which ends a block
+constexpr auto IsBlockTerminator(const isa::instruction_size_t num) noexcept {
+  switch (isa::Word::extractBits<0, 7>(num)) {
+  case 0b1100011: // branch
+  case 0b1101111: // jal
+  case 0b1100111: // jalr
+  case 0b1110011: // ecall, ebreak
+    return true;
+  default:
+    return false;
+  }
+}
+/// `ra` or `t0`, which the calling convention links through
+constexpr auto IsLinkRegister(const uint32_t reg) noexcept {
+  return reg == 1 || reg == 5;
+}
+/// whether the instruction reads the pc, so it has to be there beforehand
+constexpr auto ReadsPc(const isa::instruction_size_t num) noexcept {
+  return IsBlockTerminator(num) ||
+         isa::Word::extractBits<0, 7>(num) == 0b0010111; // auipc
+}
+/// whether the status ends up in a trap, which reads the instruction back
+constexpr auto Traps(const isa::IInstruction::ExecutionStatus status) noexcept {
+  using enum isa::IInstruction::ExecutionStatus;
+  return status != kOk && status != kOkButDontBotherPC && status != kEnvCall;
+}
+constexpr auto IsJalr(const isa::instruction_size_t num) noexcept {
+  return isa::Word::extractBits<0, 7>(num) == 0b1100111;
+}
+} // namespace
 
 CPU::CentralProcessingUnit(Mediator *parent)
     : Icpu(parent), task_{nullptr}, mmu_(this) {}
@@ -29,19 +71,400 @@ auto CPU::detach_task() noexcept -> CPU & {
 Status CPU::execute_shuttle() {
   precondition(task_, "No program to execute")
 
-  auto executeShuttle = [&]() {
+  trace_ = trace::enabled();
+
+  state_ = kRunning;
+  defer {
+    state_ = kVacant;
+  };
+  auto res = shuttle();
+  if (res)
+    ++instret_;
+  return res;
+}
+auto CPU::dispatch(const size_t budget) -> StatusOr<size_t> {
+  precondition(task_, "No program to execute")
+  precondition(budget > 0, "Dispatching with an empty budget")
+
+  trace_ = trace::enabled();
+  [[maybe_unused]] const auto start = task_->context().program_counter.num();
+  auto executeEngine = [&]() -> StatusOr<size_t> {
     state_ = kRunning;
     defer {
       state_ = kVacant;
     };
-    return shuttle();
+    switch (options_.engine) {
+    case Engine::kStep:
+      if (auto res = shuttle(); !res)
+        return {std::move(res)};
+      return size_t{1};
+    case Engine::kThreaded:
+      return execute_threaded(budget);
+    case Engine::kJit:
+      return execute_jit(budget);
+    case Engine::kAot:
+      return execute_aot(budget);
+    default:
+      return execute_block(budget);
+    }
   };
-  auto [res, elapsed] = cpu_timer_.measure(executeShuttle);
-  spdlog::trace("CPU execution time: {} ms", elapsed);
+  auto [res, elapsed] = cpu_timer_.measure(executeEngine);
+  // the counters move a dispatch at a time, not an instruction at a time
+  if (res)
+    instret_ += *res;
+  progress_ = 0;
+  // zero unless this dispatch was sampled
+  if (elapsed != elapsed.zero())
+    LUCE_TRACE_POINT(trace_, kTiming, "CPU execution time: {}", elapsed);
+  LUCE_TRACE_POINT(trace_,
+                   kExecute,
+                   "Dispatched from {:#010x}: {} instructions retired",
+                   start,
+                   res ? *res : 0);
   return res;
 }
+auto CPU::execute_block(const size_t budget) -> StatusOr<size_t> {
+  using enum isa::IInstruction::ExecutionStatus;
+  // nothing is executing a block now, so the dropped ones can go
+  bcache_.collect([this](const BasicBlock &block) { jit_.release(block); });
+
+  auto &ctx = task_->context();
+  auto block = bcache_.lookup(ctx.program_counter.num());
+  if (!block && !(block = translate(ctx.program_counter.num()))) {
+    // nothing decodable here; let the reference path report and trap
+    if (auto res = shuttle(); !res)
+      return {std::move(res)};
+    return size_t{1};
+  }
+
+  size_t retired = 0;
+  // the blocks a trace is being recorded through, head first
+  std::vector<BasicBlock *> path;
+  // blocks ending in a jump or branch go straight on to the next one
+  for (;;) {
+    if (const auto trace = bcache_.trace_of(*block))
+      block = trace;
+    ++block->executions;
+    auto status = kOk;
+    size_t i = 0;
+    BasicBlock::Guard *side_exit = nullptr;
+    // the optimized ir is exact only at the points the block may be left, so
+    // a block cut short by the budget goes instruction by instruction
+    if (block->size() <= budget - retired) {
+      std::tie(i, side_exit) = execute_ir(*block);
+      retired += i;
+      if (!block->valid)
+        return retired;
+    }
+    auto guard = std::ranges::lower_bound(
+        block->guards, i, {}, &BasicBlock::Guard::index);
+    // the pc of the instruction at hand; the context catches up only where
+    // someone may look
+    auto pc = ctx.program_counter.num();
+    auto sync = [&] { ctx.program_counter.num() = pc; };
+    for (; i < block->size() && !side_exit; ++i) {
+      if (retired == budget) {
+        sync();
+        return retired;
+      }
+      const auto &inst = block->instructions[i];
+      const auto synced = !options_.lazy_state || ReadsPc(inst->num());
+      if (!options_.lazy_state)
+        ctx.instruction_register.reset(inst->num());
+      if (synced) {
+        sync();
+        // whatever reads the counters is among these
+        progress_ = retired;
+      }
+      status = inst->execute(this);
+      ++retired;
+      if (status == kOk) {
+        pc += isa::instruction_size_bytes;
+        if (!options_.lazy_state)
+          sync();
+        // a store may have just dropped this very block(self-modifying code)
+        if (!block->valid) {
+          sync();
+          return retired;
+        }
+      } else if (synced) {
+        pc = ctx.program_counter.num();
+      } else {
+        // a fault; the instruction left the pc as it was
+        sync();
+      }
+      const auto guarded = guard != block->guards.end() && guard->index == i;
+      // end of the block, or a trap
+      if (status != kOk && (!guarded || status != kOkButDontBotherPC))
+        break;
+      if (!guarded)
+        continue;
+      // inside a trace, control has to go the recorded way
+      if (pc != guard->next) {
+        side_exit = &*guard;
+        break;
+      }
+      ++guard;
+    }
+    sync();
+    if (status != kOk && !side_exit) {
+      if (Traps(status))
+        ctx.instruction_register.reset(block->instructions[i]->num());
+      if (auto res = commit(status); !res)
+        return {std::move(res)};
+      // only jumps and branches leave the pc to the instruction; system calls
+      // and traps go back to the monitor
+      if (status != kOkButDontBotherPC)
+        return retired;
+      pc = ctx.program_counter.num();
+    }
+
+    const auto from = block;
+    block = side_exit ? follow(side_exit->exit, pc) : successor(*from, pc);
+    if (retired == budget)
+      return retired;
+    if (!block && !(block = translate(pc)))
+      return retired;
+    record(path, *from, *block);
+  }
+}
+auto CPU::execute_ir(BasicBlock &block)
+    -> std::pair<size_t, BasicBlock::Guard *> {
+  auto &ctx = task_->context();
+  auto &gpr = *ctx.general_purpose_registers();
+  for (const auto &operation : block.ir.operations) {
+    const auto &[record, pc, index, next] = operation;
+    const auto rs1 = gpr[record.rs1];
+    const auto rs2 = gpr[record.rs2];
+    // writes to x0 are gone already, but for loads and jumps
+    auto write = [&](const uint32_t value) {
+      if (record.rd != ThreadedCode::sink_register)
+        gpr.write_at(record.rd) = value;
+    };
+    // in front of something the instructions have to do, fault included
+    auto leave = [&] {
+      ctx.program_counter.num() = pc;
+      return std::pair<size_t, BasicBlock::Guard *>{index, nullptr};
+    };
+    // false on a fault
+    auto load = [&]<typename T>(T value) {
+      if (!this->load(rs1 + record.imm, value)) [[unlikely]]
+        return false;
+      write(static_cast<uint32_t>(value));
+      return true;
+    };
+    auto store = [&]<typename T>(const T) {
+      return this->store(rs1 + record.imm, static_cast<T>(rs2));
+    };
+    if (ir::is_pure(record.op)) {
+      write(ir::evaluate(operation, rs1, rs2));
+      continue;
+    }
+    const auto fallthrough = pc + isa::instruction_size_bytes;
+    auto target = fallthrough;
+    // clang-format off
+    switch (record.op) {
+    case Op::kLb:  if (!load(int8_t{})) return leave(); continue;
+    case Op::kLh:  if (!load(int16_t{})) return leave(); continue;
+    case Op::kLw:  if (!load(uint32_t{})) return leave(); continue;
+    case Op::kLbu: if (!load(uint8_t{})) return leave(); continue;
+    case Op::kLhu: if (!load(uint16_t{})) return leave(); continue;
+    case Op::kSb:  if (!store(uint8_t{})) return leave(); break;
+    case Op::kSh:  if (!store(uint16_t{})) return leave(); break;
+    case Op::kSw:  if (!store(uint32_t{})) return leave(); break;
+    case Op::kBeq:  if (rs1 == rs2) target = pc + record.imm; break;
+    case Op::kBne:  if (rs1 != rs2) target = pc + record.imm; break;
+    case Op::kBlt:
+      if (static_cast<int32_t>(rs1) < static_cast<int32_t>(rs2))
+        target = pc + record.imm;
+      break;
+    case Op::kBge:
+      if (static_cast<int32_t>(rs1) >= static_cast<int32_t>(rs2))
+        target = pc + record.imm;
+      break;
+    case Op::kBltu: if (rs1 < rs2) target = pc + record.imm; break;
+    case Op::kBgeu: if (rs1 >= rs2) target = pc + record.imm; break;
+    case Op::kJal:
+      write(fallthrough);
+      target = pc + record.imm;
+      break;
+    case Op::kJalr:
+      write(fallthrough);
+      target = (rs1 + record.imm) & ~1u;
+      break;
+    default: // system, atomic
+      return leave();
+    }
+    // clang-format on
+    if (record.op == Op::kSb || record.op == Op::kSh || record.op == Op::kSw) {
+      // the store may have hit this very block
+      if (block.valid)
+        continue;
+      ctx.program_counter.num() = fallthrough;
+      return {index + 1, nullptr};
+    }
+    // a control transfer: the end of the block, or a guard of a trace
+    ctx.program_counter.num() = target;
+    if (index + 1 == block.ir.size)
+      return {block.ir.size, nullptr};
+    if (target != next)
+      return {index + 1,
+              &*std::ranges::find(
+                  block.guards, index, &BasicBlock::Guard::index)};
+  }
+  ctx.program_counter.num() = block.ir.end;
+  return {block.ir.size, nullptr};
+}
+auto CPU::successor(BasicBlock &from, const vaddr_t pc) -> BasicBlock * {
+  using isa::Word;
+  const auto num = from.instructions.back()->num();
+  const auto rd = Word::extractBits<7, 12>(num);
+  switch (Word::extractBits<0, 7>(num)) {
+  case 0b1100011: // branch
+    return follow(from.links[pc == from.end ? from.kFallthrough : from.kTaken],
+                  pc);
+  case 0b1101111: // jal
+    if (IsLinkRegister(rd))
+      branches_.call(&from, bcache_.epoch());
+    return follow(from.links[from.kTaken], pc);
+  case 0b1100111: { // jalr
+    const auto rs1 = Word::extractBits<15, 20>(num);
+    if (rd == 0 && IsLinkRegister(rs1))
+      if (const auto caller = branches_.ret(pc, bcache_.epoch()))
+        return follow(caller->links[caller->kFallthrough], pc);
+    if (IsLinkRegister(rd))
+      branches_.call(&from, bcache_.epoch());
+    if (const auto block = branches_.lookup(pc, bcache_.epoch()))
+      return block;
+    const auto block = bcache_.lookup(pc);
+    if (block)
+      branches_.insert(block, bcache_.epoch());
+    return block;
+  }
+  default: // cut at the maximum size, or by something undecodable
+    return follow(from.links[from.kFallthrough], pc);
+  }
+}
+auto CPU::follow(BasicBlock::Link &link, const vaddr_t pc) -> BasicBlock * {
+  if (const auto block = bcache_.follow(link, pc))
+    return block;
+  const auto block = bcache_.lookup(pc);
+  if (block)
+    bcache_.link(link, block);
+  return block;
+}
+auto CPU::execute_threaded(const size_t budget) -> StatusOr<size_t> {
+  const auto retired = threaded_.run(*this, budget);
+  if (retired == budget)
+    return retired;
+  // stopped in front of something only the reference path handles
+  progress_ = retired;
+  if (auto res = shuttle(); !res)
+    return {std::move(res)};
+  return retired + 1;
+}
+auto CPU::execute_jit(const size_t budget) -> StatusOr<size_t> {
+  if (const auto retired = jit_.run(*this, budget, options_.jit_threshold))
+    return retired;
+  // cold, not compilable, or stopped in front of a side exit
+  return execute_block(budget);
+}
+auto CPU::execute_aot(const size_t budget) -> StatusOr<size_t> {
+  if (const auto retired = aot_.run(*this, budget))
+    return retired;
+  // not translated, or stopped in front of what only the interpreter does
+  return execute_block(budget);
+}
+auto CPU::translate(const vaddr_t pc) -> BasicBlock * {
+  // left to the reference path, which runs the routine natively
+  if (hle_.covers(pc))
+    return nullptr;
+  auto block = std::make_unique<BasicBlock>(pc);
+  for (auto addr = pc; block->size() < kMaxBlockSize;
+       addr += isa::instruction_size_bytes) {
+    auto maybe_bytes = fetch(addr);
+    if (!maybe_bytes)
+      break;
+    const auto num =
+        isa::Word{maybe_bytes->first<isa::instruction_size_bytes>()}.num();
+    auto inst = monitor()->disassembler()->disassemble(num);
+    if (!inst)
+      break;
+    block->instructions.emplace_back(std::move(inst));
+    block->end = addr + isa::instruction_size_bytes;
+    if (IsBlockTerminator(num))
+      break;
+  }
+  if (block->empty())
+    return nullptr;
+  block->ir = ir::lower(*block, *monitor()->disassembler());
+  ir_optimizer_.run(block->ir);
+  // as hot as it was last run, so the jit need not wait for it again
+  block->executions = cache_.executions(pc);
+
+  dbg(trace,
+      "Translated block [{:#010x}, {:#010x}) with {} instructions",
+      block->start,
+      block->end,
+      block->size());
+  return bcache_.insert(std::move(block));
+}
+auto CPU::record(std::vector<BasicBlock *> &path,
+                 const BasicBlock &from,
+                 BasicBlock &to) -> void {
+  if (path.empty()) {
+    // a hot loop header, most likely
+    if (to.start <= from.start && !to.traced &&
+        to.executions >= kTraceThreshold) {
+      to.traced = true;
+      path.push_back(&to);
+    }
+    return;
+  }
+  size_t size = 0;
+  for (const auto block : path)
+    size += block->size();
+  // stop at a loop closed, an indirect jump, or another trace
+  if (&to != path.front() && !IsJalr(from.instructions.back()->num()) &&
+      !bcache_.trace_of(to) && path.size() < kMaxTraceBlocks &&
+      size + to.size() <= kMaxTraceSize) {
+    path.push_back(&to);
+    return;
+  }
+  // a store may have dropped part of the path meanwhile
+  if (path.size() > 1 && std::ranges::all_of(path, &BasicBlock::valid))
+    form_trace(path);
+  path.clear();
+}
+auto CPU::form_trace(const std::span<BasicBlock *const> path) -> BasicBlock * {
+  auto formed = std::make_unique<BasicBlock>(path.front()->start);
+  for (const auto block : path) {
+    if (!formed->empty())
+      formed->guards.push_back(
+          {.index = formed->size() - 1, .next = block->start});
+    for (const auto &inst : block->instructions)
+      formed->instructions.emplace_back(
+          monitor()->disassembler()->disassemble(inst->num()));
+    formed->end = block->end;
+  }
+  formed->ir = ir::lower(*formed, *monitor()->disassembler());
+  ir_optimizer_.run(formed->ir);
+  dbg(trace,
+      "Formed a trace at {:#010x} through {} blocks, {} instructions",
+      formed->start,
+      path.size(),
+      formed->size());
+  return bcache_.insert(*path.front(), std::move(formed));
+}
 Status CPU::shuttle() {
   auto &ctx = task_->context();
+  if (hle_.covers(ctx.program_counter.num()) && hle_.run(*this))
+    return {};
+  if (auto inst = icache_.lookup(ctx.program_counter.num())) {
+    if (!options_.lazy_state)
+      ctx.instruction_register.reset(inst->num());
+    return execute(inst);
+  }
   auto maybe_bytes = fetch(ctx.program_counter.num());
   if (!maybe_bytes) {
     return maybe_bytes.as_status();
@@ -53,11 +476,13 @@ Status CPU::shuttle() {
     orig_bytes[i] = bytes[i];
   }
   // convert little-endian to big-endian for more human-readable output
-  spdlog::info("Fetched instruction: {:#04x} (in big-endian: 0x{:02x})",
-               fmt::join(ctx.instruction_register.bytes(), " "),
-               fmt::join(ctx.instruction_register.bytes() |
-                             auxilia::ranges::views::swap_endian,
-                         ""));
+  LUCE_TRACE_POINT(trace_,
+                   kFetch,
+                   "Fetched instruction: {:#04x} (in big-endian: 0x{:02x})",
+                   fmt::join(ctx.instruction_register.bytes(), " "),
+                   fmt::join(ctx.instruction_register.bytes() |
+                                 auxilia::ranges::views::swap_endian,
+                             ""));
   return decode_and_execute();
 }
 Status CPU::decode_and_execute() {
@@ -67,11 +492,20 @@ Status CPU::decode_and_execute() {
     spdlog::error("Failed to decode the instruction.");
     return trap();
   }
-  spdlog::info("Decoded instruction: {}", *inst);
+  LUCE_TRACE_POINT(trace_, kDecode, "Decoded instruction: {}", *inst);
+  if (const auto pc = task_->context().program_counter.num();
+      icache_.covers(pc))
+    return execute(icache_.insert(pc, std::move(inst)));
+
   return execute(inst.get());
 }
 auxilia::Status CentralProcessingUnit::execute(isa::IInstruction *inst) {
-  auto exec = inst->execute(this);
+  const auto status = inst->execute(this);
+  if (options_.lazy_state && Traps(status))
+    task_->context().instruction_register.reset(inst->num());
+  return commit(status);
+}
+auto CPU::commit(const isa::IInstruction::ExecutionStatus exec) -> Status {
   using enum isa::IInstruction::ExecutionStatus;
   switch (exec) {
   case kOk:
@@ -130,12 +564,49 @@ auto CPU::fetch(const vaddr_t addr) const
 auto CPU::write(const vaddr_t addr, const std::span<const std::byte> bytes)
     -> auxilia::Status {
   return monitor()->memory().write_n(
-      mmu_.virtual_to_physical(addr), isa::instruction_size_bytes, bytes);
+      mmu_.virtual_to_physical(addr), bytes.size(), bytes);
+}
+auto CPU::store_unchecked(const vaddr_t addr,
+                          const std::span<const std::byte> bytes) noexcept
+    -> void {
+  monitor()->memory().write_unchecked(mmu_.virtual_to_physical(addr), bytes);
+}
+auto CPU::map_window() noexcept -> void {
+  window_ = monitor()->memory().host_base();
+  window_begin_ = mmu_.physical_to_virtual(isa::physical_memory_begin);
+  window_size_ = isa::physical_memory_size;
+}
+auto CPU::text() const noexcept -> std::span<const std::byte> {
+  const auto start = task_->text_segment().start;
+  const auto end = task_->text_segment().end;
+  const auto offset = static_cast<size_t>(start - window_begin_);
+  if (offset >= window_size_)
+    return {};
+  return {window_ + offset,
+          (std::min)(static_cast<size_t>(end - start), window_size_ - offset)};
+}
+auto CPU::predecode() -> void {
+  if (const auto descriptors = cache_.descriptors(); !descriptors.empty())
+    predecoder_.restore(text(), task_->text_segment().start, descriptors);
+  else
+    predecoder_.reset(
+        text(), task_->text_segment().start, monitor()->disassembler());
+}
+auto CPU::persist() -> auxilia::Status {
+  if (!task_)
+    return {};
+  std::vector<PersistentCache::Profile> profiles;
+  bcache_.for_each([&](const BasicBlock &block) {
+    if (block.executions != 0)
+      profiles.push_back({block.start, block.end, block.executions});
+  });
+  return cache_.save(predecoder_.snapshot(), profiles);
 }
 auto CPU::monitor() const noexcept -> Monitor * {
   return static_cast<Monitor *>(this->mediator);
 }
 auto CPU::handle_syscall() -> auxilia::Status {
+  ++syscalls_;
   auto &gpr = this->gpr();
 
   auto pesudo_mepc = pc();
@@ -145,6 +616,20 @@ auto CPU::handle_syscall() -> auxilia::Status {
 
   const auto args = std::span<const uint32_t>{&gpr[10], 7};
 
+  // every clock reads guest time since the task started, which the icount
+  // mode makes the same run after run. timespec and timeval alike hold 64-bit
+  // seconds, then the fraction in `unit` nanoseconds
+  auto writeTime = [&](const vaddr_t addr, const uint64_t unit) {
+    const auto now = time();
+    const uint64_t seconds = now / kNanosecondsPerSecond;
+    const auto fraction =
+        static_cast<uint32_t>(now % kNanosecondsPerSecond / unit);
+    if (!store(addr, seconds) || !store(addr + 8, fraction))
+      gpr.write_at(10) = -1;
+    else
+      gpr.write_at(10) = 0;
+  };
+
   dbg(info, "Syscall number: {}", syscall_num);
   dbg(info, "Arguments: {}", fmt::join(args, ", "));
 
@@ -156,7 +641,8 @@ auto CPU::handle_syscall() -> auxilia::Status {
           ->memory()
           .read_n(mmu_.virtual_to_physical(args[1]), args[2])
           .transform([&](auto &&res) {
-            fmt::println("[stdout]{}", fmt::join(res, " "));
+            if (!options_.shadow)
+              fmt::println("[stdout]{}", fmt::join(res, " "));
             gpr.write_at(10) = args[2];
           })
           .transform_error([&](auto &&err) {
@@ -198,9 +684,10 @@ auto CPU::handle_syscall() -> auxilia::Status {
           ->memory()
           .read_n(mmu_.virtual_to_physical(args[1]), args[2])
           .transform([&](auto &&res) {
-            fmt::println("[{}]{}",
-                         args[0] == 1 ? "stdout" : "stderr",
-                         fmt::join(res, " "));
+            if (!options_.shadow)
+              fmt::println("[{}]{}",
+                           args[0] == 1 ? "stdout" : "stderr",
+                           fmt::join(res, " "));
             gpr.write_at(10) = args[2];
           })
           .transform_error([&](auto &&err) {
@@ -218,7 +705,18 @@ auto CPU::handle_syscall() -> auxilia::Status {
 
   case 93: // SYS_exit
     spdlog::info("Program exited with code: {}", args[0]);
-    task_->finish();
+    task_->finish(static_cast<int32_t>(args[0]));
+    break;
+
+  case 113: // SYS_clock_gettime
+  case 403: // SYS_clock_gettime64
+    // args[0]: clock id, args[1]: struct timespec pointer
+    writeTime(args[1], 1);
+    break;
+
+  case 169: // SYS_gettimeofday
+    // args[0]: struct timeval pointer, args[1]: timezone, ignored
+    writeTime(args[0], 1000);
     break;
 
   case 214: // SYS_brk
@@ -0,0 +1,220 @@
+#include "deps.hh"
+
+#include "luce/cpu/hle.hpp"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include "luce/cpu/cpu.hpp"
+
+namespace accat::luce {
+namespace hle {
+namespace {
+auto RoutineOf(const std::string_view name) -> std::optional<Routine> {
+  for (const auto routine : {Routine::kMemcpy,
+                             Routine::kMemset,
+                             Routine::kStrlen,
+                             Routine::kMemcmp})
+    if (to_string(routine) == name)
+      return routine;
+  return std::nullopt;
+}
+auto FingerprintOf(const std::string_view hex)
+    -> std::optional<std::vector<std::optional<std::byte>>> {
+  if (hex.empty() || hex.size() % 2 != 0)
+    return std::nullopt;
+  std::vector<std::optional<std::byte>> fingerprint;
+  for (size_t i = 0; i < hex.size(); i += 2) {
+    const auto digits = hex.substr(i, 2);
+    if (digits == "??") {
+      fingerprint.emplace_back();
+      continue;
+    }
+    uint8_t value = 0;
+    const auto [ptr, ec] = std::from_chars(
+        digits.data(), digits.data() + digits.size(), value, 16);
+    if (ec != std::errc{} || ptr != digits.data() + digits.size())
+      return std::nullopt;
+    fingerprint.emplace_back(std::byte{value});
+  }
+  return fingerprint;
+}
+} // namespace
+auto parse(std::string_view specs) -> auxilia::StatusOr<std::vector<Binding>> {
+  std::vector<Binding> bindings;
+  while (!specs.empty()) {
+    const auto comma = specs.find(',');
+    const auto spec = specs.substr(0, comma);
+    specs = comma == std::string_view::npos ? std::string_view{}
+                                            : specs.substr(comma + 1);
+    if (spec.empty())
+      continue;
+    const auto split = spec.find_first_of("@=");
+    const auto routine = RoutineOf(spec.substr(0, split));
+    if (!routine)
+      return auxilia::InvalidArgumentError(
+          "Unknown routine in '{}'; expected any of: memcpy, memset, "
+          "strlen, memcmp",
+          spec);
+    if (split == std::string_view::npos)
+      return auxilia::InvalidArgumentError(
+          "Routine '{}' bound to nothing; expected an @address or a "
+          "=fingerprint",
+          spec);
+
+    auto &binding = bindings.emplace_back(Binding{.routine = *routine});
+    auto rest = spec.substr(split + 1);
+    if (spec[split] == '=') {
+      auto fingerprint = FingerprintOf(rest);
+      if (!fingerprint)
+        return auxilia::InvalidArgumentError(
+            "Invalid fingerprint in '{}'; expected pairs of hex digits or ??",
+            spec);
+      binding.fingerprint = std::move(*fingerprint);
+      continue;
+    }
+    if (rest.starts_with("0x") || rest.starts_with("0X"))
+      rest.remove_prefix(2);
+    vaddr_t address = 0;
+    const auto [ptr, ec] =
+        std::from_chars(rest.data(), rest.data() + rest.size(), address, 16);
+    if (rest.empty() || ec != std::errc{} || ptr != rest.data() + rest.size())
+      return auxilia::InvalidArgumentError(
+          "Invalid address in '{}'; expected a hex number", spec);
+    binding.address = address;
+  }
+  return bindings;
+}
+} // namespace hle
+using hle::Routine;
+auto HighLevelEmulation::bind(const std::span<const hle::Binding> bindings)
+    -> HighLevelEmulation & {
+  bindings_.assign(bindings.begin(), bindings.end());
+  return *this;
+}
+auto HighLevelEmulation::reset(const std::span<const std::byte> text,
+                               const vaddr_t base) -> HighLevelEmulation & {
+  entries_.clear();
+  statistics_ = {};
+  for (const auto &[routine, address, fingerprint] : bindings_) {
+    if (address) {
+      if (*address < base || *address - base >= text.size() ||
+          *address % isa::instruction_alignment != 0)
+        spdlog::warn("No {} at {:#010x}: not an instruction of the text",
+                     hle::to_string(routine),
+                     *address);
+      else
+        entries_.insert_or_assign(*address, routine);
+      continue;
+    }
+    const auto matches = [&](const size_t offset) {
+      return std::ranges::equal(fingerprint,
+                                text.subspan(offset, fingerprint.size()),
+                                [](const std::optional<std::byte> &expected,
+                                   const std::byte actual) {
+                                  return !expected || *expected == actual;
+                                });
+    };
+    auto offset = size_t{0};
+    for (; offset + fingerprint.size() <= text.size();
+         offset += isa::instruction_alignment)
+      if (matches(offset))
+        break;
+    if (offset + fingerprint.size() > text.size()) {
+      spdlog::warn("No {} matches its fingerprint in the text",
+                   hle::to_string(routine));
+      continue;
+    }
+    entries_.insert_or_assign(static_cast<vaddr_t>(base + offset), routine);
+  }
+  for (const auto &[entry, routine] : entries_)
+    spdlog::info("Running {} at {:#010x} natively",
+                 hle::to_string(routine),
+                 entry);
+  return *this;
+}
+auto HighLevelEmulation::run(CentralProcessingUnit &cpu) -> bool {
+  const auto it = entries_.find(cpu.pc().num());
+  if (it == entries_.end())
+    return false;
+
+  // guest memory as host bytes, if all of [addr, addr + size) is in reach
+  const auto view = [&](const vaddr_t addr, const size_t size)
+      -> std::optional<std::span<const std::byte>> {
+    const auto offset = static_cast<size_t>(addr - cpu.window_begin_);
+    if (offset > cpu.window_size_ || cpu.window_size_ - offset < size)
+      return std::nullopt;
+    return std::span<const std::byte>{cpu.window_ + offset, size};
+  };
+  auto &gpr = cpu.gpr();
+  // the arguments, a0 to a2
+  const uint32_t a0 = gpr[10], a1 = gpr[11], a2 = gpr[12];
+  std::optional<uint32_t> result;
+  size_t bytes = a2;
+  switch (it->second) {
+  case Routine::kMemcpy: {
+    const auto to = view(a0, a2);
+    const auto from = view(a1, a2);
+    if (!to || !from)
+      break;
+    // what the guest loop leaves in overlapping ranges is up to its order;
+    // it runs itself, and the copy below never reads what it wrote
+    if (a0 - a1 < a2 || a1 - a0 < a2)
+      break;
+    // stores go the usual way, minding the caches and the reservation
+    if (a2 != 0)
+      cpu.store_unchecked(a0, *from);
+    result = a0;
+    break;
+  }
+  case Routine::kMemset: {
+    if (!view(a0, a2))
+      break;
+    std::array<std::byte, 256> fill;
+    fill.fill(static_cast<std::byte>(a1));
+    for (size_t done = 0; done < a2; done += fill.size())
+      cpu.store_unchecked(a0 + done,
+                          std::span{fill}.first((std::min)(
+                              fill.size(), static_cast<size_t>(a2) - done)));
+    result = a0;
+    break;
+  }
+  case Routine::kStrlen: {
+    const auto offset = static_cast<size_t>(a0 - cpu.window_begin_);
+    if (offset > cpu.window_size_)
+      break;
+    const auto string = view(a0, cpu.window_size_ - offset);
+    if (!string)
+      break;
+    const auto nul = std::ranges::find(*string, std::byte{0});
+    if (nul == string->end())
+      break;
+    result = static_cast<uint32_t>(nul - string->begin());
+    bytes = *result + 1;
+    break;
+  }
+  case Routine::kMemcmp: {
+    const auto lhs = view(a0, a2);
+    const auto rhs = view(a1, a2);
+    if (!lhs || !rhs)
+      break;
+    const auto [at, other] = std::ranges::mismatch(*lhs, *rhs);
+    result = at == lhs->end()
+                 ? 0
+                 : static_cast<uint32_t>(
+                       static_cast<int32_t>(static_cast<uint8_t>(*at)) -
+                       static_cast<int32_t>(static_cast<uint8_t>(*other)));
+    break;
+  }
+  }
+  if (!result) {
+    ++statistics_.declined;
+    return false;
+  }
+  ++statistics_.calls;
+  statistics_.bytes += bytes;
+  gpr.write_at(10) = *result;
+  // as `ret`, to ra
+  cpu.pc().num() = gpr[1] & ~uint32_t{1};
+  return true;
+}
+} // namespace accat::luce
@@ -0,0 +1,110 @@
+#include "deps.hh"
+
+#include "luce/cpu/ir.hpp"
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <optional>
+#include <vector>
+#include "luce/cpu/block.hpp"
+#include "luce/Support/isa/Descriptor.hpp"
+#include "luce/Support/isa/IDisassembler.hpp"
+
+namespace accat::luce::ir {
+namespace {
+inline constexpr auto kSink = ThreadedCode::sink_register;
+} // namespace
+
+auto lower(const BasicBlock &block, const isa::IDisassembler &disassembler)
+    -> Block {
+  Block result{.end = block.end, .size = static_cast<uint32_t>(block.size())};
+  result.operations.reserve(block.size());
+  auto pc = block.start;
+  auto guard = block.guards.begin();
+  for (auto i = 0u; i < block.size(); ++i) {
+    auto &operation = result.operations.emplace_back(Operation{
+        .record = ThreadedCode::lower(
+            disassembler.describe(block.instructions[i]->num())),
+        .pc = pc,
+        .index = i,
+    });
+    pc += isa::instruction_size_bytes;
+    if (guard != block.guards.end() && guard->index == i) {
+      operation.next = pc = guard->next;
+      ++guard;
+    }
+  }
+  return result;
+}
+auto Optimizer::run(Block &block) -> Block & {
+  fold(block);
+  eliminate(block);
+  statistics_.operations += block.operations.size();
+  return block;
+}
+auto Optimizer::fold(Block &block) -> void {
+  // the value of each register where known; x0 always is
+  std::array<std::optional<uint32_t>, ThreadedCode::register_count + 1>
+      known{};
+  known[0] = 0;
+  for (auto &operation : block.operations) {
+    auto &record = operation.record;
+    const auto operands = operands_of(record.op);
+    if (is_pure(record.op)) {
+      if ((operands.rs1 && !known[record.rs1]) ||
+          (operands.rs2 && !known[record.rs2])) {
+        known[record.rd].reset();
+        continue;
+      }
+      const auto value = evaluate(operation,
+                                  operands.rs1 ? *known[record.rs1] : 0,
+                                  operands.rs2 ? *known[record.rs2] : 0);
+      if (record.op != Op::kLui)
+        ++statistics_.folded;
+      // `lui` takes its immediate as is
+      record = {.op = Op::kLui, .rd = record.rd, .imm = value};
+      known[record.rd] = value;
+    } else if (record.op == Op::kJal || record.op == Op::kJalr) {
+      known[record.rd] = operation.pc + isa::instruction_size_bytes;
+    } else if (record.op == Op::kFallback) {
+      // whatever the interpreter does there, e.g. an atomic, is opaque
+      known.fill(std::nullopt);
+      known[0] = 0;
+    } else if (operands.rd) {
+      known[record.rd].reset();
+    }
+  }
+}
+auto Optimizer::eliminate(Block &block) -> void {
+  auto &operations = block.operations;
+  std::vector<bool> dropped(operations.size());
+  // live past the block: everything
+  std::bitset<ThreadedCode::register_count + 1> live;
+  live.set().reset(kSink);
+  for (auto i = operations.size(); i-- > 0;) {
+    const auto &record = operations[i].record;
+    const auto operands = operands_of(record.op);
+    if (is_pure(record.op)) {
+      // writes to x0 land in the sink, which is never live
+      if (!live.test(record.rd)) {
+        dropped[i] = true;
+        continue;
+      }
+      live.reset(record.rd);
+    } else {
+      // the block may be left here, with the guest state exact
+      live.set().reset(kSink);
+    }
+    if (operands.rs1)
+      live.set(record.rs1);
+    if (operands.rs2)
+      live.set(record.rs2);
+  }
+  auto kept = operations.begin();
+  for (size_t i = 0; i < operations.size(); ++i)
+    if (!dropped[i])
+      *kept++ = operations[i];
+  statistics_.dropped += static_cast<uint64_t>(operations.end() - kept);
+  operations.erase(kept, operations.end());
+}
+} // namespace accat::luce::ir
@@ -0,0 +1,266 @@
+#include "luce/Support/isa/riscv32/DecodeTable.hpp"
+
+#include <cstddef>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#  define LUCE_DECODE_AVX2 1
+#  include <immintrin.h>
+#  if defined(_MSC_VER) && !defined(__clang__)
+#    include <intrin.h>
+#    define LUCE_TARGET_AVX2
+#  else
+// the rest of the build targets plain x86-64; only these functions use AVX2,
+// and only once the host turns out to have it
+#    define LUCE_TARGET_AVX2 [[gnu::target("avx2")]]
+#  endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#  define LUCE_DECODE_NEON 1
+#  include <arm_neon.h>
+#endif
+
+namespace accat::luce::isa::riscv32 {
+namespace {
+/// the fields each format has, as the bytes they take in the first word of a
+/// descriptor: rd, rs1, rs2 from the second byte on
+constexpr std::array<uint32_t, 8> field_bytes{
+    0xFFFF'FF00, // R
+    0x00FF'FF00, // I
+    0x00FF'FF00, // IShift
+    0xFFFF'0000, // S
+    0xFFFF'0000, // B
+    0x0000'FF00, // U
+    0x0000'FF00, // J
+    0xFFFF'FF00, // AR
+};
+static_assert(static_cast<size_t>(Format::kAR) + 1 == field_bytes.size(),
+              "one entry per format");
+// the kernels write descriptors as two words: id and registers, then imm
+static_assert(offsetof(Descriptor, id) == 0 && offsetof(Descriptor, rd) == 1 &&
+              offsetof(Descriptor, rs1) == 2 &&
+              offsetof(Descriptor, rs2) == 3 &&
+              offsetof(Descriptor, imm) == 4);
+// and read encodings as three: id, extension and format, then mask, match
+static_assert(sizeof(Encoding) == 12 && offsetof(Encoding, extension) == 1 &&
+              offsetof(Encoding, format) == 2 &&
+              offsetof(Encoding, mask) == 4 && offsetof(Encoding, match) == 8);
+
+#if LUCE_DECODE_AVX2
+auto host_has_avx2() noexcept {
+#  if defined(_MSC_VER) && !defined(__clang__)
+  int info[4] = {};
+  __cpuid(info, 1);
+  // the OS saves the ymm registers
+  if (!(info[2] & (1 << 27)) || (_xgetbv(0) & 6) != 6)
+    return false;
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#  else
+  return __builtin_cpu_supports("avx2") != 0;
+#  endif
+}
+LUCE_TARGET_AVX2 inline auto bits(const __m256i v,
+                                  const uint32_t mask) noexcept {
+  return _mm256_and_si256(v, _mm256_set1_epi32(static_cast<int>(mask)));
+}
+/// @brief @p imm in the lanes whose format is @p f, 0 in the others.
+LUCE_TARGET_AVX2 inline auto pick(const __m256i format,
+                                  const Format f,
+                                  const __m256i imm) noexcept {
+  return _mm256_and_si256(
+      imm, _mm256_cmpeq_epi32(format, _mm256_set1_epi32(static_cast<int>(f))));
+}
+#endif
+#if LUCE_DECODE_NEON
+inline auto bits(const uint32x4_t v, const uint32_t mask) noexcept {
+  return vandq_u32(v, vdupq_n_u32(mask));
+}
+inline auto pick(const uint32x4_t format,
+                 const Format f,
+                 const uint32x4_t imm) noexcept {
+  return vandq_u32(imm,
+                   vceqq_u32(format, vdupq_n_u32(static_cast<uint32_t>(f))));
+}
+#endif
+} // namespace
+
+struct DecodeTable::Batch {
+  static_assert(sizeof(Row) == 4 && offsetof(Row, shift) == 2 &&
+                offsetof(Row, width) == 3);
+#if LUCE_DECODE_AVX2
+  /// @return how many words, a multiple of eight, were decoded.
+  LUCE_TARGET_AVX2 static auto avx2(const DecodeTable &table,
+                                    const std::span<const uint32_t> words,
+                                    const std::span<Descriptor> out,
+                                    const ExtensionSet extensions) noexcept
+      -> size_t {
+    const auto rows = reinterpret_cast<const int *>(table.rows_.data());
+    const auto cells = reinterpret_cast<const int *>(table.cells_.data());
+    const auto encodings =
+        reinterpret_cast<const int *>(table.encodings_.data());
+    const auto set = _mm256_set1_epi32(static_cast<int>(extensions));
+    const auto fields = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(field_bytes.data()));
+    const auto one = _mm256_set1_epi32(1);
+    const auto byte = _mm256_set1_epi32(0xFF);
+    const auto zero = _mm256_setzero_si256();
+
+    size_t i = 0;
+    for (; i + 8 <= words.size(); i += 8) {
+      const auto w = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i *>(words.data() + i));
+      // the cell, as cell_of has it
+      const auto row =
+          _mm256_i32gather_epi32(rows, bits(_mm256_srli_epi32(w, 2), 31), 4);
+      const auto width = _mm256_srli_epi32(row, 24);
+      const auto field = _mm256_and_si256(
+          _mm256_srlv_epi32(w, _mm256_and_si256(_mm256_srli_epi32(row, 16),
+                                                byte)),
+          _mm256_sub_epi32(_mm256_sllv_epi32(one, width), one));
+      const auto cell = _mm256_add_epi32(
+          bits(row, 0xFFFF),
+          _mm256_or_si256(bits(_mm256_srli_epi32(w, 12), 7),
+                          _mm256_slli_epi32(field, 3)));
+      const auto id = _mm256_and_si256(
+          _mm256_i32gather_epi32(cells, cell, 1), byte);
+
+      // and its encoding, as confirm has it
+      const auto entry = _mm256_add_epi32(id, _mm256_slli_epi32(id, 1));
+      const auto head = _mm256_i32gather_epi32(encodings, entry, 4);
+      const auto mask = _mm256_i32gather_epi32(encodings + 1, entry, 4);
+      const auto match = _mm256_i32gather_epi32(encodings + 2, entry, 4);
+      const auto extension = bits(_mm256_srli_epi32(head, 8), 0xFF);
+      const auto format = bits(_mm256_srli_epi32(head, 16), 0xFF);
+      const auto valid = _mm256_andnot_si256(
+          _mm256_or_si256(
+              _mm256_cmpeq_epi32(id, zero),
+              _mm256_cmpeq_epi32(
+                  _mm256_and_si256(_mm256_srlv_epi32(set, extension), one),
+                  zero)),
+          _mm256_cmpeq_epi32(_mm256_and_si256(w, mask), match));
+
+      // the fields, as materialize has them
+      const auto registers =
+          _mm256_or_si256(bits(_mm256_slli_epi32(w, 1), 0x001F'1F00),
+                          bits(_mm256_slli_epi32(w, 4), 0x1F00'0000));
+      const auto low = _mm256_or_si256(
+          id,
+          _mm256_and_si256(registers,
+                           _mm256_permutevar8x32_epi32(fields, format)));
+      const auto sign = _mm256_srai_epi32(w, 31);
+      const auto i_imm = _mm256_srai_epi32(w, 20);
+      const auto s_imm = _mm256_or_si256(bits(i_imm, ~0x1Fu),
+                                         bits(_mm256_srli_epi32(w, 7), 0x1F));
+      const auto b_imm = _mm256_or_si256(
+          _mm256_or_si256(bits(sign, ~0xFFFu),
+                          bits(_mm256_slli_epi32(w, 4), 0x800)),
+          _mm256_or_si256(bits(_mm256_srli_epi32(w, 20), 0x7E0),
+                          bits(_mm256_srli_epi32(w, 7), 0x1E)));
+      const auto j_imm = _mm256_or_si256(
+          _mm256_or_si256(bits(sign, ~0xF'FFFFu), bits(w, 0xF'F000)),
+          _mm256_or_si256(bits(_mm256_srli_epi32(w, 9), 0x800),
+                          bits(_mm256_srli_epi32(w, 20), 0x7FE)));
+      const auto imm = _mm256_or_si256(
+          _mm256_or_si256(
+              _mm256_or_si256(pick(format, Format::kI, i_imm),
+                              pick(format, Format::kIShift, bits(i_imm, 0x1F))),
+              _mm256_or_si256(pick(format, Format::kS, s_imm),
+                              pick(format, Format::kB, b_imm))),
+          _mm256_or_si256(pick(format, Format::kU, bits(w, 0xFFFF'F000)),
+                          pick(format, Format::kJ, j_imm)));
+
+      // descriptors 0, 1, 4, 5 and 2, 3, 6, 7; invalid ones all zero
+      const auto first = _mm256_and_si256(low, valid);
+      const auto second = _mm256_and_si256(imm, valid);
+      const auto lower = _mm256_unpacklo_epi32(first, second);
+      const auto upper = _mm256_unpackhi_epi32(first, second);
+      const auto target = reinterpret_cast<__m256i *>(out.data() + i);
+      _mm256_storeu_si256(target,
+                          _mm256_permute2x128_si256(lower, upper, 0x20));
+      _mm256_storeu_si256(target + 1,
+                          _mm256_permute2x128_si256(lower, upper, 0x31));
+    }
+    return i;
+  }
+#endif
+#if LUCE_DECODE_NEON
+  /// @return how many words, a multiple of four, were decoded. NEON has no
+  /// gathers, so the table is read lane by lane; the fields are not.
+  static auto neon(const DecodeTable &table,
+                   const std::span<const uint32_t> words,
+                   const std::span<Descriptor> out,
+                   const ExtensionSet extensions) noexcept -> size_t {
+    size_t i = 0;
+    for (; i + 4 <= words.size(); i += 4) {
+      uint32_t ids[4], masks[4], matches[4], enabled[4], formats[4], kept[4];
+      for (size_t lane = 0; lane < 4; ++lane) {
+        const auto id = table.cells_[table.cell_of(words[i + lane])];
+        const auto &e = table.encodings_[static_cast<size_t>(id)];
+        ids[lane] = static_cast<uint32_t>(id);
+        masks[lane] = e.mask;
+        matches[lane] = e.match;
+        enabled[lane] = id != Descriptor::Id::kInvalid &&
+                                (extensions & set_of(e.extension))
+                            ? ~0u
+                            : 0u;
+        formats[lane] = static_cast<uint32_t>(e.format);
+        kept[lane] = field_bytes[formats[lane]];
+      }
+      const auto w = vld1q_u32(words.data() + i);
+      const auto format = vld1q_u32(formats);
+      const auto valid =
+          vandq_u32(vld1q_u32(enabled),
+                    vceqq_u32(vandq_u32(w, vld1q_u32(masks)),
+                              vld1q_u32(matches)));
+
+      const auto registers =
+          vorrq_u32(bits(vshlq_n_u32(w, 1), 0x001F'1F00),
+                    bits(vshlq_n_u32(w, 4), 0x1F00'0000));
+      const auto low =
+          vorrq_u32(vld1q_u32(ids), vandq_u32(registers, vld1q_u32(kept)));
+      const auto signed_w = vreinterpretq_s32_u32(w);
+      const auto sign = vreinterpretq_u32_s32(vshrq_n_s32(signed_w, 31));
+      const auto i_imm = vreinterpretq_u32_s32(vshrq_n_s32(signed_w, 20));
+      const auto s_imm =
+          vorrq_u32(bits(i_imm, ~0x1Fu), bits(vshrq_n_u32(w, 7), 0x1F));
+      const auto b_imm = vorrq_u32(
+          vorrq_u32(bits(sign, ~0xFFFu), bits(vshlq_n_u32(w, 4), 0x800)),
+          vorrq_u32(bits(vshrq_n_u32(w, 20), 0x7E0),
+                    bits(vshrq_n_u32(w, 7), 0x1E)));
+      const auto j_imm = vorrq_u32(
+          vorrq_u32(bits(sign, ~0xF'FFFFu), bits(w, 0xF'F000)),
+          vorrq_u32(bits(vshrq_n_u32(w, 9), 0x800),
+                    bits(vshrq_n_u32(w, 20), 0x7FE)));
+      const auto imm = vorrq_u32(
+          vorrq_u32(vorrq_u32(pick(format, Format::kI, i_imm),
+                              pick(format, Format::kIShift, bits(i_imm, 0x1F))),
+                    vorrq_u32(pick(format, Format::kS, s_imm),
+                              pick(format, Format::kB, b_imm))),
+          vorrq_u32(pick(format, Format::kU, bits(w, 0xFFFF'F000)),
+                    pick(format, Format::kJ, j_imm)));
+
+      // interleaved back into descriptors; invalid ones all zero
+      const auto pairs =
+          uint32x4x2_t{{vandq_u32(low, valid), vandq_u32(imm, valid)}};
+      vst2q_u32(reinterpret_cast<uint32_t *>(out.data() + i), pairs);
+    }
+    return i;
+  }
+#endif
+};
+
+auto DecodeTable::describe_n(const std::span<const uint32_t> words,
+                             const std::span<Descriptor> out,
+                             const ExtensionSet extensions) const noexcept
+    -> void {
+  size_t done = 0;
+#if LUCE_DECODE_AVX2
+  static const auto avx2 = host_has_avx2();
+  if (avx2)
+    done = Batch::avx2(*this, words, out, extensions);
+#elif LUCE_DECODE_NEON
+  done = Batch::neon(*this, words, out, extensions);
+#endif
+  describe_n_scalar(words.subspan(done), out.subspan(done), extensions);
+}
+} // namespace accat::luce::isa::riscv32
@@ -5,6 +5,45 @@
 
 
 namespace accat::luce::isa::riscv32 {
+auto Disassembler::disassemble(const uint32_t num)
+    -> std::unique_ptr<IInstruction> {
+  if (foreign_)
+    return IDisassembler::disassemble(num);
+
+  const auto descriptor = describe(num);
+  if (!descriptor)
+    return nullptr;
+  const auto extension = decode_table.extension_of(descriptor.id);
+  return decoders_of_[static_cast<uint8_t>(extension)]->decode(num);
+}
+auto Disassembler::describe(const uint32_t num) const -> Descriptor {
+  if (foreign_)
+    return IDisassembler::describe(num);
+
+  contract_assert(initialized(), "Disassembler not initialized");
+  return decode_table.describe(num, extensions_);
+}
+auto Disassembler::describe_n(const std::span<const uint32_t> words,
+                              const std::span<Descriptor> out) const -> void {
+  if (foreign_)
+    return IDisassembler::describe_n(words, out);
+
+  contract_assert(initialized(), "Disassembler not initialized");
+  decode_table.describe_n(words, out, extensions_);
+}
+auto Disassembler::registered(IDecoder &decoder) -> void {
+  const auto extension_decoder = dynamic_cast<ExtensionDecoder *>(&decoder);
+  if (!extension_decoder) {
+    foreign_ = true;
+    return;
+  }
+  const auto extension = extension_decoder->extension();
+  // the first decoder of an extension wins, as it would in the walk
+  if (extensions_ & set_of(extension))
+    return;
+  extensions_ |= set_of(extension);
+  decoders_of_[static_cast<uint8_t>(extension)] = extension_decoder;
+}
 auto Disassembler::initializeDefaultImpl() -> IDisassembler & {
   defer {
     spdlog::info(
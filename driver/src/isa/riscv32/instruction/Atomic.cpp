@@ -34,7 +34,7 @@ auto Sc::execute(Icpu *cpu) const -> ExecutionStatus {
 
   [[maybe_unused]] auto res = cpu->write(gpr[rs1()],
                                          std::as_bytes( // write a word
-                                             std::span{&gpr[rs2()], 4}));
+                                             std::span{&gpr[rs2()], 1}));
   contract_assert(res.ok(),
                   "write failed. you should check the address before it "
                   "stored into atomic_address.");
@@ -87,52 +87,30 @@ auto Min::asmStr() const noexcept -> string_type {
   return fmt::format("min.w x{}, x{}, x{}", rd(), rs1(), rs2());
 }
 #pragma endregion Atomic
-#pragma region DecodeImpl
-class DecodeImpl : public Word,
-                   mixin::opcode0To6Common,
-                   mixin::funct3rd12To15Common,
-                   mixin::funct5th27To32Common {
-  using inst_t = IInstruction;
-  using inst_ptr_t = std::unique_ptr<inst_t>;
-  friend class Decoder;
-
-protected:
-  using Word::Word;
-  inst_ptr_t decode() const;
-};
-auto DecodeImpl::decode() const -> inst_ptr_t {
-  if (opcode() != 0b0101111)
-    return nullptr;
-  if (funct3() != 0x2)
-    return nullptr;
-  switch (funct5()) {
-  case 0x02:
-    return std::make_unique<Lr>(num());
-  case 0x03:
-    return std::make_unique<Sc>(num());
-  case 0x01:
-    return std::make_unique<Swap>(num());
-  case 0x00:
-    return std::make_unique<Add>(num());
-  case 0x0C:
-    return std::make_unique<And>(num());
-  case 0x0A:
-    return std::make_unique<Or>(num());
-  case 0x04:
-    return std::make_unique<Xor>(num());
-  case 0x14:
-    return std::make_unique<Max>(num());
-  case 0x10:
-    return std::make_unique<Min>(num());
+#pragma region Decoder
+auto Decoder::decode(const uint32_t num) -> std::unique_ptr<IInstruction> {
+  switch (describe(num).id) {
+  case Descriptor::Id::kLr:
+    return std::make_unique<Lr>(num);
+  case Descriptor::Id::kSc:
+    return std::make_unique<Sc>(num);
+  case Descriptor::Id::kAmoSwap:
+    return std::make_unique<Swap>(num);
+  case Descriptor::Id::kAmoAdd:
+    return std::make_unique<Add>(num);
+  case Descriptor::Id::kAmoAnd:
+    return std::make_unique<And>(num);
+  case Descriptor::Id::kAmoOr:
+    return std::make_unique<Or>(num);
+  case Descriptor::Id::kAmoXor:
+    return std::make_unique<Xor>(num);
+  case Descriptor::Id::kAmoMax:
+    return std::make_unique<Max>(num);
+  case Descriptor::Id::kAmoMin:
+    return std::make_unique<Min>(num);
   default:
     return nullptr;
   }
 }
-#pragma endregion DecodeImpl
-#pragma region Decoder
-auto Decoder::decode(uint32_t num) -> std::unique_ptr<IInstruction> {
-  DecodeImpl decoder(num);
-  return decoder.decode();
-}
 #pragma endregion Decoder
 } // namespace accat::luce::isa::riscv32::instruction::atomic
@@ -160,7 +160,8 @@ auto Srai::asmStr() const noexcept -> string_type {
 auto Slti::execute(Icpu *cpu) const -> ExecutionStatus {
   // signed
   auto &gpr = cpu->gpr();
-  gpr.write_at(rd()) = as<signed_num_type>(gpr[rs1()] < imm());
+  gpr.write_at(rd()) =
+      as<signed_num_type>(gpr[rs1()]) < as<signed_num_type>(imm());
   return kOk;
 }
 auto Slti::asmStr() const noexcept -> string_type {
@@ -178,13 +179,10 @@ auto Sltiu::asmStr() const noexcept -> string_type {
 auto Lb::execute(Icpu *cpu) const -> ExecutionStatus {
   // signed
   auto &gpr = cpu->gpr();
-  auto maybe_bytes = cpu->fetch(gpr[rs1()] + imm());
-  if (!maybe_bytes) {
+  int8_t value;
+  if (!cpu->load(gpr[rs1()] + imm(), value)) [[unlikely]]
     return kMemoryViolation;
-  }
-  auto bytes =
-      *reinterpret_cast<const num_type *>(std::move(maybe_bytes)->data());
-  gpr.write_at(rd()) = as<signed_num_type>(bytes & 0xFF);
+  gpr.write_at(rd()) = as<signed_num_type>(value);
   return kOk;
 }
 auto Lb::asmStr() const noexcept -> string_type {
@@ -194,13 +192,10 @@ auto Lb::asmStr() const noexcept -> string_type {
 auto Lh::execute(Icpu *cpu) const -> ExecutionStatus {
   // signed
   auto &gpr = cpu->gpr();
-  auto maybe_bytes = cpu->fetch(gpr[rs1()] + imm());
-  if (!maybe_bytes) {
+  int16_t value;
+  if (!cpu->load(gpr[rs1()] + imm(), value)) [[unlikely]]
     return kMemoryViolation;
-  }
-  auto bytes =
-      *reinterpret_cast<const num_type *>(std::move(maybe_bytes)->data());
-  gpr.write_at(rd()) = as<signed_num_type>(bytes & 0xFFFF);
+  gpr.write_at(rd()) = as<signed_num_type>(value);
   return kOk;
 }
 auto Lh::asmStr() const noexcept -> string_type {
@@ -209,13 +204,10 @@ auto Lh::asmStr() const noexcept -> string_type {
 
 auto Lw::execute(Icpu *cpu) const -> ExecutionStatus {
   auto &gpr = cpu->gpr();
-  auto maybe_bytes = cpu->fetch(gpr[rs1()] + imm());
-  if (!maybe_bytes) {
+  num_type value;
+  if (!cpu->load(gpr[rs1()] + imm(), value)) [[unlikely]]
     return kMemoryViolation;
-  }
-  auto bytes =
-      *reinterpret_cast<const num_type *>(std::move(maybe_bytes)->data());
-  gpr.write_at(rd()) = as<signed_num_type>(bytes);
+  gpr.write_at(rd()) = value;
   return kOk;
 }
 auto Lw::asmStr() const noexcept -> string_type {
@@ -225,13 +217,10 @@ auto Lw::asmStr() const noexcept -> string_type {
 auto Lbu::execute(Icpu *cpu) const -> ExecutionStatus {
   // zero-extend(unsigned)
   auto &gpr = cpu->gpr();
-  auto maybe_bytes = cpu->fetch(gpr[rs1()] + imm());
-  if (!maybe_bytes) {
+  uint8_t value;
+  if (!cpu->load(gpr[rs1()] + imm(), value)) [[unlikely]]
     return kMemoryViolation;
-  }
-  auto bytes =
-      *reinterpret_cast<const num_type *>(std::move(maybe_bytes)->data());
-  gpr.write_at(rd()) = bytes & 0xFF;
+  gpr.write_at(rd()) = value;
   return kOk;
 }
 auto Lbu::asmStr() const noexcept -> string_type {
@@ -241,13 +230,10 @@ auto Lbu::asmStr() const noexcept -> string_type {
 auto Lhu::execute(Icpu *cpu) const -> ExecutionStatus {
   // zero-extend
   auto &gpr = cpu->gpr();
-  auto maybe_bytes = cpu->fetch(gpr[rs1()] + imm());
-  if (!maybe_bytes) {
+  uint16_t value;
+  if (!cpu->load(gpr[rs1()] + imm(), value)) [[unlikely]]
     return kMemoryViolation;
-  }
-  auto bytes =
-      *reinterpret_cast<const num_type *>(std::move(maybe_bytes)->data());
-  gpr.write_at(rd()) = bytes & 0xFFFF;
+  gpr.write_at(rd()) = value;
   return kOk;
 }
 auto Lhu::asmStr() const noexcept -> string_type {
@@ -258,18 +244,9 @@ auto Lhu::asmStr() const noexcept -> string_type {
 auto Sb::execute(Icpu *cpu) const -> ExecutionStatus {
   auto &gpr = cpu->gpr();
   // M[rs1+imm][0:7] = rs2[0:7]
-  auto maybe_bytes = cpu->fetch(gpr[rs1()] + imm());
-  if (!maybe_bytes) {
-    return kMemoryViolation;
-  }
-  auto bytes =
-      *reinterpret_cast<const num_type *>(std::move(maybe_bytes)->data());
-  bytes = (bytes & 0xFFFFFF00) | (gpr[rs2()] & 0xFF);
-  auto status =
-      cpu->write(gpr[rs1()] + imm(), std::as_bytes(std::span{&bytes, 1}));
-  if (!status) {
+  if (!cpu->store(gpr[rs1()] + imm(), static_cast<uint8_t>(gpr[rs2()])))
+      [[unlikely]]
     return kMemoryViolation;
-  }
   return kOk;
 }
 auto Sb::asmStr() const noexcept -> string_type {
@@ -279,18 +256,9 @@ auto Sb::asmStr() const noexcept -> string_type {
 auto Sh::execute(Icpu *cpu) const -> ExecutionStatus {
   auto &gpr = cpu->gpr();
   // M[rs1+imm][0:15] = rs2[0:15]
-  auto maybe_bytes = cpu->fetch(gpr[rs1()] + imm());
-  if (!maybe_bytes) {
-    return kMemoryViolation;
-  }
-  auto bytes =
-      *reinterpret_cast<const num_type *>(std::move(maybe_bytes)->data());
-  bytes = (bytes & 0xFFFF0000) | (gpr[rs2()] & 0xFFFF);
-  auto status =
-      cpu->write(gpr[rs1()] + imm(), std::as_bytes(std::span{&bytes, 2}));
-  if (!status) {
+  if (!cpu->store(gpr[rs1()] + imm(), static_cast<uint16_t>(gpr[rs2()])))
+      [[unlikely]]
     return kMemoryViolation;
-  }
   return kOk;
 }
 auto Sh::asmStr() const noexcept -> string_type {
@@ -300,11 +268,9 @@ auto Sh::asmStr() const noexcept -> string_type {
 auto Sw::execute(Icpu *cpu) const -> ExecutionStatus {
   auto &gpr = cpu->gpr();
   // M[rs1+imm][0:31] = rs2[0:31]
-  auto status =
-      cpu->write(gpr[rs1()] + imm(), std::as_bytes(std::span{&gpr[rs2()], 4}));
-  if (!status) {
+  if (!cpu->store(gpr[rs1()] + imm(), static_cast<num_type>(gpr[rs2()])))
+      [[unlikely]]
     return kMemoryViolation;
-  }
   return kOk;
 }
 auto Sw::asmStr() const noexcept -> string_type {
@@ -388,7 +354,8 @@ auto Jal::asmStr() const noexcept -> string_type {
 auto Jalr::execute(Icpu *cpu) const -> ExecutionStatus {
   auto &gpr = cpu->gpr();
   auto t = cpu->pc().num() + 4;
-  cpu->pc().num() = (gpr[rs1()] + imm());
+  // the least-significant bit is cleared
+  cpu->pc().num() = (gpr[rs1()] + imm()) & ~1u;
   gpr.write_at(rd()) = t;
   return kOkButDontBotherPC;
 }
@@ -399,7 +366,7 @@ auto Jalr::asmStr() const noexcept -> string_type {
 #pragma region UpperImm
 auto Lui::execute(Icpu *cpu) const -> ExecutionStatus {
   auto &gpr = cpu->gpr();
-  gpr.write_at(rd()) = imm();
+  gpr.write_at(rd()) = imm() << 12;
   return kOk;
 }
 auto Lui::asmStr() const noexcept -> string_type {
@@ -407,7 +374,7 @@ auto Lui::asmStr() const noexcept -> string_type {
 }
 auto Auipc::execute(Icpu *cpu) const -> ExecutionStatus {
   auto &gpr = cpu->gpr();
-  gpr.write_at(rd()) = cpu->pc().num() + imm();
+  gpr.write_at(rd()) = cpu->pc().num() + (imm() << 12);
   return kOk;
 }
 auto Auipc::asmStr() const noexcept -> string_type {
@@ -427,195 +394,57 @@ auto Ebreak::execute(Icpu *cpu) const -> ExecutionStatus {
 auto Ebreak::asmStr() const noexcept -> string_type {
   return "ebreak";
 }
-#pragma endregion System
-#pragma region DecodeImpl
-class DecodeImpl : public Word,
-                   mixin::opcode0To6Common,
-                   mixin::rd7To12Common,
-                   mixin::funct3rd12To15Common,
-                   mixin::funct7th25To32Common,
-                   mixin::rs1st15To20Common,
-                   mixin::rs2nd20To25Common {
-  using inst_t = IInstruction;
-  using inst_ptr_t = std::unique_ptr<inst_t>;
-  friend class Decoder;
-
-protected:
-  using Word::Word;
-  inst_ptr_t decode() const;
-  inst_ptr_t decodeBaseRType() const;
-  inst_ptr_t decodeBaseIType() const;
-  inst_ptr_t decodeLoadIType() const;
-  inst_ptr_t decodeJalr() const;
-  inst_ptr_t decodeSpecialCategory() const;
-  inst_ptr_t decodeSType() const;
-  inst_ptr_t decodeBType() const;
-  inst_ptr_t decodeLui() const;
-  inst_ptr_t decodeAuipc() const;
-  inst_ptr_t decodeJal() const;
-};
-auto DecodeImpl::decode() const -> inst_ptr_t {
-  switch (opcode()) {
-  case 0b0110011:
-    return decodeBaseRType();
-  case 0b0010011:
-    return decodeBaseIType();
-  case 0b0000011:
-    return decodeLoadIType();
-  case 0b0100011:
-    return decodeSType();
-  case 0b1100011:
-    return decodeBType();
-  case 0b0110111:
-    return decodeLui();
-  case 0b0010111:
-    return decodeAuipc();
-  case 0b1101111:
-    return decodeJal();
-  case 0b1100111:
-    return decodeJalr();
-  case 0b1110011:
-    return decodeSpecialCategory();
-  }
-  return nullptr;
-}
-auto DecodeImpl::decodeBaseRType() const -> inst_ptr_t {
-  precondition(opcode() == 0b0110011, "Not R-type");
-  const auto f3 = funct3();
-  const auto f7 = funct7();
-  if (f3 == 0x0 and f7 == 0x00) {
-    return std::make_unique<Add>(num());
-  } else if (f3 == 0x0 and f7 == 0x20) {
-    return std::make_unique<Sub>(num());
-  } else if (f3 == 0x4 and f7 == 0x00) {
-    return std::make_unique<Xor>(num());
-  } else if (f3 == 0x6 and f7 == 0x00) {
-    return std::make_unique<Or>(num());
-  } else if (f3 == 0x7 and f7 == 0x00) {
-    return std::make_unique<And>(num());
-  } else if (f3 == 0x1 and f7 == 0x00) {
-    return std::make_unique<Sll>(num());
-  } else if (f3 == 0x5 and f7 == 0x00) {
-    return std::make_unique<Srl>(num());
-  } else if (f3 == 0x5 and f7 == 0x20) {
-    return std::make_unique<Sra>(num());
-  } else if (f3 == 0x2 and f7 == 0x00) {
-    return std::make_unique<Slt>(num());
-  } else if (f3 == 0x3 and f7 == 0x00) {
-    return std::make_unique<Sltu>(num());
-  } else {
-    return nullptr;
-  }
-}
-auto DecodeImpl::decodeBaseIType() const -> inst_ptr_t {
-  const auto imm5To11 = extractBits<25, 32>(num());
-  const auto f3 = funct3();
-  if (f3 == 0x0) {
-    return std::make_unique<Addi>(num());
-  } else if (f3 == 0x4) {
-    return std::make_unique<Xori>(num());
-  } else if (f3 == 0x6) {
-    return std::make_unique<Ori>(num());
-  } else if (f3 == 0x7) {
-    return std::make_unique<Andi>(num());
-  } else if (f3 == 0x1 and imm5To11 == 0x00) {
-    return std::make_unique<Slli>(num());
-  } else if (f3 == 0x5 and imm5To11 == 0x00) {
-    return std::make_unique<Srli>(num());
-  } else if (f3 == 0x5 and imm5To11 == 0x20) {
-    return std::make_unique<Srai>(num());
-  } else if (f3 == 0x2) {
-    return std::make_unique<Slti>(num());
-  } else if (f3 == 0x3) {
-    return std::make_unique<Sltiu>(num());
-  } else {
-    return nullptr;
-  }
+auto Wfi::execute(Icpu *) const -> ExecutionStatus {
+  // nothing ever interrupts the hart, and the spec lets `wfi` return at any
+  // time; the loop around it is what the monitor finds idle
+  return kOk;
 }
-DecodeImpl::inst_ptr_t DecodeImpl::decodeLoadIType() const {
-  switch (funct3()) {
-  case 0x0:
-    return std::make_unique<Lb>(num());
-  case 0x1:
-    return std::make_unique<Lh>(num());
-  case 0x2:
-    return std::make_unique<Lw>(num());
-  case 0x4:
-    return std::make_unique<Lbu>(num());
-  case 0x5:
-    return std::make_unique<Lhu>(num());
+auto Wfi::asmStr() const noexcept -> string_type {
+  return "wfi";
+}
+auto Csrrs::execute(Icpu *cpu) const -> ExecutionStatus {
+  // only the counters are there, and they are read-only(`rs1` must be x0).
+  // time ticks at 1 GHz
+  const auto csr = static_cast<uint32_t>(imm()) & 0xFFF;
+  if (rs1() != 0)
+    return kInvalidInstruction;
+  uint64_t value = 0;
+  switch (csr & ~0x80u) {
+  case 0xC00: // cycle, cycleh
+    value = cpu->cycles();
+    break;
+  case 0xC01: // time, timeh
+    value = cpu->time();
+    break;
+  case 0xC02: // instret, instreth
+    value = cpu->instret();
+    break;
+  default:
+    return kInvalidInstruction;
   }
-  return nullptr;
+  cpu->gpr().write_at(rd()) =
+      static_cast<uint32_t>(csr & 0x80 ? value >> 32 : value);
+  return kOk;
 }
-DecodeImpl::inst_ptr_t DecodeImpl::decodeJalr() const {
-  precondition(opcode() == 0b1100111, "Not a JALR type");
-  if (funct3() != 0x0)
-    return nullptr;
-  return std::make_unique<Jalr>(num());
+auto Csrrs::asmStr() const noexcept -> string_type {
+  return fmt::format("csrrs x{}, {:#05x}, x{}",
+                     rd(),
+                     static_cast<uint32_t>(imm()) & 0xFFF,
+                     rs1());
 }
-DecodeImpl::inst_ptr_t DecodeImpl::decodeSpecialCategory() const {
-  precondition(opcode() == 0b1110011, "Not a system type");
-  if (funct3() != 0x0)
-    return nullptr;
+#pragma endregion System
 
-  if (const auto imm = extractBits<20, 32>(num()); imm == 0x000) {
-    return std::make_unique<Ecall>(num());
-  } else if (imm == 0x001) {
-    return std::make_unique<Ebreak>(num());
-  } else {
+#pragma region Decoder
+auto Decoder::decode(const uint32_t num) -> std::unique_ptr<IInstruction> {
+  switch (describe(num).id) {
+#define LUCE_MATERIALIZE(_name_)                                               \
+  case Descriptor::Id::k##_name_:                                              \
+    return std::make_unique<_name_>(num);
+    LUCE_ISA_BASE_LIST(LUCE_MATERIALIZE)
+#undef LUCE_MATERIALIZE
+  default:
     return nullptr;
   }
 }
-auto DecodeImpl::decodeSType() const -> inst_ptr_t {
-  precondition(opcode() == 0b0100011, "Not a S-type");
-
-  switch (funct3()) {
-  case 0x0:
-    return std::make_unique<Sb>(num());
-  case 0x1:
-    return std::make_unique<Sh>(num());
-  case 0x2:
-    return std::make_unique<Sw>(num());
-  }
-  return nullptr;
-}
-auto DecodeImpl::decodeBType() const -> inst_ptr_t {
-  precondition(opcode() == 0b1100011, "Not a B-type");
-
-  switch (funct3()) {
-  case 0x0:
-    return std::make_unique<Beq>(num());
-  case 0x1:
-    return std::make_unique<Bne>(num());
-  case 0x4:
-    return std::make_unique<Blt>(num());
-  case 0x5:
-    return std::make_unique<Bge>(num());
-  case 0x6:
-    return std::make_unique<Bltu>(num());
-  case 0x7:
-    return std::make_unique<Bgeu>(num());
-  }
-  return nullptr;
-}
-auto DecodeImpl::decodeLui() const -> inst_ptr_t {
-  precondition(opcode() == 0b0110111, "Not a LUI type");
-  return std::make_unique<Lui>(num());
-}
-auto DecodeImpl::decodeAuipc() const -> inst_ptr_t {
-  precondition(opcode() == 0b0010111, "Not an AUIPC type");
-  return std::make_unique<Auipc>(num());
-}
-auto DecodeImpl::decodeJal() const -> inst_ptr_t {
-  precondition(opcode() == 0b1101111, "Not a JAL type");
-  return std::make_unique<Jal>(num());
-}
-#pragma endregion DecodeImpl
-
-#pragma region Decoder
-auto Decoder::decode(uint32_t inst) -> std::unique_ptr<IInstruction> {
-  DecodeImpl decoder(inst);
-  return decoder.decode();
-}
 #pragma endregion Decoder
 } // namespace accat::luce::isa::riscv32::instruction::base
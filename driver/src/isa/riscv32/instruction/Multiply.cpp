@@ -1,5 +1,6 @@
 #include <accat/auxilia/auxilia.hpp>
 #include <cstdint>
+#include <limits>
 
 #include "luce/Support/isa/Icpu.hpp"
 
@@ -26,7 +27,8 @@ auto Mulh::asmStr() const noexcept -> string_type {
 auto Mulh::execute(Icpu *cpu) const -> ExecutionStatus {
   // signed, signed -> signed
   auto &gpr = cpu->gpr();
-  auto num = as<int64_t>(gpr[rs1()]) * as<int64_t>(gpr[rs2()]);
+  auto num = as<int64_t>(as<signed_num_type>(gpr[rs1()])) *
+             as<int64_t>(as<signed_num_type>(gpr[rs2()]));
   // [63:32]
   gpr.write_at(rd()) = as<signed_num_type>(extractBits<32, 64>(num));
   return kOk;
@@ -37,7 +39,8 @@ auto Mulsu::asmStr() const noexcept -> string_type {
 auto Mulsu::execute(Icpu *cpu) const -> ExecutionStatus {
   // signed, unsigned -> signed
   auto &gpr = cpu->gpr();
-  auto num = as<int64_t>(gpr[rs1()]) * as<uint64_t>(gpr[rs2()]);
+  auto num = as<int64_t>(as<signed_num_type>(gpr[rs1()])) *
+             as<int64_t>(gpr[rs2()]);
   // [63:32]
   gpr.write_at(rd()) = as<signed_num_type>(extractBits<32, 64>(num));
   return kOk;
@@ -59,8 +62,16 @@ auto Div::asmStr() const noexcept -> string_type {
 auto Div::execute(Icpu *cpu) const -> ExecutionStatus {
   // signed, signed -> signed
   auto &gpr = cpu->gpr();
-  auto num = as<signed_num_type>(gpr[rs1()]) / as<signed_num_type>(gpr[rs2()]);
-  gpr.write_at(rd()) = as<signed_num_type>(num);
+  const auto dividend = as<signed_num_type>(gpr[rs1()]);
+  const auto divisor = as<signed_num_type>(gpr[rs2()]);
+  // no trap on division by zero or overflow, as the spec says
+  if (divisor == 0)
+    gpr.write_at(rd()) = as<num_type>(-1);
+  else if (dividend == std::numeric_limits<signed_num_type>::min() &&
+           divisor == -1)
+    gpr.write_at(rd()) = as<num_type>(dividend);
+  else
+    gpr.write_at(rd()) = as<num_type>(dividend / divisor);
   return kOk;
 }
 auto Divu::asmStr() const noexcept -> string_type {
@@ -69,8 +80,9 @@ auto Divu::asmStr() const noexcept -> string_type {
 auto Divu::execute(Icpu *cpu) const -> ExecutionStatus {
   // unsigned, unsigned -> unsigned
   auto &gpr = cpu->gpr();
-  auto num = as<num_type>(gpr[rs1()]) / as<num_type>(gpr[rs2()]);
-  gpr.write_at(rd()) = as<num_type>(num);
+  const auto divisor = as<num_type>(gpr[rs2()]);
+  gpr.write_at(rd()) = divisor ? as<num_type>(gpr[rs1()]) / divisor
+                               : std::numeric_limits<num_type>::max();
   return kOk;
 }
 auto Rem::asmStr() const noexcept -> string_type {
@@ -79,8 +91,15 @@ auto Rem::asmStr() const noexcept -> string_type {
 auto Rem::execute(Icpu *cpu) const -> ExecutionStatus {
   // signed, signed -> signed
   auto &gpr = cpu->gpr();
-  auto num = as<signed_num_type>(gpr[rs1()]) % as<signed_num_type>(gpr[rs2()]);
-  gpr.write_at(rd()) = as<signed_num_type>(num);
+  const auto dividend = as<signed_num_type>(gpr[rs1()]);
+  const auto divisor = as<signed_num_type>(gpr[rs2()]);
+  if (divisor == 0)
+    gpr.write_at(rd()) = as<num_type>(dividend);
+  else if (dividend == std::numeric_limits<signed_num_type>::min() &&
+           divisor == -1)
+    gpr.write_at(rd()) = 0;
+  else
+    gpr.write_at(rd()) = as<num_type>(dividend % divisor);
   return kOk;
 }
 auto Remu::asmStr() const noexcept -> string_type {
@@ -89,56 +108,23 @@ auto Remu::asmStr() const noexcept -> string_type {
 auto Remu::execute(Icpu *cpu) const -> ExecutionStatus {
   // unsigned, unsigned -> unsigned
   auto &gpr = cpu->gpr();
-  auto num = as<num_type>(gpr[rs1()]) % as<num_type>(gpr[rs2()]);
-  gpr.write_at(rd()) = as<num_type>(num);
+  const auto divisor = as<num_type>(gpr[rs2()]);
+  gpr.write_at(rd()) =
+      divisor ? as<num_type>(gpr[rs1()]) % divisor : gpr[rs1()];
   return kOk;
 }
 #pragma endregion Multiply
-#pragma region DecodeImpl
-class DecodeImpl : public Word,
-                   mixin::opcode0To6Common,
-                   mixin::funct3rd12To15Common,
-                   mixin::funct7th25To32Common {
-  using inst_t = IInstruction;
-  using inst_ptr_t = std::unique_ptr<inst_t>;
-  friend class Decoder;
-
-protected:
-  using Word::Word;
-  inst_ptr_t decode() const;
-};
-auto DecodeImpl::decode() const -> inst_ptr_t {
-  if (opcode() != 0b0110011)
-    return nullptr;
-  if (funct7() != 0b01)
-    return nullptr;
-
-  switch (funct3()) {
-  case 0x0:
-    return std::make_unique<Mul>(num());
-  case 0x1:
-    return std::make_unique<Mulh>(num());
-  case 0x2:
-    return std::make_unique<Mulsu>(num());
-  case 0x3:
-    return std::make_unique<Mulu>(num());
-  case 0x4:
-    return std::make_unique<Div>(num());
-  case 0x5:
-    return std::make_unique<Divu>(num());
-  case 0x6:
-    return std::make_unique<Rem>(num());
-  case 0x7:
-    return std::make_unique<Remu>(num());
+#pragma region Decoder
+auto Decoder::decode(const uint32_t num) -> std::unique_ptr<IInstruction> {
+  switch (describe(num).id) {
+#define LUCE_MATERIALIZE(_name_)                                               \
+  case Descriptor::Id::k##_name_:                                              \
+    return std::make_unique<_name_>(num);
+    LUCE_ISA_MULTIPLY_LIST(LUCE_MATERIALIZE)
+#undef LUCE_MATERIALIZE
   default:
     return nullptr;
   }
 }
-#pragma endregion DecodeImpl
-#pragma region Decoder
-auto Decoder::decode(uint32_t inst) -> std::unique_ptr<IInstruction> {
-  DecodeImpl decoder(inst);
-  return decoder.decode();
-}
 #pragma endregion Decoder
 } // namespace accat::luce::isa::riscv32::instruction::multiply
@@ -0,0 +1,646 @@
+#include "deps.hh"
+
+#include "luce/cpu/jit.hpp"
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstring>
+#include <optional>
+#include <ranges>
+#include <vector>
+#include "luce/cpu/block.hpp"
+#include "luce/cpu/cpu.hpp"
+#include "luce/cpu/ir.hpp"
+#include "luce/cpu/x86_64.hpp"
+#include "luce/Monitor.hpp"
+
+#if defined(_WIN32)
+#  ifndef WIN32_LEAN_AND_MEAN
+#    define WIN32_LEAN_AND_MEAN
+#  endif
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  include <Windows.h>
+#else
+#  include <sys/mman.h>
+#  include <unistd.h>
+#endif
+
+namespace accat::luce {
+namespace {
+using Op = ThreadedCode::Op;
+using Record = ThreadedCode::Record;
+using x86_64::Alu;
+using x86_64::Assembler;
+using x86_64::Cond;
+using x86_64::Reg;
+using x86_64::Shift;
+using x86_64::Width;
+using x86_64::at;
+
+auto AllocateCode(const size_t size) noexcept -> std::byte * {
+#if defined(_WIN32)
+  return static_cast<std::byte *>(
+      VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+#else
+  const auto ptr =
+      mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+           -1, 0);
+  return ptr == MAP_FAILED ? nullptr : static_cast<std::byte *>(ptr);
+#endif
+}
+/// W^X: the buffer is either writable or executable, never both
+auto ProtectCode(std::byte *code, const size_t size, const bool writable)
+    -> bool {
+#if defined(_WIN32)
+  DWORD previous;
+  return VirtualProtect(code,
+                        size,
+                        writable ? PAGE_READWRITE : PAGE_EXECUTE_READ,
+                        &previous) &&
+         FlushInstructionCache(GetCurrentProcess(), code, size);
+#else
+  return mprotect(code,
+                  size,
+                  writable ? PROT_READ | PROT_WRITE
+                           : PROT_READ | PROT_EXEC) == 0;
+#endif
+}
+auto HostPageSize() noexcept -> size_t {
+#if defined(_WIN32)
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return info.dwPageSize;
+#else
+  return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+void FreeCode(std::byte *code, const size_t size) noexcept {
+#if defined(_WIN32)
+  (void)size;
+  VirtualFree(code, 0, MEM_RELEASE);
+#else
+  munmap(code, size);
+#endif
+}
+
+#if defined(_WIN32)
+inline constexpr auto kArgument = Reg::rcx;
+#else
+inline constexpr auto kArgument = Reg::rdi;
+#endif
+inline constexpr auto kState = Reg::r15;
+inline constexpr auto kMemory = Reg::r14;
+/// guest registers live here within a block; rax, rcx and rdx are scratch
+inline constexpr std::array kGuestRegisters{Reg::rbx,
+                                            Reg::rbp,
+                                            Reg::rsi,
+                                            Reg::rdi,
+                                            Reg::r8,
+                                            Reg::r9,
+                                            Reg::r10,
+                                            Reg::r11,
+                                            Reg::r12,
+                                            Reg::r13};
+/// callee-saved in either the System V or the Windows x64 convention
+inline constexpr std::array kPreserved{Reg::rbx,
+                                       Reg::rbp,
+                                       Reg::rsi,
+                                       Reg::rdi,
+                                       Reg::r12,
+                                       Reg::r13,
+                                       Reg::r14,
+                                       Reg::r15};
+inline constexpr auto kSink = ThreadedCode::sink_register;
+
+constexpr auto StateOffset(const uint8_t guest) noexcept {
+  return static_cast<int32_t>(offsetof(JitContext, x) + guest * sizeof(uint32_t));
+}
+/// largest physical offset an access of @p width may start at; mirrors
+/// MemoryAccess::is_in_range(), up to the last byte
+constexpr auto AccessLimit(const Width width) noexcept {
+  return static_cast<uint32_t>(isa::physical_memory_size -
+                               static_cast<uint32_t>(width));
+}
+class BlockEmitter {
+public:
+  /// @return the native code, or nullopt if the block is not worth it
+  auto emit(const ir::Block &) -> std::optional<std::vector<uint8_t>>;
+
+private:
+  struct Exit {
+    Assembler::Label label;
+    uint32_t pc;
+    uint32_t retired;
+  };
+  auto allocate(std::span<const ir::Operation>) -> void;
+  auto read(uint8_t guest, Reg scratch) -> Reg;
+  auto write(uint8_t guest, Reg value) -> void;
+  auto side_exit(uint32_t pc, uint32_t retired) -> Assembler::Label;
+  /// eax = physical offset of rs1 + imm; leaves the block if out of range
+  auto address(const Record &, Width, Assembler::Label exit) -> void;
+  auto binary(const Record &, Alu) -> void;
+  auto binary_imm(const Record &, Alu) -> void;
+  auto shift(const Record &, Shift) -> void;
+  auto shift_imm(const Record &, Shift) -> void;
+  auto compare(const Record &, Cond) -> void;
+  auto compare_imm(const Record &, Cond) -> void;
+  auto multiply(const Record &) -> void;
+  auto multiply_high(const Record &, bool signed_lhs, bool signed_rhs) -> void;
+  auto divide(const Record &, bool is_signed, bool remainder) -> void;
+  auto load(const Record &, Width, bool sign, Assembler::Label exit) -> void;
+  auto store(const Record &, Width, Assembler::Label exit) -> void;
+
+private:
+  Assembler as_;
+  std::array<std::optional<Reg>, ThreadedCode::register_count> host_{};
+  std::bitset<ThreadedCode::register_count> dirty_;
+  std::vector<Exit> exits_;
+};
+auto BlockEmitter::allocate(const std::span<const ir::Operation> operations)
+    -> void {
+  std::array<size_t, ThreadedCode::register_count> uses{};
+  auto use = [&](const uint8_t guest) {
+    if (guest != 0 && guest != kSink)
+      ++uses[guest];
+  };
+  for (const auto &[record, pc, index, next] : operations) {
+    const auto operands = ir::operands_of(record.op);
+    if (operands.rs1)
+      use(record.rs1);
+    if (operands.rs2)
+      use(record.rs2);
+    if (operands.rd) {
+      use(record.rd);
+      if (record.rd != kSink)
+        dirty_.set(record.rd);
+    }
+  }
+  std::array<uint8_t, ThreadedCode::register_count> order{};
+  for (auto i = 0u; i < order.size(); ++i)
+    order[i] = static_cast<uint8_t>(i);
+  std::ranges::stable_sort(
+      order, [&](const auto lhs, const auto rhs) { return uses[lhs] > uses[rhs]; });
+  for (auto i = 0u; i < kGuestRegisters.size() && uses[order[i]]; ++i)
+    host_[order[i]] = kGuestRegisters[i];
+}
+auto BlockEmitter::read(const uint8_t guest, const Reg scratch) -> Reg {
+  if (guest == 0) {
+    as_.zero(scratch);
+    return scratch;
+  }
+  if (host_[guest])
+    return *host_[guest];
+  as_.mov(scratch, at(kState, StateOffset(guest)));
+  return scratch;
+}
+auto BlockEmitter::write(const uint8_t guest, const Reg value) -> void {
+  if (guest == kSink)
+    return;
+  if (host_[guest])
+    as_.mov(*host_[guest], value);
+  else
+    as_.mov(at(kState, StateOffset(guest)), value);
+}
+auto BlockEmitter::side_exit(const uint32_t pc, const uint32_t retired)
+    -> Assembler::Label {
+  const auto label = as_.label();
+  exits_.emplace_back(label, pc, retired);
+  return label;
+}
+auto BlockEmitter::address(const Record &record,
+                           const Width width,
+                           const Assembler::Label exit) -> void {
+  as_.mov(Reg::rax, read(record.rs1, Reg::rax));
+  as_.alu(Alu::kAdd, Reg::rax, record.imm - isa::physical_memory_begin);
+  as_.alu(Alu::kCmp, Reg::rax, AccessLimit(width));
+  as_.j(Cond::kA, exit);
+}
+auto BlockEmitter::binary(const Record &record, const Alu op) -> void {
+  const auto lhs = read(record.rs1, Reg::rax);
+  const auto rhs = read(record.rs2, Reg::rcx);
+  as_.mov(Reg::rax, lhs).alu(op, Reg::rax, rhs);
+  write(record.rd, Reg::rax);
+}
+auto BlockEmitter::binary_imm(const Record &record, const Alu op) -> void {
+  as_.mov(Reg::rax, read(record.rs1, Reg::rax)).alu(op, Reg::rax, record.imm);
+  write(record.rd, Reg::rax);
+}
+auto BlockEmitter::shift(const Record &record, const Shift op) -> void {
+  // x86 masks the count to 5 bits as well
+  as_.mov(Reg::rcx, read(record.rs2, Reg::rcx));
+  as_.mov(Reg::rax, read(record.rs1, Reg::rax)).shift(op, Reg::rax);
+  write(record.rd, Reg::rax);
+}
+auto BlockEmitter::shift_imm(const Record &record, const Shift op) -> void {
+  as_.mov(Reg::rax, read(record.rs1, Reg::rax))
+      .shift(op, Reg::rax, static_cast<uint8_t>(record.imm));
+  write(record.rd, Reg::rax);
+}
+auto BlockEmitter::compare(const Record &record, const Cond cond) -> void {
+  const auto lhs = read(record.rs1, Reg::rax);
+  const auto rhs = read(record.rs2, Reg::rcx);
+  as_.alu(Alu::kCmp, lhs, rhs).set(cond, Reg::rax);
+  write(record.rd, Reg::rax);
+}
+auto BlockEmitter::compare_imm(const Record &record, const Cond cond) -> void {
+  as_.alu(Alu::kCmp, read(record.rs1, Reg::rax), record.imm)
+      .set(cond, Reg::rax);
+  write(record.rd, Reg::rax);
+}
+auto BlockEmitter::multiply(const Record &record) -> void {
+  const auto lhs = read(record.rs1, Reg::rax);
+  const auto rhs = read(record.rs2, Reg::rcx);
+  as_.mov(Reg::rax, lhs).imul(Reg::rax, rhs);
+  write(record.rd, Reg::rax);
+}
+auto BlockEmitter::multiply_high(const Record &record,
+                                 const bool signed_lhs,
+                                 const bool signed_rhs) -> void {
+  const auto lhs = read(record.rs1, Reg::rax);
+  const auto rhs = read(record.rs2, Reg::rcx);
+  // a 32-bit mov zero-extends into the full register
+  if (signed_lhs)
+    as_.movsxd(Reg::rax, lhs);
+  else
+    as_.mov(Reg::rax, lhs);
+  if (signed_rhs)
+    as_.movsxd(Reg::rcx, rhs);
+  else
+    as_.mov(Reg::rcx, rhs);
+  as_.imul64(Reg::rax, Reg::rcx).shift64(Shift::kShr, Reg::rax, 32);
+  write(record.rd, Reg::rax);
+}
+auto BlockEmitter::divide(const Record &record,
+                          const bool is_signed,
+                          const bool remainder) -> void {
+  // no trap on division by zero or overflow, as the spec says
+  as_.mov(Reg::rcx, read(record.rs2, Reg::rcx));
+  as_.mov(Reg::rax, read(record.rs1, Reg::rax));
+  const auto by_zero = as_.label();
+  const auto overflow = as_.label();
+  const auto divide = as_.label();
+  const auto done = as_.label();
+  as_.test(Reg::rcx, Reg::rcx).j(Cond::kE, by_zero);
+  if (is_signed) {
+    as_.alu(Alu::kCmp, Reg::rcx, ~0u).j(Cond::kNE, divide);
+    as_.alu(Alu::kCmp, Reg::rax, 0x80000000u).j(Cond::kE, overflow);
+    as_.bind(divide).cdq().idiv(Reg::rcx).jmp(done);
+    // dividend / -1 overflows: quotient is the dividend, remainder 0
+    as_.bind(overflow);
+    if (remainder)
+      as_.zero(Reg::rdx);
+    as_.jmp(done);
+  } else {
+    as_.bind(divide).bind(overflow);
+    as_.zero(Reg::rdx).div(Reg::rcx).jmp(done);
+  }
+  // quotient is all ones, remainder the dividend
+  as_.bind(by_zero);
+  if (remainder)
+    as_.mov(Reg::rdx, Reg::rax);
+  else
+    as_.mov(Reg::rax, ~0u);
+  as_.bind(done);
+  write(record.rd, remainder ? Reg::rdx : Reg::rax);
+}
+auto BlockEmitter::load(const Record &record,
+                        const Width width,
+                        const bool sign,
+                        const Assembler::Label exit) -> void {
+  address(record, width, exit);
+  as_.load(width, sign, Reg::rax, at(kMemory, Reg::rax));
+  write(record.rd, Reg::rax);
+}
+auto BlockEmitter::store(const Record &record,
+                         const Width width,
+                         const Assembler::Label exit) -> void {
+  as_.mov(Reg::rcx, read(record.rs2, Reg::rcx));
+  address(record, width, exit);
+  // a store overlapping anything translated goes through MainMemory instead
+  as_.mov(Reg::rdx, Reg::rax)
+      .alu(Alu::kSub,
+           Reg::rdx,
+           at(kState, static_cast<int32_t>(offsetof(JitContext, guard_begin))))
+      .alu(Alu::kCmp,
+           Reg::rdx,
+           at(kState, static_cast<int32_t>(offsetof(JitContext, guard_size))))
+      .j(Cond::kB, exit);
+  as_.store(width, at(kMemory, Reg::rax), Reg::rcx);
+  const auto writes =
+      at(kState, static_cast<int32_t>(offsetof(JitContext, writes)));
+  as_.mov(Reg::rdx, writes).alu(Alu::kAdd, Reg::rdx, 1u).mov(writes, Reg::rdx);
+}
+auto BlockEmitter::emit(const ir::Block &block)
+    -> std::optional<std::vector<uint8_t>> {
+  const auto &operations = block.operations;
+  // the block has to retire something before leaving
+  if (!operations.empty() && operations.front().index == 0 &&
+      (operations.front().record.op == Op::kFallback ||
+       operations.front().record.op == Op::kTranslate))
+    return std::nullopt;
+
+  allocate(operations);
+  const auto epilogue = as_.label();
+  for (const auto reg : kPreserved)
+    as_.push(reg);
+  as_.mov64(kState, kArgument);
+  as_.mov64(kMemory,
+            at(kState, static_cast<int32_t>(offsetof(JitContext, memory))));
+  for (auto guest = 0u; guest < host_.size(); ++guest)
+    if (host_[guest])
+      as_.mov(*host_[guest],
+              at(kState, StateOffset(static_cast<uint8_t>(guest))));
+
+  const auto pc_slot =
+      at(kState, static_cast<int32_t>(offsetof(JitContext, pc)));
+  const auto retired_slot =
+      at(kState, static_cast<int32_t>(offsetof(JitContext, retired)));
+  // the next pc lands in edx
+  auto leave = [&](const uint32_t retired) {
+    as_.mov(pc_slot, Reg::rdx).mov(retired_slot, retired).jmp(epilogue);
+  };
+  auto branch = [&](const Record &record, const uint32_t pc, const Cond cond) {
+    as_.alu(Alu::kCmp, read(record.rs1, Reg::rax), read(record.rs2, Reg::rcx));
+    as_.mov(Reg::rdx, pc + isa::instruction_size_bytes)
+        .mov(Reg::rax, pc + record.imm)
+        .cmov(cond, Reg::rdx, Reg::rax);
+  };
+
+  // `ended` by a control transfer, or `exited` in front of an instruction
+  // left to the interpreter
+  auto ended = false;
+  auto exited = false;
+  for (const auto &[record, pc, retired, next] : operations) {
+    switch (record.op) {
+    case Op::kTranslate:
+    case Op::kFallback:
+#define LUCE_FUSED_CASE(_name_) case Op::k##_name_:
+    // only the threaded engine fuses; these are never lowered
+    LUCE_THREADED_FUSED_OP_LIST(LUCE_FUSED_CASE)
+#undef LUCE_FUSED_CASE
+      as_.jmp(side_exit(pc, retired));
+      exited = true;
+      break;
+    case Op::kAdd:   binary(record, Alu::kAdd); break;
+    case Op::kSub:   binary(record, Alu::kSub); break;
+    case Op::kXor:   binary(record, Alu::kXor); break;
+    case Op::kOr:    binary(record, Alu::kOr); break;
+    case Op::kAnd:   binary(record, Alu::kAnd); break;
+    case Op::kSll:   shift(record, Shift::kShl); break;
+    case Op::kSrl:   shift(record, Shift::kShr); break;
+    case Op::kSra:   shift(record, Shift::kSar); break;
+    case Op::kSlt:   compare(record, Cond::kL); break;
+    case Op::kSltu:  compare(record, Cond::kB); break;
+    case Op::kAddi:  binary_imm(record, Alu::kAdd); break;
+    case Op::kXori:  binary_imm(record, Alu::kXor); break;
+    case Op::kOri:   binary_imm(record, Alu::kOr); break;
+    case Op::kAndi:  binary_imm(record, Alu::kAnd); break;
+    case Op::kSlli:  shift_imm(record, Shift::kShl); break;
+    case Op::kSrli:  shift_imm(record, Shift::kShr); break;
+    case Op::kSrai:  shift_imm(record, Shift::kSar); break;
+    case Op::kSlti:  compare_imm(record, Cond::kL); break;
+    case Op::kSltiu: compare_imm(record, Cond::kB); break;
+    case Op::kLb:    load(record, Width::kByte, true, side_exit(pc, retired)); break;
+    case Op::kLh:    load(record, Width::kHalf, true, side_exit(pc, retired)); break;
+    case Op::kLw:    load(record, Width::kWord, false, side_exit(pc, retired)); break;
+    case Op::kLbu:   load(record, Width::kByte, false, side_exit(pc, retired)); break;
+    case Op::kLhu:   load(record, Width::kHalf, false, side_exit(pc, retired)); break;
+    case Op::kSb:    store(record, Width::kByte, side_exit(pc, retired)); break;
+    case Op::kSh:    store(record, Width::kHalf, side_exit(pc, retired)); break;
+    case Op::kSw:    store(record, Width::kWord, side_exit(pc, retired)); break;
+    case Op::kBeq:   branch(record, pc, Cond::kE); ended = true; break;
+    case Op::kBne:   branch(record, pc, Cond::kNE); ended = true; break;
+    case Op::kBlt:   branch(record, pc, Cond::kL); ended = true; break;
+    case Op::kBge:   branch(record, pc, Cond::kGE); ended = true; break;
+    case Op::kBltu:  branch(record, pc, Cond::kB); ended = true; break;
+    case Op::kBgeu:  branch(record, pc, Cond::kAE); ended = true; break;
+    case Op::kJal:
+      as_.mov(Reg::rax, pc + isa::instruction_size_bytes);
+      write(record.rd, Reg::rax);
+      as_.mov(Reg::rdx, pc + record.imm);
+      ended = true;
+      break;
+    case Op::kJalr:
+      // rd may alias rs1
+      as_.mov(Reg::rdx, read(record.rs1, Reg::rdx))
+          .alu(Alu::kAdd, Reg::rdx, record.imm)
+          .alu(Alu::kAnd, Reg::rdx, ~1u);
+      as_.mov(Reg::rax, pc + isa::instruction_size_bytes);
+      write(record.rd, Reg::rax);
+      ended = true;
+      break;
+    case Op::kLui:
+      as_.mov(Reg::rax, record.imm);
+      write(record.rd, Reg::rax);
+      break;
+    case Op::kAuipc:
+      as_.mov(Reg::rax, pc + record.imm);
+      write(record.rd, Reg::rax);
+      break;
+#if LUCE_EXTENSION_M
+    case Op::kMul:   multiply(record); break;
+    case Op::kMulh:  multiply_high(record, true, true); break;
+    case Op::kMulsu: multiply_high(record, true, false); break;
+    case Op::kMulu:  multiply_high(record, false, false); break;
+    case Op::kDiv:   divide(record, true, false); break;
+    case Op::kDivu:  divide(record, false, false); break;
+    case Op::kRem:   divide(record, true, true); break;
+    case Op::kRemu:  divide(record, false, true); break;
+#endif
+    }
+    if (exited)
+      break;
+    if (ended && retired + 1 < block.size) {
+      // inside a trace: anywhere but the recorded way leaves it, edx holding
+      // the pc
+      const auto stay = as_.label();
+      as_.alu(Alu::kCmp, Reg::rdx, next).j(Cond::kE, stay);
+      leave(retired + 1);
+      as_.bind(stay);
+      ended = false;
+    }
+  }
+  if (!exited) {
+    if (!ended)
+      as_.mov(Reg::rdx, block.end);
+    leave(block.size);
+  }
+
+  for (const auto &exit : exits_) {
+    as_.bind(exit.label);
+    as_.mov(pc_slot, exit.pc).mov(retired_slot, exit.retired);
+    as_.jmp(epilogue);
+  }
+  as_.bind(epilogue);
+  for (auto guest = 0u; guest < host_.size(); ++guest)
+    if (host_[guest] && dirty_.test(guest))
+      as_.mov(at(kState, StateOffset(static_cast<uint8_t>(guest))),
+              *host_[guest]);
+  for (const auto reg : kPreserved | std::views::reverse)
+    as_.pop(reg);
+  as_.ret();
+
+  if (!as_.finalize())
+    return std::nullopt;
+  return as_.code();
+}
+} // namespace
+
+JitCompiler::JitCompiler() {
+  if constexpr (LUCE_HAS_JIT) {
+    code_ = AllocateCode(code_capacity);
+    if (!code_)
+      spdlog::warn("Failed to reserve executable memory; the jit is disabled.");
+  }
+}
+JitCompiler::~JitCompiler() {
+  if (code_)
+    FreeCode(code_, code_capacity);
+}
+auto JitCompiler::reset() noexcept -> JitCompiler & {
+  used_ = 0;
+  ++generation_;
+  statistics_ = {};
+  optimizer_.reset();
+  return *this;
+}
+auto JitCompiler::release(const BasicBlock &block) noexcept -> JitCompiler & {
+  // template code is dropped all at once, when its region fills up
+  if (block.optimized && block.native)
+    optimizer_.release(block.native);
+  return *this;
+}
+auto JitCompiler::install(const std::span<const uint8_t> code) -> const void * {
+  if (code.size() > code_capacity)
+    return nullptr;
+  if (used_ + code.size() > code_capacity) {
+    // drop everything rather than track which blocks are still alive
+    used_ = 0;
+    ++generation_;
+    ++statistics_.flushes;
+  }
+  // only the pages the code lands on; the rest stays as it is
+  static const auto page_size = HostPageSize();
+  const auto first = used_ & ~(page_size - 1);
+  const auto pages = code_ + first;
+  const auto size = used_ + code.size() - first;
+  if (!ProtectCode(pages, size, true))
+    return nullptr;
+  const auto native = code_ + used_;
+  std::memcpy(native, code.data(), code.size());
+  // keep the entries 16-byte aligned
+  used_ = (used_ + code.size() + 15) & ~size_t{15};
+  if (!ProtectCode(pages, size, false))
+    return nullptr;
+  return native;
+}
+auto JitCompiler::compile(const BasicBlock &block) -> const void * {
+  const void *native = nullptr;
+  size_t bytes = 0;
+  if (code_) {
+    auto code = BlockEmitter{}.emit(block.ir);
+    native = code ? install(*code) : nullptr;
+    bytes = code ? code->size() : 0;
+  } else {
+    // no template tier on this host; go straight to the optimizer
+    native = optimizer_.compile(block.ir, block.start);
+  }
+  if (!native) {
+    ++statistics_.failures;
+    return nullptr;
+  }
+  ++statistics_.compilations;
+  dbg(trace,
+      "Compiled block [{:#010x}, {:#010x}) into {} bytes",
+      block.start,
+      block.end,
+      bytes);
+  return native;
+}
+auto JitCompiler::optimize(BasicBlock &block) -> void {
+  // tried once; on failure the template code keeps running
+  block.optimized = true;
+  if (const auto native = optimizer_.compile(block.ir, block.start)) {
+    block.native = native;
+    dbg(trace,
+        "Optimized block [{:#010x}, {:#010x})",
+        block.start,
+        block.end);
+  }
+}
+auto JitCompiler::run(CentralProcessingUnit &cpu,
+                      const size_t budget,
+                      const size_t threshold) -> size_t {
+  if (!code_ && !OrcCompiler::available)
+    return 0;
+
+  auto &ctx = cpu.task_->context();
+  auto &gpr = *ctx.general_purpose_registers();
+  JitContext state{};
+  for (auto i = 1ull; i < isa::general_purpose_register_count; ++i)
+    state.x[i] = gpr[i];
+  state.pc = ctx.program_counter.num();
+  auto &memory = cpu.monitor()->memory();
+  state.memory = memory.host_base();
+  if (cpu.atomic_address_ || memory.tracking_dirty()) {
+    // every store goes through MainMemory, which breaks the reservation and
+    // marks the page
+    state.guard_begin = 0;
+    state.guard_size = ~uint32_t{0};
+  } else {
+    // everything any cache may hold a translation of
+    const auto &text = cpu.task_->text_segment();
+    const auto [lowest, highest] = cpu.bcache_.extent();
+    const auto begin = (std::min)(lowest, text.start);
+    const auto end = (std::max)(highest, text.end);
+    // a word store up to 3 bytes below overlaps as well
+    state.guard_begin = static_cast<uint32_t>(
+        cpu.mmu_.virtual_to_physical(begin) - isa::physical_memory_begin - 3);
+    state.guard_size = static_cast<uint32_t>(end - begin + 3);
+  }
+
+  size_t retired = 0;
+  // chained like the block engine, without translating: the guard above only
+  // covers what is translated already
+  for (auto block = cpu.bcache_.lookup(state.pc); block && retired < budget;
+       block = cpu.successor(*block, state.pc)) {
+    if (const auto trace = cpu.bcache_.trace_of(*block))
+      block = trace;
+    if (block->generation != generation_) {
+      if (block->executions < threshold)
+        break;
+      // what the optimizer made of it before is recompiled as well
+      release(*block);
+      block->native = compile(*block);
+      block->generation = generation_;
+      block->optimized = !code_;
+    } else if (OrcCompiler::available && !block->optimized && block->native &&
+               block->executions >= threshold * optimizer_factor) {
+      optimize(*block);
+    }
+    if (!block->native || block->size() > budget - retired)
+      break;
+
+    ++block->executions;
+    ++statistics_.native_runs;
+    reinterpret_cast<native_t>(const_cast<void *>(block->native))(&state);
+    retired += state.retired;
+    if (state.retired < block->size()) {
+      // stopped in front of an instruction the interpreter redoes, or, in a
+      // trace, past a branch that went elsewhere than recorded; state.pc is
+      // where to go on either way
+      ++statistics_.side_exits;
+      break;
+    }
+  }
+
+  for (auto i = 1ull; i < isa::general_purpose_register_count; ++i)
+    gpr.write_at(i) = state.x[i];
+  ctx.program_counter.num() = state.pc;
+  memory.count_writes(state.writes);
+  return retired;
+}
+} // namespace accat::luce
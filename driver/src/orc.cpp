@@ -0,0 +1,508 @@
+#include "deps.hh"
+
+#include "luce/cpu/orc.hpp"
+#include "luce/cpu/jit.hpp"
+
+#if LUCE_HAS_LLVM
+#  include <array>
+#  include <bitset>
+#  include <cstddef>
+#  include <mutex>
+#  include <unordered_map>
+#  include <llvm/Config/llvm-config.h>
+#  include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
+#  include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#  include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#  include <llvm/IR/IRBuilder.h>
+#  include <llvm/IR/LLVMContext.h>
+#  include <llvm/IR/MDBuilder.h>
+#  include <llvm/IR/Module.h>
+#  include <llvm/IR/Verifier.h>
+#  include <llvm/Passes/PassBuilder.h>
+#  include <llvm/Support/TargetSelect.h>
+#  include <llvm/Target/TargetMachine.h>
+#endif
+
+namespace accat::luce {
+#if LUCE_HAS_LLVM
+namespace {
+using Op = ThreadedCode::Op;
+using Record = ThreadedCode::Record;
+inline constexpr auto kSink = ThreadedCode::sink_register;
+
+// the IR below spells JitContext as
+// { [32 x i32], i32, i32, i32, i32, ptr, i32 }
+static_assert(offsetof(JitContext, pc) == 32 * sizeof(uint32_t));
+static_assert(offsetof(JitContext, memory) == 36 * sizeof(uint32_t));
+static_assert(offsetof(JitContext, writes) ==
+              36 * sizeof(uint32_t) + sizeof(std::byte *));
+
+/// lifts the ir of one block, or trace, into a function `void(JitContext *)`.
+class BlockLifter {
+public:
+  BlockLifter(llvm::LLVMContext &context, llvm::Module &module)
+      : context_(context), module_(module), builder_(context) {}
+
+public:
+  /// @return false if the block is not worth it
+  auto lift(const ir::Block &, llvm::StringRef) -> bool;
+
+private:
+  enum Field : unsigned {
+    kX = 0,
+    kPc,
+    kRetired,
+    kGuardBegin,
+    kGuardSize,
+    kMemory,
+    kWrites
+  };
+  auto field(Field, unsigned index = 0) -> llvm::Value *;
+  auto read(uint8_t guest) -> llvm::Value *;
+  auto write(uint8_t guest, llvm::Value *) -> void;
+  auto constant(uint32_t value) -> llvm::ConstantInt * {
+    return builder_.getInt32(value);
+  }
+  /// store the registers written so far, @p pc and @p retired, and return
+  auto leave(llvm::Value *pc, uint32_t retired) -> void;
+  /// leave the block for @p pc if @p condition holds
+  auto side_exit(llvm::Value *condition, llvm::Value *pc, uint32_t retired)
+      -> void;
+  /// host pointer for rs1 + imm; leaves the block if out of range, or if a
+  /// store may hit translated code
+  auto address(const Record &, uint32_t width, bool store, uint32_t pc,
+               uint32_t retired) -> llvm::Value *;
+  auto load(const Record &, uint32_t width, bool sign, uint32_t pc,
+            uint32_t retired) -> void;
+  auto store(const Record &, uint32_t width, uint32_t pc, uint32_t retired)
+      -> void;
+  auto multiply_high(const Record &, bool signed_lhs, bool signed_rhs)
+      -> llvm::Value *;
+  auto divide(const Record &, bool is_signed, bool remainder) -> llvm::Value *;
+
+private:
+  llvm::LLVMContext &context_;
+  llvm::Module &module_;
+  llvm::IRBuilder<> builder_;
+  llvm::StructType *state_type_ = nullptr;
+  llvm::Function *function_ = nullptr;
+  llvm::Value *state_ = nullptr;
+  llvm::Value *memory_ = nullptr;
+  llvm::Value *guard_begin_ = nullptr;
+  llvm::Value *guard_size_ = nullptr;
+  /// current value of each guest register, loaded on first use
+  std::array<llvm::Value *, ThreadedCode::register_count> values_{};
+  std::bitset<ThreadedCode::register_count> dirty_;
+};
+auto BlockLifter::field(const Field field, const unsigned index)
+    -> llvm::Value * {
+  if (field != kX)
+    return builder_.CreateStructGEP(state_type_, state_, field);
+  return builder_.CreateInBoundsGEP(
+      state_type_,
+      state_,
+      {builder_.getInt32(0), builder_.getInt32(kX), builder_.getInt32(index)});
+}
+auto BlockLifter::read(const uint8_t guest) -> llvm::Value * {
+  if (guest == 0)
+    return constant(0);
+  if (!values_[guest])
+    values_[guest] = builder_.CreateLoad(builder_.getInt32Ty(), field(kX, guest));
+  return values_[guest];
+}
+auto BlockLifter::write(const uint8_t guest, llvm::Value *value) -> void {
+  if (guest == 0 || guest == kSink)
+    return;
+  values_[guest] = value;
+  dirty_.set(guest);
+}
+auto BlockLifter::leave(llvm::Value *pc, const uint32_t retired) -> void {
+  for (auto guest = 1u; guest < values_.size(); ++guest)
+    if (dirty_.test(guest))
+      builder_.CreateStore(values_[guest], field(kX, guest));
+  builder_.CreateStore(pc, field(kPc));
+  builder_.CreateStore(constant(retired), field(kRetired));
+  builder_.CreateRetVoid();
+}
+auto BlockLifter::side_exit(llvm::Value *condition,
+                            llvm::Value *pc,
+                            const uint32_t retired) -> void {
+  const auto exit = llvm::BasicBlock::Create(context_, "exit", function_);
+  const auto next = llvm::BasicBlock::Create(context_, "next", function_);
+  // faults, guarded stores and traces gone astray are rare; keep them out of
+  // the hot path
+  builder_.CreateCondBr(
+      condition,
+      exit,
+      next,
+      llvm::MDBuilder(context_).createBranchWeights(1, 1 << 20));
+  builder_.SetInsertPoint(exit);
+  leave(pc, retired);
+  builder_.SetInsertPoint(next);
+}
+auto BlockLifter::address(const Record &record,
+                          const uint32_t width,
+                          const bool store,
+                          const uint32_t pc,
+                          const uint32_t retired) -> llvm::Value * {
+  // mirrors MemoryAccess::is_in_range(), as the template jit does
+  const auto offset = builder_.CreateSub(
+      builder_.CreateAdd(read(record.rs1), constant(record.imm)),
+      constant(isa::physical_memory_begin));
+  auto fault = builder_.CreateICmpUGT(
+      offset, constant(isa::physical_memory_size - width));
+  if (store)
+    fault = builder_.CreateOr(
+        fault,
+        builder_.CreateICmpULT(builder_.CreateSub(offset, guard_begin_),
+                               guard_size_));
+  side_exit(fault, constant(pc), retired);
+  return builder_.CreateInBoundsGEP(
+      builder_.getInt8Ty(),
+      memory_,
+      builder_.CreateZExt(offset, builder_.getInt64Ty()));
+}
+auto BlockLifter::load(const Record &record,
+                       const uint32_t width,
+                       const bool sign,
+                       const uint32_t pc,
+                       const uint32_t retired) -> void {
+  const auto type = builder_.getIntNTy(width * 8);
+  const auto pointer = builder_.CreateBitCast(
+      address(record, width, false, pc, retired),
+      llvm::PointerType::getUnqual(type));
+  const auto value =
+      builder_.CreateAlignedLoad(type, pointer, llvm::MaybeAlign(1));
+  write(record.rd,
+        sign ? builder_.CreateSExt(value, builder_.getInt32Ty())
+             : builder_.CreateZExt(value, builder_.getInt32Ty()));
+}
+auto BlockLifter::store(const Record &record,
+                        const uint32_t width,
+                        const uint32_t pc,
+                        const uint32_t retired) -> void {
+  const auto type = builder_.getIntNTy(width * 8);
+  const auto pointer = builder_.CreateBitCast(
+      address(record, width, true, pc, retired),
+      llvm::PointerType::getUnqual(type));
+  builder_.CreateAlignedStore(
+      builder_.CreateTrunc(read(record.rs2), type), pointer, llvm::MaybeAlign(1));
+  const auto writes = field(kWrites);
+  builder_.CreateStore(
+      builder_.CreateAdd(builder_.CreateLoad(builder_.getInt32Ty(), writes),
+                         constant(1)),
+      writes);
+}
+auto BlockLifter::multiply_high(const Record &record,
+                                const bool signed_lhs,
+                                const bool signed_rhs) -> llvm::Value * {
+  const auto i64 = builder_.getInt64Ty();
+  const auto lhs = signed_lhs ? builder_.CreateSExt(read(record.rs1), i64)
+                              : builder_.CreateZExt(read(record.rs1), i64);
+  const auto rhs = signed_rhs ? builder_.CreateSExt(read(record.rs2), i64)
+                              : builder_.CreateZExt(read(record.rs2), i64);
+  return builder_.CreateTrunc(
+      builder_.CreateLShr(builder_.CreateMul(lhs, rhs), 32),
+      builder_.getInt32Ty());
+}
+auto BlockLifter::divide(const Record &record,
+                         const bool is_signed,
+                         const bool remainder) -> llvm::Value * {
+  const auto lhs = read(record.rs1);
+  const auto rhs = read(record.rs2);
+  const auto by_zero = builder_.CreateICmpEQ(rhs, constant(0));
+  auto special = by_zero;
+  if (is_signed)
+    special = builder_.CreateOr(
+        special,
+        builder_.CreateAnd(
+            builder_.CreateICmpEQ(lhs, constant(0x8000'0000)),
+            builder_.CreateICmpEQ(rhs, constant(~0u))));
+  // division by zero and overflow are defined by the spec but not by LLVM;
+  // dividing by 1 instead yields the overflow results(lhs, 0) for free
+  const auto divisor = builder_.CreateSelect(special, constant(1), rhs);
+  const auto result =
+      remainder ? (is_signed ? builder_.CreateSRem(lhs, divisor)
+                             : builder_.CreateURem(lhs, divisor))
+                : (is_signed ? builder_.CreateSDiv(lhs, divisor)
+                             : builder_.CreateUDiv(lhs, divisor));
+  return builder_.CreateSelect(
+      by_zero, remainder ? lhs : constant(~0u), result);
+}
+auto BlockLifter::lift(const ir::Block &block, const llvm::StringRef name)
+    -> bool {
+  const auto &operations = block.operations;
+  // the block has to retire something before leaving
+  if (!operations.empty() && operations.front().index == 0 &&
+      (operations.front().record.op == Op::kFallback ||
+       operations.front().record.op == Op::kTranslate))
+    return false;
+
+  const auto i32 = builder_.getInt32Ty();
+  state_type_ = llvm::StructType::create(
+      context_,
+      {llvm::ArrayType::get(i32, isa::general_purpose_register_count),
+       i32,
+       i32,
+       i32,
+       i32,
+       llvm::PointerType::getUnqual(builder_.getInt8Ty()),
+       i32},
+      "JitContext");
+  function_ = llvm::Function::Create(
+      llvm::FunctionType::get(builder_.getVoidTy(),
+                              {llvm::PointerType::getUnqual(state_type_)},
+                              false),
+      llvm::Function::ExternalLinkage,
+      name,
+      module_);
+  function_->addFnAttr(llvm::Attribute::NoUnwind);
+  state_ = function_->getArg(0);
+  builder_.SetInsertPoint(llvm::BasicBlock::Create(context_, "entry", function_));
+  memory_ = builder_.CreateLoad(
+      llvm::PointerType::getUnqual(builder_.getInt8Ty()), field(kMemory));
+  guard_begin_ = builder_.CreateLoad(i32, field(kGuardBegin));
+  guard_size_ = builder_.CreateLoad(i32, field(kGuardSize));
+
+  // where a control transfer goes
+  llvm::Value *target = nullptr;
+  for (const auto &[record, pc, retired, next] : operations) {
+    const auto fallthrough = pc + isa::instruction_size_bytes;
+    auto rs1 = [&] { return read(record.rs1); };
+    auto rs2 = [&] { return read(record.rs2); };
+    auto imm = [&] { return constant(record.imm); };
+    auto shamt = [&] { return builder_.CreateAnd(rs2(), constant(31)); };
+    auto flag = [&](llvm::Value *condition) {
+      return builder_.CreateZExt(condition, i32);
+    };
+    auto branch = [&](llvm::Value *condition) {
+      return builder_.CreateSelect(
+          condition, constant(pc + record.imm), constant(fallthrough));
+    };
+    switch (record.op) {
+    case Op::kTranslate:
+    case Op::kFallback:
+#define LUCE_FUSED_CASE(_name_) case Op::k##_name_:
+    // only the threaded engine fuses; these are never lowered
+    LUCE_THREADED_FUSED_OP_LIST(LUCE_FUSED_CASE)
+#undef LUCE_FUSED_CASE
+      leave(constant(pc), retired);
+      return true;
+    case Op::kAdd:   write(record.rd, builder_.CreateAdd(rs1(), rs2())); break;
+    case Op::kSub:   write(record.rd, builder_.CreateSub(rs1(), rs2())); break;
+    case Op::kXor:   write(record.rd, builder_.CreateXor(rs1(), rs2())); break;
+    case Op::kOr:    write(record.rd, builder_.CreateOr(rs1(), rs2())); break;
+    case Op::kAnd:   write(record.rd, builder_.CreateAnd(rs1(), rs2())); break;
+    case Op::kSll:   write(record.rd, builder_.CreateShl(rs1(), shamt())); break;
+    case Op::kSrl:   write(record.rd, builder_.CreateLShr(rs1(), shamt())); break;
+    case Op::kSra:   write(record.rd, builder_.CreateAShr(rs1(), shamt())); break;
+    case Op::kSlt:   write(record.rd, flag(builder_.CreateICmpSLT(rs1(), rs2()))); break;
+    case Op::kSltu:  write(record.rd, flag(builder_.CreateICmpULT(rs1(), rs2()))); break;
+    case Op::kAddi:  write(record.rd, builder_.CreateAdd(rs1(), imm())); break;
+    case Op::kXori:  write(record.rd, builder_.CreateXor(rs1(), imm())); break;
+    case Op::kOri:   write(record.rd, builder_.CreateOr(rs1(), imm())); break;
+    case Op::kAndi:  write(record.rd, builder_.CreateAnd(rs1(), imm())); break;
+    case Op::kSlli:  write(record.rd, builder_.CreateShl(rs1(), imm())); break;
+    case Op::kSrli:  write(record.rd, builder_.CreateLShr(rs1(), imm())); break;
+    case Op::kSrai:  write(record.rd, builder_.CreateAShr(rs1(), imm())); break;
+    case Op::kSlti:  write(record.rd, flag(builder_.CreateICmpSLT(rs1(), imm()))); break;
+    case Op::kSltiu: write(record.rd, flag(builder_.CreateICmpULT(rs1(), imm()))); break;
+    case Op::kLb:    load(record, 1, true, pc, retired); break;
+    case Op::kLh:    load(record, 2, true, pc, retired); break;
+    case Op::kLw:    load(record, 4, false, pc, retired); break;
+    case Op::kLbu:   load(record, 1, false, pc, retired); break;
+    case Op::kLhu:   load(record, 2, false, pc, retired); break;
+    case Op::kSb:    store(record, 1, pc, retired); break;
+    case Op::kSh:    store(record, 2, pc, retired); break;
+    case Op::kSw:    store(record, 4, pc, retired); break;
+    case Op::kBeq:   target = branch(builder_.CreateICmpEQ(rs1(), rs2())); break;
+    case Op::kBne:   target = branch(builder_.CreateICmpNE(rs1(), rs2())); break;
+    case Op::kBlt:   target = branch(builder_.CreateICmpSLT(rs1(), rs2())); break;
+    case Op::kBge:   target = branch(builder_.CreateICmpSGE(rs1(), rs2())); break;
+    case Op::kBltu:  target = branch(builder_.CreateICmpULT(rs1(), rs2())); break;
+    case Op::kBgeu:  target = branch(builder_.CreateICmpUGE(rs1(), rs2())); break;
+    case Op::kJal:
+      write(record.rd, constant(fallthrough));
+      target = constant(pc + record.imm);
+      break;
+    case Op::kJalr:
+      // rd may alias rs1
+      target =
+          builder_.CreateAnd(builder_.CreateAdd(rs1(), imm()), constant(~1u));
+      write(record.rd, constant(fallthrough));
+      break;
+    case Op::kLui:   write(record.rd, imm()); break;
+    case Op::kAuipc: write(record.rd, constant(pc + record.imm)); break;
+#if LUCE_EXTENSION_M
+    case Op::kMul:   write(record.rd, builder_.CreateMul(rs1(), rs2())); break;
+    case Op::kMulh:  write(record.rd, multiply_high(record, true, true)); break;
+    case Op::kMulsu: write(record.rd, multiply_high(record, true, false)); break;
+    case Op::kMulu:  write(record.rd, multiply_high(record, false, false)); break;
+    case Op::kDiv:   write(record.rd, divide(record, true, false)); break;
+    case Op::kDivu:  write(record.rd, divide(record, false, false)); break;
+    case Op::kRem:   write(record.rd, divide(record, true, true)); break;
+    case Op::kRemu:  write(record.rd, divide(record, false, true)); break;
+#endif
+    }
+    if (target && retired + 1 < block.size) {
+      // inside a trace: anywhere but the recorded way leaves it
+      side_exit(builder_.CreateICmpNE(target, constant(next)),
+                target,
+                retired + 1);
+      target = nullptr;
+    }
+  }
+  leave(target ? target : constant(block.end), block.size);
+  return true;
+}
+auto Optimize(llvm::Module &module, llvm::TargetMachine *machine) -> void {
+  llvm::LoopAnalysisManager loops;
+  llvm::FunctionAnalysisManager functions;
+  llvm::CGSCCAnalysisManager cgsccs;
+  llvm::ModuleAnalysisManager modules;
+  llvm::PassBuilder builder(machine);
+  builder.registerModuleAnalyses(modules);
+  builder.registerCGSCCAnalyses(cgsccs);
+  builder.registerFunctionAnalyses(functions);
+  builder.registerLoopAnalyses(loops);
+  builder.crossRegisterProxies(loops, functions, cgsccs, modules);
+  builder.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::O2)
+      .run(module, modules);
+}
+/// @brief free the code @p tracker holds; nothing may run it any more.
+auto Remove(llvm::orc::ResourceTracker &tracker) noexcept -> void {
+  if (auto error = tracker.remove())
+    spdlog::warn("ORC failed to free a block: {}",
+                 llvm::toString(std::move(error)));
+}
+} // namespace
+
+struct OrcCompiler::Session {
+  std::unique_ptr<llvm::orc::LLJIT> jit;
+  /// what the optimizer tunes for; the same host LLJIT compiles for
+  std::unique_ptr<llvm::TargetMachine> machine;
+  /// keeps symbol names unique across recompilations of a block
+  uint64_t serial = 0;
+  /// entry -> what holds the code of a block alive; declared after `jit`,
+  /// so torn down before it
+  std::unordered_map<const void *, llvm::orc::ResourceTrackerSP> trackers;
+
+  static auto create() -> std::unique_ptr<Session> {
+    static std::once_flag initialized;
+    std::call_once(initialized, [] {
+      llvm::InitializeNativeTarget();
+      llvm::InitializeNativeTargetAsmPrinter();
+    });
+    auto host = llvm::orc::JITTargetMachineBuilder::detectHost();
+    if (!host) {
+      spdlog::warn("LLVM does not know this host: {}",
+                   llvm::toString(host.takeError()));
+      return nullptr;
+    }
+    auto machine = host->createTargetMachine();
+    if (!machine) {
+      spdlog::warn("LLVM cannot target this host: {}",
+                   llvm::toString(machine.takeError()));
+      return nullptr;
+    }
+    auto jit = llvm::orc::LLJITBuilder()
+                   .setJITTargetMachineBuilder(std::move(*host))
+                   .create();
+    if (!jit) {
+      spdlog::warn("Failed to set up ORC: {}",
+                   llvm::toString(jit.takeError()));
+      return nullptr;
+    }
+    auto session = std::make_unique<Session>();
+    session->jit = std::move(*jit);
+    session->machine = std::move(*machine);
+    return session;
+  }
+};
+
+OrcCompiler::OrcCompiler() = default;
+OrcCompiler::~OrcCompiler() = default;
+auto OrcCompiler::reset() noexcept -> OrcCompiler & {
+  session_.reset();
+  statistics_ = {};
+  return *this;
+}
+auto OrcCompiler::compile(const ir::Block &block, const vaddr_t start)
+    -> const void * {
+  if (!session_ && !(session_ = Session::create())) {
+    ++statistics_.failures;
+    return nullptr;
+  }
+  const auto name =
+      fmt::format("luce_block_{:08x}_{}", start, session_->serial++);
+  auto context = std::make_unique<llvm::LLVMContext>();
+  auto module = std::make_unique<llvm::Module>(name, *context);
+  module->setDataLayout(session_->jit->getDataLayout());
+
+  auto failed = [this] {
+    ++statistics_.failures;
+    return nullptr;
+  };
+  if (!BlockLifter{*context, *module}.lift(block, name))
+    return failed();
+  if (llvm::verifyModule(*module, &llvm::errs())) {
+    spdlog::error("Lifted block at {:#010x} does not verify", start);
+    return failed();
+  }
+  Optimize(*module, session_->machine.get());
+
+  // a module of its own per block, so that dropping the block frees it
+  auto tracker = session_->jit->getMainJITDylib().createResourceTracker();
+  if (auto error = session_->jit->addIRModule(
+          tracker,
+          llvm::orc::ThreadSafeModule(std::move(module), std::move(context)))) {
+    spdlog::warn("ORC rejected block at {:#010x}: {}",
+                 start,
+                 llvm::toString(std::move(error)));
+    return failed();
+  }
+  auto symbol = session_->jit->lookup(name);
+  if (!symbol) {
+    spdlog::warn("ORC failed to compile block at {:#010x}: {}",
+                 start,
+                 llvm::toString(symbol.takeError()));
+    Remove(*tracker);
+    return failed();
+  }
+  ++statistics_.compilations;
+#  if LLVM_VERSION_MAJOR >= 15
+  const auto entry = symbol->toPtr<const void *>();
+#  else
+  const auto entry = reinterpret_cast<const void *>(symbol->getAddress());
+#  endif
+  session_->trackers.insert_or_assign(entry, std::move(tracker));
+  return entry;
+}
+auto OrcCompiler::release(const void *entry) noexcept -> OrcCompiler & {
+  if (!session_)
+    return *this;
+  const auto it = session_->trackers.find(entry);
+  if (it == session_->trackers.end())
+    return *this;
+  Remove(*it->second);
+  session_->trackers.erase(it);
+  ++statistics_.released;
+  return *this;
+}
+#else
+struct OrcCompiler::Session {};
+
+OrcCompiler::OrcCompiler() = default;
+OrcCompiler::~OrcCompiler() = default;
+auto OrcCompiler::reset() noexcept -> OrcCompiler & {
+  statistics_ = {};
+  return *this;
+}
+auto OrcCompiler::compile(const ir::Block &, vaddr_t) -> const void * {
+  return nullptr;
+}
+auto OrcCompiler::release(const void *) noexcept -> OrcCompiler & {
+  return *this;
+}
+#endif
+} // namespace accat::luce
@@ -0,0 +1,144 @@
+#include "deps.hh"
+
+#include "luce/cpu/persist.hpp"
+#include <fstream>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include "luce/Support/isa/config.hpp"
+#include "luce/cpu/aot.hpp"
+
+namespace accat::luce {
+namespace {
+constexpr auto kMagic = std::string_view{"lucetc1"};
+/// every descriptor id, in order; reordering or adding one changes it
+#define LUCE_PERSIST_ID_NAME(_name_) #_name_ " "
+constexpr auto kIds = std::string_view{
+    LUCE_ISA_BASE_LIST(LUCE_PERSIST_ID_NAME)
+        LUCE_ISA_MULTIPLY_LIST(LUCE_PERSIST_ID_NAME)
+            LUCE_ISA_ATOMIC_LIST(LUCE_PERSIST_ID_NAME)};
+#undef LUCE_PERSIST_ID_NAME
+/// of the decoders and the layouts a file was written with; the file of
+/// another build is ignored, its descriptors may not mean the same. taken of
+/// what the layouts are, so a rebuild that changes none of them keeps the
+/// files of the last one.
+const auto kBuild = [] {
+  const auto build = fmt::format("{}v{} M{} A{} {} {}",
+                                 kIds,
+                                 isa::descriptor_version,
+                                 LUCE_EXTENSION_M,
+                                 LUCE_EXTENSION_A,
+                                 sizeof(isa::Descriptor),
+                                 sizeof(PersistentCache::Profile));
+  return aot::checksum(std::as_bytes(std::span{build}));
+}();
+struct Header {
+  char magic[8];
+  uint64_t build;
+  /// the key, and what it was taken of
+  uint64_t text;
+  uint64_t text_size;
+  uint64_t descriptors;
+  uint64_t profiles;
+};
+static_assert(std::is_trivially_copyable_v<PersistentCache::Profile>,
+              "profiles are written as they are");
+} // namespace
+auto PersistentCache::load(const std::filesystem::path &directory,
+                           const std::span<const std::byte> text)
+    -> PersistentCache & {
+  directory_ = directory;
+  key_ = 0;
+  text_size_ = text.size();
+  descriptors_.clear();
+  executions_.clear();
+  statistics_ = {};
+  if (directory_.empty() || text.empty())
+    return *this;
+  key_ = aot::checksum(text, kBuild);
+
+  std::ifstream in(file(), std::ios::binary);
+  if (!in) {
+    ++statistics_.misses;
+    return *this;
+  }
+  const auto reject = [&](const std::string_view why) -> PersistentCache & {
+    spdlog::warn("Ignoring the persistent cache {}: {}", file().string(), why);
+    ++statistics_.rejected;
+    descriptors_.clear();
+    executions_.clear();
+    return *this;
+  };
+  Header header{};
+  if (!in.read(reinterpret_cast<char *>(&header), sizeof(header)))
+    return reject("truncated");
+  if (std::string_view{header.magic, kMagic.size()} != kMagic)
+    return reject("not a cache");
+  if (header.build != kBuild)
+    return reject("written by another build");
+  if (header.text != key_ || header.text_size != text.size() ||
+      header.descriptors != text.size() / isa::instruction_alignment)
+    return reject("written for another image");
+
+  descriptors_.resize(header.descriptors);
+  if (!in.read(reinterpret_cast<char *>(descriptors_.data()),
+               descriptors_.size() * sizeof(isa::Descriptor)))
+    return reject("truncated");
+  Profile profile{};
+  executions_.reserve(header.profiles);
+  for (uint64_t i = 0; i < header.profiles; ++i) {
+    if (!in.read(reinterpret_cast<char *>(&profile), sizeof(profile)))
+      return reject("truncated");
+    executions_.insert_or_assign(profile.start, profile.executions);
+  }
+  ++statistics_.hits;
+  spdlog::info("Persistent cache {}: {} descriptors, {} profiles",
+               file().string(),
+               descriptors_.size(),
+               executions_.size());
+  return *this;
+}
+auto PersistentCache::save(const std::span<const isa::Descriptor> descriptors,
+                           const std::span<const Profile> profiles)
+    -> auxilia::Status {
+  if (key_ == 0)
+    return {};
+  // nothing the next run would not have to decode again anyway
+  if (descriptors.size() != text_size_ / isa::instruction_alignment)
+    return {};
+
+  Header header{.build = kBuild,
+                .text = key_,
+                .text_size = text_size_,
+                .descriptors = descriptors.size(),
+                .profiles = profiles.size()};
+  kMagic.copy(header.magic, kMagic.size());
+  // written aside and renamed over, so a reader never sees half a file
+  auto temporary = file();
+  temporary += ".tmp";
+  {
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(descriptors.data()),
+              descriptors.size_bytes());
+    out.write(reinterpret_cast<const char *>(profiles.data()),
+              profiles.size_bytes());
+    if (!out.flush())
+      return auxilia::UnavailableError("Cannot write the persistent cache {}",
+                                       temporary.string());
+  }
+  std::error_code ec;
+  std::filesystem::rename(temporary, file(), ec);
+  if (ec) {
+    const auto message = ec.message();
+    std::filesystem::remove(temporary, ec);
+    return auxilia::UnavailableError(
+        "Cannot replace the persistent cache {}: {}", file().string(), message);
+  }
+  ++statistics_.saves;
+  return {};
+}
+auto PersistentCache::file() const -> std::filesystem::path {
+  return directory_ / fmt::format("{:016x}.luce-cache", key_);
+}
+} // namespace accat::luce
@@ -0,0 +1,154 @@
+#include "deps.hh"
+
+#include "luce/cpu/predecode.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <vector>
+#include <accat/auxilia/details/macros.hpp>
+#include "luce/Support/isa/IDisassembler.hpp"
+
+namespace accat::luce {
+namespace {
+enum class ChunkState : uint8_t {
+  kPending = 0,
+  kReady,
+  /// stored over; decoded on demand from now on
+  kDropped,
+};
+} // namespace
+struct Predecoder::Work {
+  vaddr_t base = 0;
+  /// the text segment as it was at `reset`
+  std::vector<uint32_t> words;
+  std::vector<isa::Descriptor> descriptors;
+  /// per chunk; the worker publishes a chunk only if nothing dropped it
+  std::unique_ptr<std::atomic<ChunkState>[]> states;
+  size_t chunks = 0;
+  std::shared_ptr<const isa::IDisassembler> disassembler;
+  /// every chunk decoded, dropped or not; published after the last one
+  std::atomic<bool> done = false;
+
+  auto run(const std::stop_token &stop) -> void {
+    for (size_t chunk = 0; chunk < chunks && !stop.stop_requested();
+         ++chunk) {
+      const auto first = chunk * chunk_size;
+      const auto count = (std::min)(chunk_size, words.size() - first);
+      disassembler->describe_n(std::span{words}.subspan(first, count),
+                               std::span{descriptors}.subspan(first, count));
+      auto expected = ChunkState::kPending;
+      states[chunk].compare_exchange_strong(expected,
+                                            ChunkState::kReady,
+                                            std::memory_order_release,
+                                            std::memory_order_relaxed);
+    }
+    if (!stop.stop_requested())
+      done.store(true, std::memory_order_release);
+  }
+};
+Predecoder::Predecoder() = default;
+Predecoder::Predecoder(Predecoder &&) noexcept = default;
+Predecoder &Predecoder::operator=(Predecoder &&) noexcept = default;
+Predecoder::~Predecoder() = default;
+auto Predecoder::reset(const std::span<const std::byte> text,
+                       const vaddr_t base,
+                       std::shared_ptr<const isa::IDisassembler> disassembler)
+    -> Predecoder & {
+  // joins the worker still on the previous task
+  worker_ = {};
+  statistics_ = {};
+  auto work = std::make_unique<Work>();
+  work->base = base;
+  work->words.resize(text.size() / isa::instruction_alignment);
+  std::memcpy(work->words.data(),
+              text.data(),
+              work->words.size() * sizeof(uint32_t));
+  work->descriptors.resize(work->words.size());
+  work->chunks = (work->words.size() + chunk_size - 1) / chunk_size;
+  work->states =
+      std::make_unique<std::atomic<ChunkState>[]>(work->chunks);
+  work->disassembler = std::move(disassembler);
+  work_ = std::move(work);
+  if (work_->chunks != 0)
+    worker_ = std::jthread{
+        [work = work_.get()](const std::stop_token &stop) { work->run(stop); }};
+  return *this;
+}
+auto Predecoder::restore(const std::span<const std::byte> text,
+                         const vaddr_t base,
+                         const std::span<const isa::Descriptor> descriptors)
+    -> Predecoder & {
+  precondition(descriptors.size() == text.size() / isa::instruction_alignment,
+               "The descriptors do not cover the text")
+  worker_ = {};
+  statistics_ = {};
+  auto work = std::make_unique<Work>();
+  work->base = base;
+  work->words.resize(descriptors.size());
+  std::memcpy(work->words.data(),
+              text.data(),
+              work->words.size() * sizeof(uint32_t));
+  work->descriptors.assign(descriptors.begin(), descriptors.end());
+  work->chunks = (work->words.size() + chunk_size - 1) / chunk_size;
+  work->states =
+      std::make_unique<std::atomic<ChunkState>[]>(work->chunks);
+  for (size_t chunk = 0; chunk < work->chunks; ++chunk)
+    work->states[chunk].store(ChunkState::kReady, std::memory_order_relaxed);
+  work->done.store(true, std::memory_order_relaxed);
+  work_ = std::move(work);
+  return *this;
+}
+auto Predecoder::snapshot() const noexcept
+    -> std::span<const isa::Descriptor> {
+  if (!work_ || !work_->done.load(std::memory_order_acquire))
+    return {};
+  return work_->descriptors;
+}
+auto Predecoder::invalidate(const vaddr_t addr, const size_t size) noexcept
+    -> Predecoder & {
+  if (!work_ || size == 0)
+    return *this;
+  const auto begin = static_cast<size_t>(work_->base);
+  const auto end = begin + work_->words.size() * isa::instruction_alignment;
+  const auto first = static_cast<size_t>(addr);
+  const auto last = first + size;
+  if (last <= begin || first >= end)
+    return *this;
+
+  const auto bytes = chunk_size * isa::instruction_alignment;
+  for (auto chunk = ((std::max)(first, begin) - begin) / bytes;
+       chunk <= ((std::min)(last, end) - 1 - begin) / bytes;
+       ++chunk)
+    if (work_->states[chunk].exchange(ChunkState::kDropped,
+                                      std::memory_order_relaxed) !=
+        ChunkState::kDropped)
+      ++statistics_.drops;
+  return *this;
+}
+auto Predecoder::lookup(const vaddr_t pc) noexcept -> const isa::Descriptor * {
+  if (!work_)
+    return nullptr;
+  const auto offset = static_cast<size_t>(pc - work_->base);
+  const auto index = offset / isa::instruction_alignment;
+  if (offset % isa::instruction_alignment != 0 ||
+      index >= work_->words.size())
+    return nullptr;
+  if (work_->states[index / chunk_size].load(std::memory_order_acquire) !=
+      ChunkState::kReady) {
+    ++statistics_.misses;
+    return nullptr;
+  }
+  ++statistics_.hits;
+  return &work_->descriptors[index];
+}
+auto Predecoder::progress() const noexcept -> std::pair<size_t, size_t> {
+  if (!work_)
+    return {0, 0};
+  size_t ready = 0;
+  for (size_t chunk = 0; chunk < work_->chunks; ++chunk)
+    if (work_->states[chunk].load(std::memory_order_relaxed) ==
+        ChunkState::kReady)
+      ++ready;
+  return {ready, work_->chunks};
+}
+} // namespace accat::luce
@@ -0,0 +1,449 @@
+#include "deps.hh"
+
+#include "luce/cpu/threaded.hpp"
+#include <array>
+#include "luce/cpu/cpu.hpp"
+#include "luce/Monitor.hpp"
+#include "luce/Support/isa/Descriptor.hpp"
+#include "luce/Support/isa/IDisassembler.hpp"
+
+// direct threading needs labels as values; MSVC falls back to a switch.
+#if defined(__GNUC__) || defined(__clang__)
+#  define LUCE_THREADED_COMPUTED_GOTO 1
+#else
+#  define LUCE_THREADED_COMPUTED_GOTO 0
+#endif
+
+namespace accat::luce {
+using Op = ThreadedCode::Op;
+using Record = ThreadedCode::Record;
+namespace {
+/// instructions the threaded engine executes itself; everything else(system,
+/// atomic) is left to the reference path
+constexpr auto OperationOf(const isa::Descriptor::Id id) noexcept -> Op {
+  switch (id) {
+#define LUCE_LOWER(_name_)                                                     \
+  case isa::Descriptor::Id::k##_name_:                                         \
+    return Op::k##_name_;
+    LUCE_THREADED_GUEST_OP_LIST(LUCE_LOWER)
+#undef LUCE_LOWER
+  default:
+    return Op::kFallback;
+  }
+}
+constexpr auto IsFused(const Op op) noexcept {
+  switch (op) {
+#define LUCE_FUSED(_name_)                                                     \
+  case Op::k##_name_:
+    LUCE_THREADED_FUSED_OP_LIST(LUCE_FUSED)
+#undef LUCE_FUSED
+    return true;
+  default:
+    return false;
+  }
+}
+/// whether @p op may start a fused pair
+constexpr auto LeadsPair(const Op op) noexcept {
+  switch (op) {
+  case Op::kLui:
+  case Op::kAuipc:
+  case Op::kAddi:
+  case Op::kSlt:
+  case Op::kSltu:
+    return true;
+  default:
+    return false;
+  }
+}
+/// @return the fused operation for @p first followed by @p second, or the op
+/// of @p first if they do not form an idiom.
+constexpr auto FusionOf(const Record &first, const Record &second) noexcept
+    -> Op {
+  // the second instruction must consume what the first produced
+  if (first.rd == ThreadedCode::sink_register || second.rs1 != first.rd)
+    return first.op;
+  // `beqz`/`bnez`
+  const auto zero = second.rs2 == 0;
+  switch (first.op) {
+  case Op::kLui:
+    return second.op == Op::kAddi ? Op::kLuiAddi : first.op;
+  case Op::kAuipc:
+    if (second.op == Op::kAddi)
+      return Op::kAuipcAddi;
+    if (second.op == Op::kJalr)
+      return Op::kAuipcJalr;
+    return first.op;
+  case Op::kAddi:
+    if (zero && second.op == Op::kBeq)
+      return Op::kAddiBeq;
+    if (zero && second.op == Op::kBne)
+      return Op::kAddiBne;
+    return first.op;
+  case Op::kSlt:
+    if (zero && second.op == Op::kBeq)
+      return Op::kSltBeq;
+    if (zero && second.op == Op::kBne)
+      return Op::kSltBne;
+    return first.op;
+  case Op::kSltu:
+    if (zero && second.op == Op::kBeq)
+      return Op::kSltuBeq;
+    if (zero && second.op == Op::kBne)
+      return Op::kSltuBne;
+    return first.op;
+  default:
+    return first.op;
+  }
+}
+} // namespace
+
+auto ThreadedCode::reset(const vaddr_t begin, const vaddr_t end)
+    -> ThreadedCode & {
+  base_ = begin;
+  size_ = end > begin ? (end - begin) / isa::instruction_alignment : 0;
+  records_.assign(size_ + 1, Record{});
+  records_.back().op = Op::kFallback;
+  statistics_ = {};
+  return *this;
+}
+auto ThreadedCode::invalidate(const vaddr_t addr, const size_t size) noexcept
+    -> ThreadedCode & {
+  const auto begin = static_cast<size_t>(base_);
+  const auto end = begin + size_ * isa::instruction_alignment;
+  const auto first = static_cast<size_t>(addr);
+  const auto last = first + size;
+  if (size == 0 || last <= begin || first >= end)
+    return *this;
+
+  // same rounding as the instruction cache
+  auto from = ((std::max)(first, begin) - begin) / isa::instruction_alignment;
+  // the pair ending here read the operands about to go stale
+  if (from > 0 && IsFused(records_[from - 1].op))
+    --from;
+  const auto to =
+      ((std::min)(last, end) - begin + isa::instruction_alignment - 1) /
+      isa::instruction_alignment;
+  for (auto i = from; i < to; ++i)
+    if (records_[i].op != Op::kTranslate) {
+      records_[i].op = Op::kTranslate;
+      ++statistics_.invalidations;
+    }
+  return *this;
+}
+auto ThreadedCode::translate(CentralProcessingUnit &cpu, const vaddr_t pc)
+    -> Record {
+  ++statistics_.translations;
+  if (cpu.hle_.covers(pc))
+    return {.op = Op::kFallback};
+  if (const auto descriptor = cpu.predecoder_.lookup(pc))
+    return lower(*descriptor);
+  auto maybe_bytes = cpu.fetch(pc);
+  if (!maybe_bytes)
+    return {.op = Op::kFallback};
+  const auto num =
+      isa::Word{maybe_bytes->first<isa::instruction_size_bytes>()}.num();
+  return lower(cpu.monitor()->disassembler()->describe(num));
+}
+auto ThreadedCode::fuse(CentralProcessingUnit &cpu,
+                        const vaddr_t pc,
+                        Record *rec) -> void {
+  if (!LeadsPair(rec->op))
+    return;
+  // the sentinel at worst, which never fuses
+  auto &next = rec[1];
+  if (next.op == Op::kTranslate)
+    next = translate(cpu, pc + isa::instruction_size_bytes);
+  if (const auto op = FusionOf(*rec, next); op != rec->op) {
+    rec->op = op;
+    ++statistics_.fusions;
+  }
+}
+auto ThreadedCode::lower(const isa::Descriptor &descriptor) noexcept
+    -> Record {
+  return {.op = OperationOf(descriptor.id),
+          .rd = descriptor.rd ? descriptor.rd : sink_register,
+          .rs1 = descriptor.rs1,
+          .rs2 = descriptor.rs2,
+          .imm = descriptor.imm};
+}
+// NOLINTBEGIN(cppcoreguidelines-macro-usage)
+auto ThreadedCode::run(CentralProcessingUnit &cpu, const size_t budget)
+    -> size_t {
+  if (records_.empty())
+    return 0;
+
+  auto &ctx = cpu.task_->context();
+  auto &gpr = *ctx.general_purpose_registers();
+
+  // the guest registers live in a plain array while running; the sink absorbs
+  // writes to x0
+  std::array<uint32_t, register_count + 1> x{};
+  for (auto i = 1ull; i < register_count; ++i)
+    x[i] = gpr[i];
+
+  auto pc = ctx.program_counter.num();
+  size_t retired = 0;
+  Record *rec = nullptr;
+  if (!covers(pc))
+    goto leave;
+  rec = record_at(pc);
+
+#define RD x[rec->rd]
+#define RS1 x[rec->rs1]
+#define RS2 x[rec->rs2]
+#define IMM rec->imm
+// operands of the second instruction of a fused pair
+#define NRD x[rec[1].rd]
+#define NRS1 x[rec[1].rs1]
+#define NIMM rec[1].imm
+#define ADDR (RS1 + IMM)
+#define SIGNED(_value_) static_cast<int32_t>(_value_)
+#if LUCE_THREADED_COMPUTED_GOTO
+#  pragma GCC diagnostic push
+#  pragma GCC diagnostic ignored "-Wpedantic"
+#  define LUCE_LABEL_ADDRESS(_name_) &&L_##_name_,
+  static void *const kLabels[] = {
+      LUCE_THREADED_OP_LIST(LUCE_LABEL_ADDRESS)};
+#  undef LUCE_LABEL_ADDRESS
+#  define HANDLER(_name_) L_##_name_:
+#  define DISPATCH()                                                           \
+    do {                                                                       \
+      if (retired == budget)                                                   \
+        goto leave;                                                            \
+      goto *kLabels[static_cast<size_t>(rec->op)];                             \
+    } while (false)
+  DISPATCH();
+#else
+// the labels let a fused handler fall back to its first instruction
+#  ifdef _MSC_VER
+#    pragma warning(push)
+#    pragma warning(disable : 4102) // unreferenced label
+#  endif
+#  define HANDLER(_name_)                                                      \
+    case Op::k##_name_:                                                        \
+    L_##_name_:
+#  define DISPATCH() continue
+  for (;;) {
+    if (retired == budget)
+      goto leave;
+    switch (rec->op) {
+#endif
+// plain braces rather than `do {} while (false)`: `continue` must reach the
+// dispatch loop in the switch fallback
+#define NEXT()                                                                 \
+  {                                                                            \
+    ++retired;                                                                 \
+    pc += isa::instruction_size_bytes;                                         \
+    ++rec;                                                                     \
+    DISPATCH();                                                                \
+  }
+#define JUMP(_target_)                                                         \
+  {                                                                            \
+    ++retired;                                                                 \
+    pc = (_target_);                                                           \
+    if (!covers(pc))                                                           \
+      goto leave;                                                              \
+    rec = record_at(pc);                                                       \
+    DISPATCH();                                                                \
+  }
+// a fused pair retires both of its instructions
+#define NEXT_PAIR()                                                            \
+  {                                                                            \
+    retired += 2;                                                              \
+    pc += 2 * isa::instruction_size_bytes;                                     \
+    rec += 2;                                                                  \
+    DISPATCH();                                                                \
+  }
+#define JUMP_PAIR(_target_)                                                    \
+  {                                                                            \
+    retired += 2;                                                              \
+    pc = (_target_);                                                           \
+    if (!covers(pc))                                                           \
+      goto leave;                                                              \
+    rec = record_at(pc);                                                       \
+    DISPATCH();                                                                \
+  }
+// with room for one instruction only, run the first one alone and stop in
+// front of the second exactly as if they were never fused
+#define PAIR_OR(_first_)                                                       \
+  if (budget - retired < 2)                                                    \
+    goto L_##_first_;
+#define LOAD(_type_)                                                           \
+  {                                                                            \
+    _type_ value;                                                              \
+    if (!cpu.load(ADDR, value)) [[unlikely]]                                   \
+      goto leave;                                                              \
+    RD = static_cast<uint32_t>(value);                                         \
+    NEXT();                                                                    \
+  }
+#define STORE(_type_)                                                          \
+  {                                                                            \
+    if (!cpu.store(ADDR, static_cast<_type_>(RS2))) [[unlikely]]               \
+      goto leave;                                                              \
+    NEXT();                                                                    \
+  }
+
+  // clang-format off
+  HANDLER(Translate) {
+    *rec = translate(cpu, pc);
+    fuse(cpu, pc, rec);
+    DISPATCH();
+  }
+  HANDLER(Fallback) {
+    ++statistics_.fallbacks;
+    goto leave;
+  }
+  HANDLER(Add)   { RD = RS1 + RS2; NEXT(); }
+  HANDLER(Sub)   { RD = RS1 - RS2; NEXT(); }
+  HANDLER(Xor)   { RD = RS1 ^ RS2; NEXT(); }
+  HANDLER(Or)    { RD = RS1 | RS2; NEXT(); }
+  HANDLER(And)   { RD = RS1 & RS2; NEXT(); }
+  HANDLER(Sll)   { RD = RS1 << (RS2 & 0x1F); NEXT(); }
+  HANDLER(Srl)   { RD = RS1 >> (RS2 & 0x1F); NEXT(); }
+  HANDLER(Sra)   { RD = SIGNED(RS1) >> (RS2 & 0x1F); NEXT(); }
+  HANDLER(Slt)   { RD = SIGNED(RS1) < SIGNED(RS2); NEXT(); }
+  HANDLER(Sltu)  { RD = RS1 < RS2; NEXT(); }
+  HANDLER(Addi)  { RD = RS1 + IMM; NEXT(); }
+  HANDLER(Xori)  { RD = RS1 ^ IMM; NEXT(); }
+  HANDLER(Ori)   { RD = RS1 | IMM; NEXT(); }
+  HANDLER(Andi)  { RD = RS1 & IMM; NEXT(); }
+  HANDLER(Slli)  { RD = RS1 << IMM; NEXT(); }
+  HANDLER(Srli)  { RD = RS1 >> IMM; NEXT(); }
+  HANDLER(Srai)  { RD = SIGNED(RS1) >> IMM; NEXT(); }
+  HANDLER(Slti)  { RD = SIGNED(RS1) < SIGNED(IMM); NEXT(); }
+  HANDLER(Sltiu) { RD = RS1 < IMM; NEXT(); }
+  HANDLER(Lb)    { LOAD(int8_t); }
+  HANDLER(Lh)    { LOAD(int16_t); }
+  HANDLER(Lw)    { LOAD(uint32_t); }
+  HANDLER(Lbu)   { LOAD(uint8_t); }
+  HANDLER(Lhu)   { LOAD(uint16_t); }
+  HANDLER(Sb)    { STORE(uint8_t); }
+  HANDLER(Sh)    { STORE(uint16_t); }
+  HANDLER(Sw)    { STORE(uint32_t); }
+  HANDLER(Beq)   { if (RS1 == RS2) JUMP(pc + IMM); NEXT(); }
+  HANDLER(Bne)   { if (RS1 != RS2) JUMP(pc + IMM); NEXT(); }
+  HANDLER(Blt)   { if (SIGNED(RS1) < SIGNED(RS2)) JUMP(pc + IMM); NEXT(); }
+  HANDLER(Bge)   { if (SIGNED(RS1) >= SIGNED(RS2)) JUMP(pc + IMM); NEXT(); }
+  HANDLER(Bltu)  { if (RS1 < RS2) JUMP(pc + IMM); NEXT(); }
+  HANDLER(Bgeu)  { if (RS1 >= RS2) JUMP(pc + IMM); NEXT(); }
+  HANDLER(Jal) {
+    RD = pc + isa::instruction_size_bytes;
+    JUMP(pc + IMM);
+  }
+  HANDLER(Jalr) {
+    // rd may alias rs1
+    const auto target = (RS1 + IMM) & ~1u;
+    RD = pc + isa::instruction_size_bytes;
+    JUMP(target);
+  }
+  HANDLER(Lui)   { RD = IMM; NEXT(); }
+  HANDLER(Auipc) { RD = pc + IMM; NEXT(); }
+#if LUCE_EXTENSION_M
+  HANDLER(Mul)   { RD = RS1 * RS2; NEXT(); }
+  HANDLER(Mulh) {
+    RD = static_cast<uint32_t>((int64_t{SIGNED(RS1)} * SIGNED(RS2)) >> 32);
+    NEXT();
+  }
+  HANDLER(Mulsu) {
+    RD = static_cast<uint32_t>((int64_t{SIGNED(RS1)} * int64_t{RS2}) >> 32);
+    NEXT();
+  }
+  HANDLER(Mulu) {
+    RD = static_cast<uint32_t>((uint64_t{RS1} * RS2) >> 32);
+    NEXT();
+  }
+  HANDLER(Div) {
+    if (RS2 == 0)
+      RD = ~0u;
+    else if (SIGNED(RS1) == INT32_MIN && SIGNED(RS2) == -1)
+      RD = RS1;
+    else
+      RD = SIGNED(RS1) / SIGNED(RS2);
+    NEXT();
+  }
+  HANDLER(Divu) { RD = RS2 ? RS1 / RS2 : ~0u; NEXT(); }
+  HANDLER(Rem) {
+    if (RS2 == 0)
+      RD = RS1;
+    else if (SIGNED(RS1) == INT32_MIN && SIGNED(RS2) == -1)
+      RD = 0;
+    else
+      RD = SIGNED(RS1) % SIGNED(RS2);
+    NEXT();
+  }
+  HANDLER(Remu) { RD = RS2 ? RS1 % RS2 : RS1; NEXT(); }
+#endif
+  // the second instruction of each pair can neither fault nor trap, so state
+  // is exact wherever the pair stops
+  HANDLER(LuiAddi)   { PAIR_OR(Lui) RD = IMM; NRD = NRS1 + NIMM; NEXT_PAIR(); }
+  HANDLER(AuipcAddi) {
+    PAIR_OR(Auipc)
+    RD = pc + IMM;
+    NRD = NRS1 + NIMM;
+    NEXT_PAIR();
+  }
+  HANDLER(AuipcJalr) {
+    PAIR_OR(Auipc)
+    RD = pc + IMM;
+    const auto target = (NRS1 + NIMM) & ~1u;
+    NRD = pc + 2 * isa::instruction_size_bytes;
+    JUMP_PAIR(target);
+  }
+#define COMPARE_AND_BRANCH(_compute_, _taken_)                                 \
+  {                                                                            \
+    RD = (_compute_);                                                          \
+    if (_taken_)                                                               \
+      JUMP_PAIR(pc + isa::instruction_size_bytes + NIMM);                      \
+    NEXT_PAIR();                                                               \
+  }
+  HANDLER(AddiBeq) { PAIR_OR(Addi) COMPARE_AND_BRANCH(RS1 + IMM, NRS1 == 0); }
+  HANDLER(AddiBne) { PAIR_OR(Addi) COMPARE_AND_BRANCH(RS1 + IMM, NRS1 != 0); }
+  HANDLER(SltBeq) {
+    PAIR_OR(Slt)
+    COMPARE_AND_BRANCH(SIGNED(RS1) < SIGNED(RS2), NRS1 == 0);
+  }
+  HANDLER(SltBne) {
+    PAIR_OR(Slt)
+    COMPARE_AND_BRANCH(SIGNED(RS1) < SIGNED(RS2), NRS1 != 0);
+  }
+  HANDLER(SltuBeq) { PAIR_OR(Sltu) COMPARE_AND_BRANCH(RS1 < RS2, NRS1 == 0); }
+  HANDLER(SltuBne) { PAIR_OR(Sltu) COMPARE_AND_BRANCH(RS1 < RS2, NRS1 != 0); }
+#undef COMPARE_AND_BRANCH
+  // clang-format on
+
+#if LUCE_THREADED_COMPUTED_GOTO
+#  pragma GCC diagnostic pop
+#else
+    }
+  }
+#  ifdef _MSC_VER
+#    pragma warning(pop)
+#  endif
+#endif
+#undef STORE
+#undef LOAD
+#undef PAIR_OR
+#undef JUMP_PAIR
+#undef NEXT_PAIR
+#undef JUMP
+#undef NEXT
+#undef DISPATCH
+#undef HANDLER
+#undef SIGNED
+#undef ADDR
+#undef NIMM
+#undef NRS1
+#undef NRD
+#undef IMM
+#undef RS2
+#undef RS1
+#undef RD
+
+leave:
+  for (auto i = 1ull; i < register_count; ++i)
+    gpr.write_at(i) = x[i];
+  ctx.program_counter.num() = pc;
+  return retired;
+}
+// NOLINTEND(cppcoreguidelines-macro-usage)
+} // namespace accat::luce
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <vector>
+
+#include "guest.hpp"
+
+// aot guest -- what luce.aot.test runs translated ahead of time; the image
+// the build translates is written from these very words, so that the two
+// agree on the checksum
+namespace accat::luce::guest {
+/// @brief a counting loop run natively, then one storing over its own first
+/// instruction, which leaves its block by a side exit.
+inline auto aot_program() -> std::vector<uint32_t> {
+  constexpr auto base = isa::virtual_base_address;
+  return program({{
+                      lui(s0, data),      // 0
+                      lui(s1, base),      // 1
+                      addi(t0, zero, 0),  // 2
+                      addi(t2, zero, 10), // 3
+                      addi(a3, a3, 3),    // 4: loop
+                      addi(t0, t0, 1),    // 5
+                      bne(t0, t2, -8),    // 6: -> 4
+                      addi(t0, zero, 0),  // 7
+                      addi(t2, zero, 20), // 8
+                      addi(a1, zero, 1),  // 9: loop, patched
+                      add(a2, a2, a1),    // 10
+                      lw(t1, s1, 80),     // 11: word 20
+                      sw(t1, s1, 36),     // 12: over word 9
+                      addi(t0, t0, 1),    // 13
+                      bne(t0, t2, -20),   // 14: -> 9
+                      sw(a2, s0, 0),      // 15
+                      sw(a3, s0, 4),      // 16
+                  },
+                  finish(),              // 17..19
+                  {addi(a1, zero, 2)}}); // 20
+}
+} // namespace accat::luce::guest
@@ -0,0 +1,18 @@
+#include <cstdlib>
+#include <fstream>
+#include <span>
+
+#include "aot.guest.hpp"
+
+// writes the raw image of `aot_program` for luce-aot to translate; laid out as
+// `guest::run` loads it
+int main(const int argc, const char *const *const argv) {
+  const auto args = std::span{argv, static_cast<size_t>(argc)};
+  if (args.size() != 2)
+    return EXIT_FAILURE;
+  const auto words = accat::luce::guest::aot_program();
+  std::ofstream file{args[1], std::ios::binary | std::ios::trunc};
+  file.write(reinterpret_cast<const char *>(words.data()),
+             static_cast<std::streamsize>(words.size() * sizeof(uint32_t)));
+  return file.flush() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
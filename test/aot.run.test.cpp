@@ -0,0 +1,64 @@
+#include "deps.hh"
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+
+#include "aot.guest.hpp"
+#include "luce/cpu/aot.hpp"
+
+using namespace accat::luce;
+using namespace accat::luce::guest;
+
+// linked against the translation of `aot_program`, see CMakeLists.txt
+
+namespace {
+auto word_at(const Outcome &outcome, const size_t offset) {
+  uint32_t word = 0;
+  std::memcpy(&word, outcome.memory.data() + offset, sizeof(word));
+  return word;
+}
+/// what `AotRuntime::to_string` reports
+struct Counts {
+  unsigned long long blocks = 0;
+  unsigned long long native_runs = 0;
+  unsigned long long side_exits = 0;
+  unsigned long long invalidations = 0;
+};
+auto counts_of(const Outcome &outcome) {
+  Counts counts;
+  const auto at = outcome.statistics.find("aot: ");
+  if (at == std::string::npos)
+    return counts;
+  std::sscanf(outcome.statistics.c_str() + at,
+              "aot: %llu blocks, %llu native runs, %llu side exits, %llu "
+              "invalidations",
+              &counts.blocks,
+              &counts.native_runs,
+              &counts.side_exits,
+              &counts.invalidations);
+  return counts;
+}
+} // namespace
+
+TEST(aot, translated_program_installed) {
+  ASSERT_NE(aot::installed(), nullptr);
+  const auto words = aot_program();
+  EXPECT_EQ(aot::installed()->base, isa::virtual_base_address);
+  EXPECT_EQ(aot::installed()->size, words.size() * sizeof(uint32_t));
+}
+
+TEST(aot, runs_as_step) {
+  const auto outcome = expect_as_step(aot_program(), {.engine = "aot"});
+  EXPECT_EQ(outcome.report.reason, ExitReason::kExited);
+  EXPECT_EQ(word_at(outcome, 0), 1u + 19 * 2);
+  EXPECT_EQ(word_at(outcome, 4), 30u);
+
+  const auto counts = counts_of(outcome);
+  EXPECT_GT(counts.blocks, 0u);
+  // the counting loop, natively every time
+  EXPECT_GE(counts.native_runs, 10u);
+  // the store over word 9 drops the block it runs in, and leaves it
+  EXPECT_GE(counts.side_exits, 1u);
+  EXPECT_GE(counts.invalidations, 1u);
+}
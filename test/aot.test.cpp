@@ -0,0 +1,49 @@
+#include "deps.hh"
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "luce/cpu/aot.hpp"
+
+using namespace accat::luce;
+
+namespace {
+constexpr auto base = isa::virtual_base_address;
+auto text_of(const std::vector<uint32_t> &words) {
+  std::vector<std::byte> bytes(words.size() * sizeof(uint32_t));
+  std::memcpy(bytes.data(), words.data(), bytes.size());
+  return bytes;
+}
+} // namespace
+
+TEST(aot, blocks_start_at_leaders) {
+  // li t0, 3; loop: addi t0, t0, -1; bnez t0, loop; ret
+  const auto text = text_of({0x00300293, 0xfff28293, 0xfe029ee3, 0x00008067});
+  const auto unit = aot::translate(text, base);
+
+  EXPECT_NE(unit.find("block_80000000"), std::string::npos);
+  // the branch target, and what follows the branch
+  EXPECT_NE(unit.find("block_80000004"), std::string::npos);
+  EXPECT_NE(unit.find("block_8000000c"), std::string::npos);
+  EXPECT_EQ(unit.find("block_80000008"), std::string::npos);
+  EXPECT_NE(unit.find(fmt::format("{:#018x}", aot::checksum(text))),
+            std::string::npos);
+}
+
+TEST(aot, system_left_to_interpreter) {
+  // ecall; addi t2, t2, 1
+  const auto text = text_of({0x00000073, 0x00138393});
+  const auto unit = aot::translate(text, base);
+
+  EXPECT_EQ(unit.find("block_80000000"), std::string::npos);
+  EXPECT_NE(unit.find("block_80000004"), std::string::npos);
+}
+
+TEST(aot, checksum_tells_images_apart) {
+  const auto one = text_of({0x00300293});
+  const auto other = text_of({0x00400293});
+  EXPECT_NE(aot::checksum(one), aot::checksum(other));
+  EXPECT_EQ(aot::checksum(one), aot::checksum(text_of({0x00300293})));
+}
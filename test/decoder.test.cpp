@@ -2,8 +2,15 @@
 #include <gtest/gtest.h>
 #include <spdlog/common.h>
 
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
 #include "luce/Support/isa/IDisassembler.hpp"
 #include "luce/Support/isa/riscv32/Disassembler.hpp"
+#include "luce/Support/isa/riscv32/instruction/Atomic.hpp"
+#include "luce/Support/isa/riscv32/instruction/Base.hpp"
 #include "luce/Support/isa/riscv32/instruction/Multiply.hpp"
 
 using namespace accat::auxilia;
@@ -102,6 +109,8 @@ TEST(decode, base) {
 }
 
 TEST(decode, multiply) {
+  if constexpr (!LUCE_EXTENSION_M)
+    GTEST_SKIP() << "built without the M extension";
   auto disassembler = createDisassembler();
   disassembler->initializeDefault().addDecoder(
       std::make_unique<instruction::multiply::Decoder>());
@@ -181,3 +190,218 @@ TEST(decode, unregistered) {
   auto div_inst = disassembler->disassemble(div);
   EXPECT_FALSE(div_inst);
 }
+TEST(decode, store_immediate) {
+  using accat::luce::isa::riscv32::instruction::base::Sw;
+  // sw x5, 0x7f4(x2): imm[11:5] = 0x3f, imm[4:0] = 0x14
+  const uint32_t sw_instr = (0x3f << 25) | (5 << 20) | (2 << 15) | (0x2 << 12) |
+                            (0x14 << 7) | 0x23;
+  EXPECT_EQ(0x7f4u, Sw{sw_instr}.imm());
+
+  // sw x5, -4(x2)
+  const uint32_t sw_negative = (0x7f << 25) | (5 << 20) | (2 << 15) |
+                               (0x2 << 12) | (0x1c << 7) | 0x23;
+  EXPECT_EQ(static_cast<uint32_t>(-4), Sw{sw_negative}.imm());
+}
+TEST(decode, describe) {
+  auto disassembler = createDisassembler();
+  disassembler->initializeDefault();
+  using Id = Descriptor::Id;
+
+  // add x1, x2, x3
+  const uint32_t add_instr =
+      (0x00 << 25) | (3 << 20) | (2 << 15) | (0x0 << 12) | (1 << 7) | 0x33;
+  EXPECT_EQ((Descriptor{.id = Id::kAdd, .rd = 1, .rs1 = 2, .rs2 = 3}),
+            disassembler->describe(add_instr));
+
+  // addi x5, x6, -1
+  const uint32_t addi_instr =
+      (0xfff << 20) | (6 << 15) | (0x0 << 12) | (5 << 7) | 0x13;
+  EXPECT_EQ((Descriptor{.id = Id::kAddi,
+                        .rd = 5,
+                        .rs1 = 6,
+                        .imm = static_cast<uint32_t>(-1)}),
+            disassembler->describe(addi_instr));
+
+  // srai x5, x6, 3: the funct7 bits do not leak into the shift amount
+  const uint32_t srai_instr =
+      (0x20 << 25) | (3 << 20) | (6 << 15) | (0x5 << 12) | (5 << 7) | 0x13;
+  EXPECT_EQ((Descriptor{.id = Id::kSrai, .rd = 5, .rs1 = 6, .imm = 3}),
+            disassembler->describe(srai_instr));
+
+  // lui x7, 0x12345: already shifted
+  const uint32_t lui_instr = (0x12345 << 12) | (7 << 7) | 0x37;
+  EXPECT_EQ((Descriptor{.id = Id::kLui, .rd = 7, .imm = 0x12345000}),
+            disassembler->describe(lui_instr));
+
+  // sw x5, -4(x2)
+  const uint32_t sw_instr = (0x7f << 25) | (5 << 20) | (2 << 15) |
+                            (0x2 << 12) | (0x1c << 7) | 0x23;
+  EXPECT_EQ((Descriptor{.id = Id::kSw,
+                        .rs1 = 2,
+                        .rs2 = 5,
+                        .imm = static_cast<uint32_t>(-4)}),
+            disassembler->describe(sw_instr));
+
+  // div is not registered by default; neither is garbage
+  const uint32_t div_instr =
+      (0x01 << 25) | (2 << 20) | (1 << 15) | (0x4 << 12) | (3 << 7) | 0x33;
+  EXPECT_FALSE(disassembler->describe(div_instr));
+  EXPECT_FALSE(disassembler->describe(0xdeadbeef));
+
+  if constexpr (!LUCE_EXTENSION_M)
+    return;
+  disassembler->addDecoder(
+      std::make_unique<instruction::multiply::Decoder>());
+  EXPECT_EQ((Descriptor{.id = Id::kDiv, .rd = 3, .rs1 = 1, .rs2 = 2}),
+            disassembler->describe(div_instr));
+}
+TEST(decode, table) {
+  auto disassembler = createDisassembler();
+  disassembler->initializeDefault();
+  using Id = Descriptor::Id;
+
+  // ecall and ebreak share every field but imm[4:0]
+  EXPECT_EQ(Id::kEcall, disassembler->describe(0x00000073).id);
+  EXPECT_EQ(Id::kEbreak, disassembler->describe(0x00100073).id);
+  EXPECT_EQ(Id::kWfi, disassembler->describe(0x10500073).id);
+  // rdcycle a0, rdinstreth a0
+  EXPECT_EQ(Id::kCsrrs, disassembler->describe(0xc0002573).id);
+  EXPECT_EQ(Id::kCsrrs, disassembler->describe(0xc8202573).id);
+  EXPECT_FALSE(disassembler->describe(0x00200073));
+  EXPECT_FALSE(disassembler->describe(0x00500073));
+
+  // slli x1, x1, 1 with a non-zero imm[11:5] is no instruction at all
+  const uint32_t slli_instr =
+      (1 << 20) | (1 << 15) | (0x1 << 12) | (1 << 7) | 0x13;
+  EXPECT_EQ(Id::kSlli, disassembler->describe(slli_instr).id);
+  EXPECT_FALSE(disassembler->describe(slli_instr | (0x20 << 25)));
+
+  if constexpr (!LUCE_EXTENSION_A)
+    return;
+  // lr.w x3, (x1): the table knows it, the disassembler does not yet
+  const uint32_t lr_instr =
+      (0x02 << 27) | (1 << 15) | (0x2 << 12) | (3 << 7) | 0x2f;
+  EXPECT_FALSE(disassembler->describe(lr_instr));
+  EXPECT_FALSE(disassembler->disassemble(lr_instr));
+
+  disassembler->addDecoder(std::make_unique<instruction::atomic::Decoder>());
+  EXPECT_EQ((Descriptor{.id = Id::kLr, .rd = 3, .rs1 = 1}),
+            disassembler->describe(lr_instr));
+  auto lr_inst = disassembler->disassemble(lr_instr);
+  ASSERT_TRUE(lr_inst);
+  EXPECT_EQ("lr.w x3, (x1)", lr_inst->to_string(kDefault));
+  // registering atomics leaves multiply out
+  const uint32_t mul_instr =
+      (0x01 << 25) | (2 << 20) | (1 << 15) | (0x0 << 12) | (3 << 7) | 0x33;
+  EXPECT_FALSE(disassembler->describe(mul_instr));
+}
+TEST(decode, shift_amount) {
+  using Id = Descriptor::Id;
+  using riscv32::decode_table;
+  constexpr auto base = riscv32::set_of(riscv32::Extension::kBase);
+  constexpr auto shift = [](const uint32_t funct6,
+                            const uint32_t shamt,
+                            const uint32_t funct3) {
+    return (funct6 << 26) | (shamt << 20) | (1 << 15) | (funct3 << 12) |
+           (1 << 7) | 0x13;
+  };
+
+  EXPECT_EQ((Descriptor{.id = Id::kSrai, .rd = 1, .rs1 = 1, .imm = 31}),
+            decode_table.describe(shift(0x10, 31, 0x5), base));
+  // imm[5] set is no RV32 shift
+  EXPECT_FALSE(decode_table.describe(shift(0x00, 33, 0x1), base));
+  EXPECT_FALSE(decode_table.describe(shift(0x10, 63, 0x5), base));
+}
+namespace {
+/// every encoding of the table with random bits around it, some of them with
+/// one bit flipped, and random words among them
+auto sample_words(const size_t random) {
+  std::mt19937 rng{42};
+  std::vector<uint32_t> words;
+  riscv32::encoding::for_each([&](const riscv32::Encoding &e) {
+    for (auto k = 0; k < 64; ++k) {
+      const auto word = (static_cast<uint32_t>(rng()) & ~e.mask) | e.match;
+      words.push_back(word);
+      words.push_back(word ^ 1u << rng() % 32);
+    }
+  });
+  for (size_t k = 0; k < random; ++k)
+    words.push_back(static_cast<uint32_t>(rng()));
+  std::ranges::shuffle(words, rng);
+  return words;
+}
+} // namespace
+TEST(decode, describe_n) {
+  // the vector kernels against the scalar path, over every extension set and
+  // with a few words left over after the last full batch
+  using namespace riscv32;
+  const auto words = sample_words(4096);
+  for (const auto extensions :
+       {ExtensionSet{0}, set_of(Extension::kBase), compiled_extensions,
+        compiled_extensions & ~set_of(Extension::kBase)}) {
+    for (const auto count : {words.size(), words.size() - 5, size_t{3}}) {
+      const auto input = std::span{words}.first(count);
+      std::vector<Descriptor> expected(count), actual(count);
+      decode_table.describe_n_scalar(input, expected, extensions);
+      decode_table.describe_n(input, actual, extensions);
+      for (size_t i = 0; i < count; ++i)
+        ASSERT_EQ(expected[i], actual[i])
+            << std::hex << "word " << input[i] << ", extensions "
+            << extensions;
+    }
+  }
+}
+TEST(decode, describe_n_throughput) {
+  // not a pass/fail check, only a number to compare; a text segment of valid
+  // instructions, as a loaded image has
+  using namespace riscv32;
+  using clock = std::chrono::steady_clock;
+  std::vector<uint32_t> valid;
+  for (const auto word : sample_words(0))
+    if (decode_table.describe(word, compiled_extensions))
+      valid.push_back(word);
+  std::vector<uint32_t> text(size_t{1} << 20);
+  for (size_t i = 0; i < text.size(); ++i)
+    text[i] = valid[i % valid.size()];
+  std::vector<Descriptor> scalar(text.size()), batch(text.size());
+
+  const auto time = [&](auto &&decode) {
+    const auto begin = clock::now();
+    decode();
+    return std::chrono::duration<double, std::nano>(clock::now() - begin)
+               .count() /
+           static_cast<double>(text.size());
+  };
+  const auto scalar_ns = time([&] {
+    decode_table.describe_n_scalar(text, scalar, compiled_extensions);
+  });
+  const auto batch_ns = time(
+      [&] { decode_table.describe_n(text, batch, compiled_extensions); });
+  EXPECT_EQ(scalar, batch);
+  RecordProperty("scalar_ns_per_word", std::to_string(scalar_ns));
+  RecordProperty("batch_ns_per_word", std::to_string(batch_ns));
+  spdlog::info("describe_n: {:.2f} ns a word one by one, {:.2f} ns batched",
+               scalar_ns,
+               batch_ns);
+}
+TEST(decode, foreign_decoder) {
+  // a decoder outside the table is still asked, after the ones before it
+  struct Nop final : IDecoder {
+    auto decode(uint32_t) -> std::unique_ptr<IInstruction> override {
+      return nullptr;
+    }
+    auto describe(const uint32_t num) const noexcept -> Descriptor override {
+      return num == 0xdeadbeef ? Descriptor{.id = Descriptor::Id::kAdd}
+                               : Descriptor{};
+    }
+  };
+  auto disassembler = createDisassembler();
+  disassembler->initializeDefault();
+  EXPECT_FALSE(disassembler->describe(0xdeadbeef));
+
+  disassembler->addDecoder(std::make_unique<Nop>());
+  EXPECT_EQ(Descriptor::Id::kAdd, disassembler->describe(0xdeadbeef).id);
+  // lui x7, 0x12345
+  EXPECT_EQ(Descriptor::Id::kLui,
+            disassembler->describe((0x12345 << 12) | (7 << 7) | 0x37).id);
+}
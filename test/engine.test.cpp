@@ -0,0 +1,236 @@
+#include "deps.hh"
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+#include "guest.hpp"
+
+using namespace accat::luce;
+using namespace accat::luce::guest;
+
+namespace {
+constexpr auto base = isa::virtual_base_address;
+auto word_at(const Outcome &outcome, const size_t offset) {
+  uint32_t word = 0;
+  std::memcpy(&word, outcome.memory.data() + offset, sizeof(word));
+  return word;
+}
+} // namespace
+
+TEST(engine, block_loop) {
+  const auto words = program({{
+                                  lui(s0, data),       // 0
+                                  addi(t0, zero, 10),  // 1
+                                  addi(a1, zero, 0),   // 2
+                                  add(a1, a1, t0),     // 3: loop
+                                  sw(a1, s0, 0),       // 4
+                                  addi(t0, t0, -1),    // 5
+                                  bne(t0, zero, -12),  // 6: -> 3
+                                  lw(a2, s0, 0),       // 7
+                              },
+                              finish()});
+  for (const auto &options : engines) {
+    const auto outcome = expect_as_step(words, options);
+    EXPECT_EQ(outcome.report.reason, ExitReason::kExited);
+    EXPECT_EQ(outcome.x[a2], 55u);
+  }
+}
+
+TEST(engine, self_modifying_store) {
+  // the loop stores `addi a1, zero, 2` over its own first instruction; every
+  // run of it after the first has to see the new one
+  const auto words = program({{
+                                  lui(s0, data),      // 0
+                                  lui(s1, base),      // 1
+                                  addi(t0, zero, 0),  // 2
+                                  addi(t2, zero, 20), // 3
+                                  addi(a1, zero, 1),  // 4: loop, patched
+                                  add(a2, a2, a1),    // 5
+                                  lw(t1, s1, 56),     // 6: word 14
+                                  sw(t1, s1, 16),     // 7: over word 4
+                                  addi(t0, t0, 1),    // 8
+                                  bne(t0, t2, -20),   // 9: -> 4
+                                  sw(a2, s0, 0),      // 10
+                              },
+                              finish(),              // 11..13
+                              {addi(a1, zero, 2)}}); // 14
+  for (const auto &options : engines) {
+    const auto outcome = expect_as_step(words, options);
+    EXPECT_EQ(outcome.report.reason, ExitReason::kExited);
+    EXPECT_EQ(word_at(outcome, 0), 1u + 19 * 2);
+  }
+}
+
+TEST(engine, jit_loads_and_stores) {
+  // stores the jit makes itself, loads of what it stored, and a loop hot
+  // enough to be compiled on its second visit
+  const auto words = program({{
+                                  lui(s0, data),       // 0
+                                  addi(t0, zero, 0),   // 1
+                                  addi(t2, zero, 12),  // 2
+                                  sw(t0, s0, 4),       // 3: loop
+                                  lw(a1, s0, 4),       // 4
+                                  add(a2, a2, a1),     // 5
+                                  sw(a2, s0, 0),       // 6
+                                  addi(t0, t0, 1),     // 7
+                                  blt(t0, t2, -20),    // 8: -> 3
+                                  lw(a3, s0, 0),       // 9
+                              },
+                              finish()});
+  const auto outcome = expect_as_step(words, engines[2]);
+  EXPECT_EQ(outcome.report.reason, ExitReason::kExited);
+  EXPECT_EQ(outcome.x[a3], 66u);
+  EXPECT_EQ(word_at(outcome, 4), 11u);
+}
+
+TEST(engine, fused_pairs) {
+  const auto words = program({{
+                                  lui(s0, data),           // 0
+                                  lui(a1, 0x12345000),     // 1: li
+                                  addi(a1, a1, 0x678),     // 2
+                                  lui(a4, 0x12346000),     // 3: li, borrows
+                                  addi(a4, a4, -0x800),    // 4
+                                  addi(t0, zero, 0),       // 5
+                                  addi(t2, zero, 12),      // 6
+                                  addi(t0, t0, 1),         // 7: loop
+                                  slt(t1, t0, t2),         // 8: slt + beq
+                                  beq(t1, zero, 12),       // 9: -> 12
+                                  addi(a2, a2, 3),         // 10
+                                  jal(zero, -16),          // 11: -> 7
+                                  sw(a1, s0, 0),           // 12
+                                  sw(a2, s0, 4),           // 13
+                                  sw(a4, s0, 8),           // 14
+                                  addi(a3, a3, 1),         // 15: addi + bne
+                                  bne(a3, t2, -4),         // 16: -> 15
+                                  sw(a3, s0, 12),          // 17
+                              },
+                              finish()});
+  for (const auto &options : engines) {
+    const auto outcome = expect_as_step(words, options);
+    EXPECT_EQ(word_at(outcome, 0), 0x12345678u);
+    EXPECT_EQ(word_at(outcome, 4), 33u);
+    EXPECT_EQ(word_at(outcome, 8), 0x123457ffu);
+    EXPECT_EQ(word_at(outcome, 12), 12u);
+  }
+}
+
+TEST(engine, calls_and_returns) {
+  // `f` is called from two places, one of them through a register, so its
+  // `ret` has more than one target
+  const auto words = program({{
+                                  lui(s0, data),      // 0
+                                  addi(t0, zero, 0),  // 1
+                                  addi(t2, zero, 16), // 2
+                                  jal(ra, 56),        // 3: loop, -> f
+                                  add(a2, a2, a0),    // 4
+                                  jal(ra, 56),        // 5: -> g
+                                  add(a3, a3, a0),    // 6
+                                  addi(t0, t0, 1),    // 7
+                                  bne(t0, t2, -20),   // 8: -> 3
+                                  sw(a2, s0, 0),      // 9
+                                  sw(a3, s0, 4),      // 10
+                                  auipc(t1, 0),       // 11
+                                  jalr(ra, t1, 24),   // 12: -> f
+                                  sw(a0, s0, 8),      // 13
+                              },
+                              finish(), // 14..16
+                              {
+                                  addi(a0, t0, 5), // 17: f
+                                  ret(),           // 18
+                                  add(a0, t0, t0), // 19: g
+                                  ret(),           // 20
+                              }});
+  for (const auto &options : engines) {
+    const auto outcome = expect_as_step(words, options);
+    EXPECT_EQ(outcome.report.reason, ExitReason::kExited);
+    // the sums of t0 + 5 and 2 * t0 over t0 = 0..15
+    EXPECT_EQ(word_at(outcome, 0), 120u + 16 * 5);
+    EXPECT_EQ(word_at(outcome, 4), 240u);
+    EXPECT_EQ(word_at(outcome, 8), 21u);
+  }
+}
+
+TEST(engine, biased_branch) {
+  // the branch goes one way seven times out of eight; a trace recorded along
+  // it has to leave by its side exit on the eighth
+  const auto words = program({{
+                                  lui(s0, data),       // 0
+                                  addi(t0, zero, 0),   // 1
+                                  addi(t2, zero, 100), // 2
+                                  andi(t1, t0, 7),     // 3: loop
+                                  beq(t1, zero, 12),   // 4: -> 7
+                                  addi(a2, a2, 3),     // 5
+                                  jal(zero, 8),        // 6: -> 8
+                                  addi(a3, a3, 1),     // 7
+                                  addi(t0, t0, 1),     // 8
+                                  blt(t0, t2, -24),    // 9: -> 3
+                                  sw(a2, s0, 0),       // 10
+                                  sw(a3, s0, 4),       // 11
+                              },
+                              finish()});
+  for (const auto &options : engines) {
+    const auto outcome = expect_as_step(words, options);
+    EXPECT_EQ(word_at(outcome, 0), 87u * 3);
+    EXPECT_EQ(word_at(outcome, 4), 13u);
+  }
+}
+
+TEST(engine, folded_and_dead_writes) {
+  const auto words = program({{
+                                  lui(s0, data),       // 0
+                                  addi(t0, zero, 0),   // 1
+                                  addi(t2, zero, 20),  // 2
+                                  addi(a1, zero, 5),   // 3: loop, constant
+                                  addi(a1, a1, 3),     // 4: folds to 8
+                                  add(a2, a1, a1),     // 5: dead
+                                  addi(a2, zero, 7),   // 6
+                                  add(a3, a3, a2),     // 7
+                                  addi(zero, a3, 1),   // 8: to x0
+                                  addi(a4, a1, 0),     // 9
+                                  sub(a4, a4, t0),     // 10
+                                  sw(a4, s0, 0),       // 11
+                                  addi(a5, zero, 1),   // 12: dead
+                                  lw(a5, s0, 0),       // 13
+                                  addi(t0, t0, 1),     // 14
+                                  bne(t0, t2, -48),    // 15: -> 3
+                                  sw(a3, s0, 4),       // 16
+                              },
+                              finish()});
+  for (const auto &options : engines) {
+    const auto outcome = expect_as_step(words, options);
+    EXPECT_EQ(outcome.x[zero], 0u);
+    EXPECT_EQ(outcome.x[a1], 8u);
+    EXPECT_EQ(outcome.x[a2], 7u);
+    EXPECT_EQ(outcome.x[a5], 8u - 19);
+    EXPECT_EQ(word_at(outcome, 4), 140u);
+  }
+}
+
+TEST(engine, pc_inside_blocks) {
+  // what reads the pc in the middle of a block, and a trap there, have to see
+  // it where the step engine does
+  const auto words = program({{
+                                  lui(s0, data),      // 0
+                                  addi(t0, zero, 0),  // 1
+                                  addi(t2, zero, 10), // 2
+                                  addi(a1, a1, 1),    // 3: loop
+                                  auipc(a2, 0),       // 4
+                                  add(a3, a3, a2),    // 5
+                                  jal(a4, 8),         // 6: -> 8
+                                  ebreak(),           // 7
+                                  addi(t0, t0, 1),    // 8
+                                  bne(t0, t2, -24),   // 9: -> 3
+                                  sw(a3, s0, 0),      // 10
+                                  addi(a5, zero, 1),  // 11
+                                  addi(a5, a5, 1),    // 12
+                                  ebreak(),           // 13
+                              },
+                              finish()});
+  for (const auto &options : engines) {
+    const auto outcome = expect_as_step(words, options);
+    EXPECT_EQ(outcome.report.reason, ExitReason::kPaused);
+    EXPECT_EQ(outcome.x[a2], base + 16);
+    EXPECT_EQ(outcome.x[a4], base + 28);
+    EXPECT_EQ(word_at(outcome, 0), static_cast<uint32_t>((base + 16) * 10));
+  }
+}
@@ -0,0 +1,247 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "luce/Monitor.hpp"
+#include "luce/Support/isa/architecture.hpp"
+#include "luce/Support/isa/config.hpp"
+#include "luce/Support/isa/riscv32/Disassembler.hpp"
+#include "luce/Support/isa/riscv32/instruction/Atomic.hpp"
+#include "luce/Support/isa/riscv32/instruction/Multiply.hpp"
+
+// guest -- small RV32I programs run through a whole monitor, for the tests
+// that compare one engine against another
+namespace accat::luce::guest {
+enum Reg : uint32_t {
+  zero = 0,
+  ra = 1,
+  sp = 2,
+  t0 = 5,
+  t1 = 6,
+  t2 = 7,
+  s0 = 8,
+  s1 = 9,
+  a0 = 10,
+  a1 = 11,
+  a2 = 12,
+  a3 = 13,
+  a4 = 14,
+  a5 = 15,
+  a7 = 17,
+};
+/// where the programs keep their data, `lui s0, data`
+inline constexpr uint32_t data = isa::physical_base_address + 0x1000;
+inline constexpr uint32_t data_size = 64;
+namespace csr {
+inline constexpr uint32_t cycle = 0xC00;
+inline constexpr uint32_t time = 0xC01;
+inline constexpr uint32_t instret = 0xC02;
+} // namespace csr
+
+constexpr auto r(const uint32_t funct7,
+                 const uint32_t rs2,
+                 const uint32_t rs1,
+                 const uint32_t funct3,
+                 const uint32_t rd,
+                 const uint32_t opcode) -> uint32_t {
+  return funct7 << 25 | rs2 << 20 | rs1 << 15 | funct3 << 12 | rd << 7 | opcode;
+}
+constexpr auto i(const int32_t imm,
+                 const uint32_t rs1,
+                 const uint32_t funct3,
+                 const uint32_t rd,
+                 const uint32_t opcode) -> uint32_t {
+  return (static_cast<uint32_t>(imm) & 0xfff) << 20 | rs1 << 15 |
+         funct3 << 12 | rd << 7 | opcode;
+}
+constexpr auto s(const int32_t imm,
+                 const uint32_t rs2,
+                 const uint32_t rs1,
+                 const uint32_t funct3) -> uint32_t {
+  const auto u = static_cast<uint32_t>(imm);
+  return (u >> 5 & 0x7f) << 25 | rs2 << 20 | rs1 << 15 | funct3 << 12 |
+         (u & 0x1f) << 7 | 0x23;
+}
+/// @param offset in bytes, from the branch itself
+constexpr auto b(const int32_t offset,
+                 const uint32_t rs2,
+                 const uint32_t rs1,
+                 const uint32_t funct3) -> uint32_t {
+  const auto u = static_cast<uint32_t>(offset);
+  return (u >> 12 & 1) << 31 | (u >> 5 & 0x3f) << 25 | rs2 << 20 |
+         rs1 << 15 | funct3 << 12 | (u >> 1 & 0xf) << 8 | (u >> 11 & 1) << 7 |
+         0x63;
+}
+
+constexpr auto add(const uint32_t rd, const uint32_t rs1, const uint32_t rs2) {
+  return r(0, rs2, rs1, 0, rd, 0x33);
+}
+constexpr auto sub(const uint32_t rd, const uint32_t rs1, const uint32_t rs2) {
+  return r(0x20, rs2, rs1, 0, rd, 0x33);
+}
+constexpr auto slt(const uint32_t rd, const uint32_t rs1, const uint32_t rs2) {
+  return r(0, rs2, rs1, 2, rd, 0x33);
+}
+constexpr auto addi(const uint32_t rd, const uint32_t rs1, const int32_t imm) {
+  return i(imm, rs1, 0, rd, 0x13);
+}
+constexpr auto andi(const uint32_t rd, const uint32_t rs1, const int32_t imm) {
+  return i(imm, rs1, 7, rd, 0x13);
+}
+constexpr auto nop() {
+  return addi(zero, zero, 0);
+}
+constexpr auto lw(const uint32_t rd, const uint32_t rs1, const int32_t imm) {
+  return i(imm, rs1, 2, rd, 0x03);
+}
+constexpr auto lbu(const uint32_t rd, const uint32_t rs1, const int32_t imm) {
+  return i(imm, rs1, 4, rd, 0x03);
+}
+constexpr auto sw(const uint32_t rs2, const uint32_t rs1, const int32_t imm) {
+  return s(imm, rs2, rs1, 2);
+}
+constexpr auto beq(const uint32_t rs1, const uint32_t rs2, const int32_t off) {
+  return b(off, rs2, rs1, 0);
+}
+constexpr auto bne(const uint32_t rs1, const uint32_t rs2, const int32_t off) {
+  return b(off, rs2, rs1, 1);
+}
+constexpr auto blt(const uint32_t rs1, const uint32_t rs2, const int32_t off) {
+  return b(off, rs2, rs1, 4);
+}
+/// @param imm the upper 20 bits, in place
+constexpr auto lui(const uint32_t rd, const uint32_t imm) {
+  return (imm & 0xfffff000) | rd << 7 | 0x37;
+}
+constexpr auto auipc(const uint32_t rd, const uint32_t imm) {
+  return (imm & 0xfffff000) | rd << 7 | 0x17;
+}
+constexpr auto jal(const uint32_t rd, const int32_t offset) {
+  const auto u = static_cast<uint32_t>(offset);
+  return (u >> 20 & 1) << 31 | (u >> 1 & 0x3ff) << 21 | (u >> 11 & 1) << 20 |
+         (u >> 12 & 0xff) << 12 | rd << 7 | 0x6f;
+}
+constexpr auto jalr(const uint32_t rd, const uint32_t rs1, const int32_t imm) {
+  return i(imm, rs1, 0, rd, 0x67);
+}
+constexpr auto ret() {
+  return jalr(zero, ra, 0);
+}
+constexpr auto csrr(const uint32_t rd, const uint32_t csr) {
+  return i(static_cast<int32_t>(csr), zero, 2, rd, 0x73);
+}
+constexpr auto ecall() -> uint32_t {
+  return 0x00000073;
+}
+constexpr auto ebreak() -> uint32_t {
+  return 0x00100073;
+}
+/// `exit(0)`, three instructions
+inline auto finish() -> std::vector<uint32_t> {
+  return {addi(a7, zero, 93), addi(a0, zero, 0), ecall()};
+}
+inline auto program(std::initializer_list<std::vector<uint32_t>> parts) {
+  std::vector<uint32_t> words;
+  for (const auto &part : parts)
+    words.insert(words.end(), part.begin(), part.end());
+  return words;
+}
+
+/// what a run left behind
+struct Outcome {
+  std::array<uint32_t, isa::general_purpose_register_count> x{};
+  uint32_t pc = 0;
+  /// the `data_size` bytes at `data`
+  std::vector<std::byte> memory;
+  Monitor::RunReport report;
+  auxilia::Status status;
+  /// what the engines of the cpu counted
+  std::string statistics;
+};
+/// the options of the command line, as the driver passes them on; empty ones
+/// are left as they are
+struct Options {
+  std::string_view engine = "step";
+  std::string_view jit_threshold;
+  std::string_view icount;
+  std::string_view lockstep;
+  std::string_view hle;
+  std::string_view instruction_limit;
+  std::string_view timeout;
+};
+inline auto run(const std::vector<uint32_t> &words, const Options &options = {})
+    -> Outcome {
+  auto disassembler = std::make_shared<isa::Disassembler>();
+  disassembler->initializeDefault();
+  if constexpr (LUCE_EXTENSION_M)
+    disassembler->addDecoder(
+        std::make_unique<isa::instruction::multiply::Decoder>());
+  if constexpr (LUCE_EXTENSION_A)
+    disassembler->addDecoder(
+        std::make_unique<isa::instruction::atomic::Decoder>());
+  Monitor monitor{std::move(disassembler)};
+
+  std::vector<std::byte> bytes(words.size() * sizeof(uint32_t));
+  std::memcpy(bytes.data(), words.data(), bytes.size());
+  Outcome outcome;
+  outcome.status =
+      monitor.register_task(bytes, isa::virtual_base_address, 0x10000);
+  for (const auto [setter, value] :
+       {std::pair{&Monitor::select_engine, options.engine},
+        std::pair{&Monitor::set_jit_threshold, options.jit_threshold},
+        std::pair{&Monitor::set_icount, options.icount},
+        std::pair{&Monitor::set_lockstep, options.lockstep},
+        std::pair{&Monitor::set_hle, options.hle},
+        std::pair{&Monitor::set_instruction_limit, options.instruction_limit},
+        std::pair{&Monitor::set_timeout, options.timeout}}) {
+    if (!outcome.status)
+      return outcome;
+    if (!value.empty())
+      outcome.status = (monitor.*setter)(value);
+  }
+  if (!outcome.status)
+    return outcome;
+
+  outcome.status = monitor.run();
+  outcome.report = monitor.report();
+  for (size_t i = 0; i < outcome.x.size(); ++i)
+    outcome.x[i] = monitor.registers()[i];
+  outcome.pc = monitor.cpus().pc().num();
+  outcome.statistics = monitor.cpus().statistics();
+  if (const auto memory = monitor.memory().read_n(data, data_size))
+    outcome.memory.assign(memory->begin(), memory->end());
+  return outcome;
+}
+/// @brief run @p words under @p options and under `--engine step`, and expect
+/// the same registers, memory, pc and instructions retired of both.
+inline auto expect_as_step(const std::vector<uint32_t> &words,
+                           const Options &options) -> Outcome {
+  SCOPED_TRACE(options.engine);
+  const auto reference = run(words);
+  auto outcome = run(words, options);
+  EXPECT_TRUE(reference.status) << reference.status.message();
+  EXPECT_TRUE(outcome.status) << outcome.status.message();
+  for (size_t i = 0; i < outcome.x.size(); ++i)
+    EXPECT_EQ(outcome.x[i], reference.x[i]) << "x" << i;
+  EXPECT_EQ(outcome.pc, reference.pc);
+  EXPECT_EQ(outcome.memory, reference.memory);
+  EXPECT_EQ(outcome.report.reason, reference.report.reason);
+  EXPECT_EQ(outcome.report.instructions, reference.report.instructions);
+  return outcome;
+}
+/// the engines that have something to compare against the step one
+inline constexpr std::array<Options, 3> engines{
+    Options{.engine = "block"},
+    Options{.engine = "threaded"},
+    Options{.engine = "jit", .jit_threshold = "1"},
+};
+} // namespace accat::luce::guest
@@ -0,0 +1,59 @@
+#include "deps.hh"
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+#include "luce/cpu/hle.hpp"
+
+using namespace accat::luce;
+
+namespace {
+constexpr auto base = isa::virtual_base_address;
+auto text_of(const std::vector<uint32_t> &words) {
+  std::vector<std::byte> bytes(words.size() * sizeof(uint32_t));
+  std::memcpy(bytes.data(), words.data(), bytes.size());
+  return bytes;
+}
+} // namespace
+
+TEST(hle, parse_bindings) {
+  const auto bindings =
+      hle::parse("memcpy@0x80000120,strlen=9305??00,memset@80000200");
+  ASSERT_TRUE(bindings);
+  ASSERT_EQ(bindings->size(), 3u);
+
+  EXPECT_EQ((*bindings)[0].routine, hle::Routine::kMemcpy);
+  EXPECT_EQ((*bindings)[0].address, 0x80000120u);
+  EXPECT_EQ((*bindings)[1].routine, hle::Routine::kStrlen);
+  EXPECT_FALSE((*bindings)[1].address);
+  ASSERT_EQ((*bindings)[1].fingerprint.size(), 4u);
+  EXPECT_EQ((*bindings)[1].fingerprint[0], std::byte{0x93});
+  EXPECT_FALSE((*bindings)[1].fingerprint[2]);
+  EXPECT_EQ((*bindings)[2].address, 0x80000200u);
+}
+
+TEST(hle, parse_rejects) {
+  EXPECT_FALSE(hle::parse("memmove@0x80000120"));
+  EXPECT_FALSE(hle::parse("memcpy"));
+  EXPECT_FALSE(hle::parse("memcpy@"));
+  EXPECT_FALSE(hle::parse("strlen=930"));
+  EXPECT_FALSE(hle::parse("strlen=93zz"));
+  EXPECT_TRUE(hle::parse(""));
+}
+
+TEST(hle, entries_in_text) {
+  // nop; mv a1, a0; lbu a5, 0(a1); ret
+  const auto text = text_of({0x00000013, 0x00050593, 0x0005c783, 0x00008067});
+  const auto bindings = hle::parse("strlen=93050500,memcpy@0x8000000c,"
+                                   "memset@0x80000010,memcmp=ffffffff");
+  ASSERT_TRUE(bindings);
+
+  HighLevelEmulation hle;
+  hle.bind(*bindings).reset(text, base);
+  EXPECT_FALSE(hle.covers(base));
+  EXPECT_TRUE(hle.covers(base + 4));
+  EXPECT_TRUE(hle.covers(base + 12));
+  // past the text, and nowhere to be found
+  EXPECT_FALSE(hle.covers(base + 16));
+}
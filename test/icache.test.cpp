@@ -0,0 +1,109 @@
+#include "deps.hh"
+#include <gtest/gtest.h>
+
+#include "luce/cpu/block.hpp"
+#include "luce/cpu/icache.hpp"
+#include "luce/Support/isa/riscv32/Disassembler.hpp"
+
+using namespace accat::luce;
+
+namespace {
+// addi x5, x5, 1
+constexpr uint32_t addi = 0x00128293;
+constexpr auto base = isa::virtual_base_address;
+
+auto decode(const uint32_t num) {
+  static auto disassembler = [] {
+    auto disasm = std::make_unique<isa::Disassembler>();
+    disasm->initializeDefault();
+    return disasm;
+  }();
+  return disassembler->disassemble(num);
+}
+auto block_of(const isa::virtual_address_t start, const size_t size) {
+  auto block = std::make_unique<BasicBlock>(start);
+  for (size_t i = 0; i < size; ++i)
+    block->instructions.push_back(decode(addi));
+  block->end = static_cast<isa::virtual_address_t>(start + size * 4);
+  return block;
+}
+} // namespace
+
+TEST(icache, hit_after_insert) {
+  InstructionCache icache;
+  icache.reset(base, base + 0x10);
+
+  EXPECT_EQ(icache.lookup(base + 4), nullptr);
+  ASSERT_TRUE(icache.covers(base + 4));
+  icache.insert(base + 4, decode(addi));
+
+  auto inst = icache.lookup(base + 4);
+  ASSERT_NE(inst, nullptr);
+  EXPECT_EQ(inst->num(), addi);
+  EXPECT_EQ(icache.statistics().hits, 1u);
+  EXPECT_EQ(icache.statistics().misses, 1u);
+}
+
+TEST(icache, outside_text_segment) {
+  InstructionCache icache;
+  icache.reset(base, base + 0x10);
+
+  EXPECT_FALSE(icache.covers(base - 4));
+  EXPECT_FALSE(icache.covers(base + 0x10));
+  EXPECT_FALSE(icache.covers(base + 2)); // misaligned
+  EXPECT_EQ(icache.lookup(base + 0x10), nullptr);
+}
+
+TEST(icache, invalidate_overlapping_bytes) {
+  InstructionCache icache;
+  icache.reset(base, base + 0x10);
+  for (auto pc = base; pc < base + 0x10; pc += 4)
+    icache.insert(pc, decode(addi));
+
+  // a single byte write into the middle of the second instruction
+  icache.invalidate(base + 6, 1);
+  EXPECT_NE(icache.lookup(base), nullptr);
+  EXPECT_EQ(icache.lookup(base + 4), nullptr);
+  EXPECT_NE(icache.lookup(base + 8), nullptr);
+
+  // a word write straddling the third and the fourth instruction
+  icache.invalidate(base + 10, 4);
+  EXPECT_EQ(icache.lookup(base + 8), nullptr);
+  EXPECT_EQ(icache.lookup(base + 12), nullptr);
+  EXPECT_EQ(icache.statistics().invalidations, 3u);
+}
+
+TEST(bcache, retranslated_block_leaves_old_pages) {
+  BlockCache bcache;
+  // across the first page boundary
+  const auto start = base + isa::page_size - 8;
+  bcache.insert(block_of(start, 4));
+
+  bcache.invalidate(start, 4);
+  EXPECT_EQ(bcache.lookup(start), nullptr);
+  // shorter this time, within the first page
+  bcache.insert(block_of(start, 2));
+  bcache.invalidate(base + isa::page_size, 4);
+  EXPECT_NE(bcache.lookup(start), nullptr);
+
+  bcache.invalidate(start + 4, 4);
+  EXPECT_EQ(bcache.lookup(start), nullptr);
+  EXPECT_EQ(bcache.statistics().invalidations, 2u);
+  bcache.collect();
+}
+
+TEST(bcache, collect_hands_over_dropped_blocks) {
+  // the jit frees what it compiled for a block only once it learns of it
+  BlockCache bcache;
+  bcache.insert(block_of(base, 2));
+  bcache.insert(block_of(base + isa::page_size, 2));
+  bcache.invalidate(base, 4);
+
+  std::vector<isa::virtual_address_t> released;
+  bcache.collect(
+      [&](const BasicBlock &block) { released.push_back(block.start); });
+  EXPECT_EQ(released, std::vector{base});
+  // freed already
+  bcache.collect([&](const BasicBlock &) { FAIL(); });
+  EXPECT_NE(bcache.lookup(base + isa::page_size), nullptr);
+}
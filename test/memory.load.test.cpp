@@ -30,3 +30,29 @@ TEST(load_program, bytes) {
                fmt::join(littleEndianData, " "),
                fmt::join(readData, " "));
 }
+TEST(mirror, bytes) {
+  MainMemory memory{nullptr};
+  MainMemory shadow{nullptr};
+  memory.fill(isa::physical_base_address + isa::page_size - 2, 4, 0xab);
+  shadow.mirror(memory);
+
+  EXPECT_EQ(memory.page_count(), isa::physical_memory_size / isa::page_size);
+  for (const auto page : {0ull, 1ull}) {
+    EXPECT_TRUE(std::ranges::equal(memory.page(page), shadow.page(page)));
+    EXPECT_EQ(memory.page(page).size(), isa::page_size);
+  }
+  EXPECT_EQ(*shadow.read(isa::physical_base_address + isa::page_size),
+            std::byte{0xab});
+}
+TEST(range, last_bytes) {
+  MainMemory memory{nullptr};
+  constexpr auto last = isa::physical_memory_end;
+  EXPECT_TRUE(memory.read(last));
+  EXPECT_FALSE(memory.read(last + 1));
+  EXPECT_FALSE(memory.read(isa::physical_memory_begin - 1));
+  // a word ending on the last byte, and one past it
+  EXPECT_TRUE(memory.read_n(last - 3, 4));
+  EXPECT_FALSE(memory.read_n(last - 2, 4));
+  EXPECT_TRUE(memory.read_n(isa::physical_memory_begin,
+                            isa::physical_memory_size));
+}
@@ -0,0 +1,163 @@
+#include "deps.hh"
+#include <gtest/gtest.h>
+
+#include "guest.hpp"
+
+using namespace accat::luce;
+using namespace accat::luce::guest;
+
+TEST(idle, spin_in_place) {
+  // j .
+  const auto words = program({{jal(zero, 0)}});
+  for (const auto engine : {"step", "block", "jit"}) {
+    SCOPED_TRACE(engine);
+    const auto outcome = run(words, {.engine = engine, .jit_threshold = "1"});
+    ASSERT_TRUE(outcome.status) << outcome.status.message();
+    EXPECT_EQ(outcome.report.reason, ExitReason::kIdle);
+    EXPECT_EQ(outcome.pc, isa::virtual_base_address);
+  }
+}
+
+TEST(idle, spin_up_to_the_limit) {
+  // nothing would change in the instructions left, so they are not run
+  const auto outcome = run(program({{jal(zero, 0)}}),
+                           {.instruction_limit = "1000000000000"});
+  ASSERT_TRUE(outcome.status) << outcome.status.message();
+  EXPECT_EQ(outcome.report.reason, ExitReason::kInstructionLimit);
+  EXPECT_EQ(outcome.report.instructions, 1000000000000u);
+}
+
+TEST(idle, store_loop_is_busy) {
+  // every turn writes memory, so it is not the hart waiting
+  const auto words = program({{
+      lui(s0, data),   // 0
+      sw(zero, s0, 0), // 1: loop
+      jal(zero, -4),   // 2: -> 1
+  }});
+  for (const auto engine : {"step", "block", "jit"}) {
+    SCOPED_TRACE(engine);
+    const auto outcome =
+        run(words, {.engine = engine, .jit_threshold = "1", .timeout = "0.2"});
+    ASSERT_TRUE(outcome.status) << outcome.status.message();
+    EXPECT_EQ(outcome.report.reason, ExitReason::kTimeout);
+  }
+}
+
+TEST(idle, counting_loop_is_busy) {
+  // no state comes back within a probe
+  const auto words = program({{
+      addi(t0, t0, 1), // 0: loop
+      jal(zero, -4),   // 1: -> 0
+  }});
+  const auto outcome = run(words, {.timeout = "0.2"});
+  ASSERT_TRUE(outcome.status) << outcome.status.message();
+  EXPECT_EQ(outcome.report.reason, ExitReason::kTimeout);
+}
+
+TEST(icount, counters_follow_instret) {
+  // under a shift of 2 every instruction takes 4 ns; each read sees the
+  // instructions before it
+  const auto words = program({{
+                                  nop(),                  // 0
+                                  nop(),                  // 1
+                                  nop(),                  // 2
+                                  csrr(a1, csr::time),    // 3
+                                  nop(),                  // 4
+                                  csrr(a2, csr::instret), // 5
+                                  csrr(a3, csr::cycle),   // 6
+                                  addi(t0, zero, 0),      // 7
+                                  addi(t2, zero, 10),     // 8
+                                  addi(t0, t0, 1),        // 9: loop
+                                  bne(t0, t2, -4),        // 10: -> 9
+                                  csrr(a4, csr::time),    // 11
+                                  csrr(a5, csr::instret), // 12
+                              },
+                              finish()});
+  for (const auto engine : {"step", "block", "threaded", "jit"}) {
+    SCOPED_TRACE(engine);
+    const auto outcome =
+        run(words, {.engine = engine, .jit_threshold = "1", .icount = "2"});
+    ASSERT_TRUE(outcome.status) << outcome.status.message();
+    EXPECT_EQ(outcome.x[a1], 3u << 2);
+    EXPECT_EQ(outcome.x[a2], 5u);
+    EXPECT_EQ(outcome.x[a3], 6u);
+    // 9 before the loop, 20 in it
+    EXPECT_EQ(outcome.x[a4], 29u << 2);
+    EXPECT_EQ(outcome.x[a5], 30u);
+  }
+}
+
+TEST(lockstep, host_time_diverges) {
+  // the reference path reads the host clock a little later, every time
+  const auto words = program({{
+                                  addi(t0, zero, 0),   // 0
+                                  addi(t2, zero, 8),   // 1
+                                  csrr(a1, csr::time), // 2: loop
+                                  add(a2, a2, a1),     // 3
+                                  addi(t0, t0, 1),     // 4
+                                  bne(t0, t2, -12),    // 5: -> 2
+                              },
+                              finish()});
+  const auto outcome =
+      run(words, {.engine = "block", .lockstep = "instruction"});
+  EXPECT_FALSE(outcome.status);
+  EXPECT_EQ(outcome.report.reason, ExitReason::kError);
+}
+
+TEST(lockstep, guest_time_agrees) {
+  const auto words = program({{
+                                  addi(t0, zero, 0),   // 0
+                                  addi(t2, zero, 8),   // 1
+                                  csrr(a1, csr::time), // 2: loop
+                                  add(a2, a2, a1),     // 3
+                                  addi(t0, t0, 1),     // 4
+                                  bne(t0, t2, -12),    // 5: -> 2
+                              },
+                              finish()});
+  for (const auto granularity : {"block", "instruction"}) {
+    SCOPED_TRACE(granularity);
+    const auto outcome =
+        run(words, {.engine = "block", .icount = "0", .lockstep = granularity});
+    ASSERT_TRUE(outcome.status) << outcome.status.message();
+    EXPECT_EQ(outcome.report.reason, ExitReason::kExited);
+  }
+}
+
+TEST(lockstep, routines_bound_by_fingerprint) {
+  // the reference finds `strlen` by its first instruction as the engine does,
+  // and runs it natively too
+  const auto words = program({{
+                                  lui(s0, data),          // 0
+                                  lui(t0, 0x64636000),    // 1: "abcd"
+                                  addi(t0, t0, 0x261),    // 2
+                                  sw(t0, s0, 0),          // 3
+                                  lui(t0, 0x6000),        // 4: "ef"
+                                  addi(t0, t0, 0x665),    // 5
+                                  sw(t0, s0, 4),          // 6
+                                  addi(a0, s0, 0),        // 7
+                                  jal(ra, 20),            // 8: -> strlen
+                                  sw(a0, s0, 8),          // 9
+                              },
+                              finish(), // 10..12
+                              {
+                                  addi(a1, a0, 0),   // 13: strlen
+                                  lbu(a2, a1, 0),    // 14
+                                  beq(a2, zero, 12), // 15: -> 18
+                                  addi(a1, a1, 1),   // 16
+                                  jal(zero, -12),    // 17: -> 14
+                                  sub(a0, a1, a0),   // 18
+                                  ret(),             // 19
+                              }});
+  for (const auto granularity : {"block", "instruction"}) {
+    SCOPED_TRACE(granularity);
+    const auto outcome = run(words,
+                             {.engine = "block",
+                              .lockstep = granularity,
+                              .hle = "strlen=93050500"});
+    ASSERT_TRUE(outcome.status) << outcome.status.message();
+    EXPECT_EQ(outcome.report.reason, ExitReason::kExited);
+    EXPECT_EQ(outcome.memory[8], std::byte{6});
+    // the call, not the loop
+    EXPECT_EQ(outcome.report.instructions, 10u + 1 + 3);
+  }
+}
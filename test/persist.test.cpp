@@ -0,0 +1,74 @@
+#include "deps.hh"
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+#include "luce/cpu/persist.hpp"
+
+using namespace accat::luce;
+
+namespace {
+auto text_of(const std::vector<uint32_t> &words) {
+  std::vector<std::byte> bytes(words.size() * sizeof(uint32_t));
+  std::memcpy(bytes.data(), words.data(), bytes.size());
+  return bytes;
+}
+auto scratch() {
+  const auto directory =
+      std::filesystem::temp_directory_path() / "luce-persist-test";
+  std::filesystem::remove_all(directory);
+  std::filesystem::create_directories(directory);
+  return directory;
+}
+} // namespace
+
+TEST(persist, round_trip) {
+  const auto directory = scratch();
+  // addi a0, a0, 1; ret
+  const auto text = text_of({0x00150513, 0x00008067});
+  const auto descriptors = std::vector<isa::Descriptor>{
+      {.id = isa::Descriptor::Id::kAddi, .rd = 10, .rs1 = 10, .imm = 1},
+      {.id = isa::Descriptor::Id::kJalr, .rs1 = 1}};
+  const auto profiles = std::vector<PersistentCache::Profile>{
+      {.start = 0x80000000, .end = 0x80000008, .executions = 42}};
+
+  PersistentCache cache;
+  cache.load(directory, text);
+  EXPECT_EQ(cache.statistics().misses, 1u);
+  EXPECT_TRUE(cache.descriptors().empty());
+  ASSERT_TRUE(cache.save(descriptors, profiles));
+
+  PersistentCache warm;
+  warm.load(directory, text);
+  EXPECT_EQ(warm.statistics().hits, 1u);
+  ASSERT_EQ(warm.descriptors().size(), descriptors.size());
+  EXPECT_EQ(warm.descriptors()[0], descriptors[0]);
+  EXPECT_EQ(warm.descriptors()[1], descriptors[1]);
+  EXPECT_EQ(warm.executions(0x80000000), 42u);
+  EXPECT_EQ(warm.executions(0x80000004), 0u);
+  std::filesystem::remove_all(directory);
+}
+
+TEST(persist, other_image_misses) {
+  const auto directory = scratch();
+  const auto text = text_of({0x00150513, 0x00008067});
+  const auto descriptors = std::vector<isa::Descriptor>(2);
+
+  PersistentCache cache;
+  cache.load(directory, text);
+  ASSERT_TRUE(cache.save(descriptors, {}));
+
+  // addi a0, a0, 2; ret
+  PersistentCache other;
+  other.load(directory, text_of({0x00250513, 0x00008067}));
+  EXPECT_EQ(other.statistics().misses, 1u);
+  EXPECT_TRUE(other.descriptors().empty());
+  // nothing to key a file by
+  PersistentCache off;
+  off.load({}, text);
+  EXPECT_TRUE(off.descriptors().empty());
+  EXPECT_TRUE(off.save(descriptors, {}));
+  std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,75 @@
+#include "deps.hh"
+#include <gtest/gtest.h>
+
+#include "luce/Support/utils/Timer.hpp"
+
+using namespace accat::luce;
+
+namespace {
+auto ns(const double count) {
+  return std::chrono::duration<double, std::nano>(count);
+}
+auto in_ns(const LatencyHistogram::duration_type duration) {
+  return std::chrono::duration<double, std::nano>(duration).count();
+}
+} // namespace
+
+TEST(histogram, empty) {
+  const LatencyHistogram histogram;
+  EXPECT_EQ(histogram.count(), 0u);
+  EXPECT_EQ(in_ns(histogram.min()), 0.0);
+  EXPECT_EQ(in_ns(histogram.max()), 0.0);
+  EXPECT_EQ(in_ns(histogram.mean()), 0.0);
+  EXPECT_EQ(in_ns(histogram.percentile(0.5)), 0.0);
+}
+
+TEST(histogram, single_sample) {
+  LatencyHistogram histogram;
+  histogram.record(ns(100));
+  EXPECT_EQ(histogram.count(), 1u);
+  EXPECT_EQ(in_ns(histogram.min()), 100.0);
+  EXPECT_EQ(in_ns(histogram.max()), 100.0);
+  EXPECT_EQ(in_ns(histogram.mean()), 100.0);
+  // the bucket ends at 127 ns, but nothing above 100 was seen
+  for (const auto fraction : {0.0, 0.5, 0.99, 1.0})
+    EXPECT_EQ(in_ns(histogram.percentile(fraction)), 100.0);
+}
+
+TEST(histogram, buckets_and_clamping) {
+  LatencyHistogram histogram;
+  // bucket 0, then [2, 4) and [64, 128) ns
+  histogram.record(-ns(5));
+  histogram.record(ns(3));
+  histogram.record(ns(3));
+  histogram.record(ns(70));
+  EXPECT_EQ(in_ns(histogram.min()), 0.0);
+  EXPECT_EQ(in_ns(histogram.percentile(0.0)), 0.0);
+  EXPECT_EQ(in_ns(histogram.percentile(0.5)), 3.0);
+  EXPECT_EQ(in_ns(histogram.percentile(1.0)), 70.0);
+  // fractions out of [0, 1] are clamped into it
+  EXPECT_EQ(in_ns(histogram.percentile(-1.0)), 0.0);
+  EXPECT_EQ(in_ns(histogram.percentile(2.0)), 70.0);
+}
+
+TEST(histogram, saturated) {
+  LatencyHistogram histogram;
+  histogram.record(ns(1));
+  // past 2^63 ns, into the last bucket
+  histogram.record(ns(1e19));
+  EXPECT_EQ(in_ns(histogram.percentile(0.0)), 1.0);
+  EXPECT_EQ(in_ns(histogram.percentile(1.0)), in_ns(histogram.max()));
+  EXPECT_EQ(in_ns(histogram.max()),
+            static_cast<double>(static_cast<uint64_t>(1e19)));
+}
+
+TEST(timer, sample_every) {
+  auto timer = Timer::Streaming(4);
+  for (int i = 0; i < 10; ++i) {
+    const auto [result, elapsed] = timer.measure([i] { return i; });
+    EXPECT_EQ(result, i);
+    // the calls not sampled read no clock
+    if (i % 4 != 0)
+      EXPECT_EQ(elapsed, Timer::duration_type::zero());
+  }
+  EXPECT_EQ(timer.histogram().count(), 3u);
+}
@@ -0,0 +1,126 @@
+//===------------ luce ahead-of-time translator -----------*- C++ -*-===//
+//
+// Part of the Luce project.
+// Licensed under the Apache License v2.0.
+//
+//===---------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <string_view>
+#include <vector>
+#include <fmt/color.h>
+#include <accat/auxilia/auxilia.hpp>
+
+#include "luce/Image.hpp"
+#include "luce/Support/isa/architecture.hpp"
+#include "luce/cpu/aot.hpp"
+
+namespace accat::luce {
+namespace {
+using vaddr_t = isa::virtual_address_t;
+struct Text {
+  std::vector<std::byte> bytes;
+  vaddr_t base = isa::virtual_base_address;
+};
+auto ReadLittleEndian(const std::span<const std::byte> bytes,
+                      const size_t offset,
+                      const size_t size) -> uint32_t {
+  uint32_t value = 0;
+  for (auto i = size; i-- > 0;)
+    value = value << 8 | static_cast<uint8_t>(bytes[offset + i]);
+  return value;
+}
+/// @brief the memory image of a little-endian ELF32 RISC-V executable: its
+/// loadable segments at their physical addresses, as `objcopy -O binary` lays
+/// them out and the emulator then loads them.
+auto FromElf(const std::span<const std::byte> elf) -> auxilia::StatusOr<Text> {
+  constexpr size_t kHeaderSize = 52;
+  constexpr uint32_t kRiscv = 243;
+  constexpr uint32_t kLoad = 1;
+  if (elf.size() < kHeaderSize || static_cast<uint8_t>(elf[4]) != 1 ||
+      static_cast<uint8_t>(elf[5]) != 1 ||
+      ReadLittleEndian(elf, 18, 2) != kRiscv)
+    return auxilia::InvalidArgumentError(
+        "Not a little-endian ELF32 RISC-V executable");
+
+  const auto phoff = ReadLittleEndian(elf, 28, 4);
+  const auto phentsize = ReadLittleEndian(elf, 42, 2);
+  const auto phnum = ReadLittleEndian(elf, 44, 2);
+  struct Segment {
+    vaddr_t address;
+    std::span<const std::byte> bytes;
+  };
+  std::vector<Segment> segments;
+  for (auto i = 0u; i < phnum; ++i) {
+    const auto header = size_t{phoff} + size_t{i} * phentsize;
+    if (header + 32 > elf.size())
+      return auxilia::InvalidArgumentError("Truncated program header {}", i);
+    const auto offset = ReadLittleEndian(elf, header + 4, 4);
+    const auto filesz = ReadLittleEndian(elf, header + 16, 4);
+    if (ReadLittleEndian(elf, header, 4) != kLoad || filesz == 0)
+      continue;
+    if (size_t{offset} + filesz > elf.size())
+      return auxilia::InvalidArgumentError("Truncated segment {}", i);
+    segments.push_back({ReadLittleEndian(elf, header + 12, 4),
+                        elf.subspan(offset, filesz)});
+  }
+  if (segments.empty())
+    return auxilia::InvalidArgumentError("No loadable segment");
+
+  std::ranges::sort(segments, {}, &Segment::address);
+  Text text{.base = segments.front().address};
+  for (const auto &[address, bytes] : segments) {
+    // gaps between the segments read as zero
+    text.bytes.resize(address - text.base);
+    text.bytes.insert(text.bytes.end(), bytes.begin(), bytes.end());
+  }
+  return text;
+}
+/// @brief a raw image is loaded at the base address as is.
+auto TextOf(const std::span<const std::byte> image) -> auxilia::StatusOr<Text> {
+  if (image.size() >= 4 && static_cast<uint8_t>(image[0]) == 0x7F &&
+      image[1] == std::byte{'E'} && image[2] == std::byte{'L'} &&
+      image[3] == std::byte{'F'})
+    return FromElf(image);
+  return Text{.bytes = {image.begin(), image.end()}};
+}
+auto Translate(const std::string_view input, const std::string_view output)
+    -> auxilia::Status {
+  auto image = Image::FromPath<>(input);
+  if (!image)
+    return image.as_status();
+  auto text = TextOf(image->bytes_view());
+  if (!text)
+    return text.as_status();
+
+  std::ofstream file{std::string{output}, std::ios::trunc};
+  if (!file)
+    return auxilia::InvalidArgumentError("Cannot write to '{}'", output);
+  file << aot::translate(text->bytes, text->base);
+  if (!file.flush())
+    return auxilia::InvalidArgumentError("Failed writing '{}'", output);
+  return {};
+}
+} // namespace
+} // namespace accat::luce
+
+int main(const int argc, const char *const *const argv) {
+  using namespace accat;
+  const auto args = std::span{argv, static_cast<size_t>(argc)};
+  if (args.size() != 4 || std::string_view{args[2]} != "-o") {
+    auxilia::println(stderr,
+                     "usage: luce-aot <image> -o <output.cpp>\n"
+                     "translate the text segment of a raw or ELF image into "
+                     "a C++ translation unit;\nlink it into the emulator and "
+                     "run with `--engine aot`.");
+    return EXIT_FAILURE;
+  }
+  if (auto res = luce::Translate(args[1], args[3]); !res) {
+    auxilia::println(
+        stderr, fg(fmt::color::fire_brick), "Error: {}", res.message());
+    return res.raw_code();
+  }
+  return EXIT_SUCCESS;
+}